@@ -39,6 +39,12 @@
 #include <list>
 #include <set>
 
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 #ifdef HAVE_RULES
 // xml is used for rules
 #include <tinyxml2.h>
@@ -93,6 +99,44 @@ static void AddPathsToSet(const std::string& FileName, std::set<std::string>* se
     set->insert(templist.begin(), templist.end());
 }
 
+static void createDirectory(const std::string &path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0777);
+#endif
+}
+
+/**
+ * The library snapshots are written into the per-user cache directory when
+ * no --cppcheck-build-dir is given. It is created if needed, an empty string
+ * is returned if there is no such directory.
+ */
+static std::string getDefaultSnapshotDir()
+{
+    std::string dir;
+#ifdef _WIN32
+    if (const char *localAppData = std::getenv("LOCALAPPDATA"))
+        dir = Path::fromNativeSeparators(localAppData);
+#else
+    const char *cacheHome = std::getenv("XDG_CACHE_HOME");
+    if (cacheHome && *cacheHome)
+        dir = cacheHome;
+    else if (const char *home = std::getenv("HOME")) {
+        dir = std::string(home) + "/.cache";
+        createDirectory(dir);
+    }
+#endif
+    if (dir.empty())
+        return dir;
+    if (!endsWith(dir, '/'))
+        dir += '/';
+    dir += "cppcheck";
+    createDirectory(dir);
+    return dir;
+}
+
 CmdLineParser::CmdLineParser(Settings *settings)
     : _settings(settings)
     , _showHelp(false)
@@ -116,6 +160,8 @@ bool CmdLineParser::parseFromArgs(int argc, const char* const argv[])
 {
     bool def = false;
     bool maxconfigs = false;
+    std::list<std::string> libraries;
+    bool windowsProject = false;
 
     for (int i = 1; i < argc; i++) {
         if (argv[i][0] == '-') {
@@ -331,6 +377,20 @@ bool CmdLineParser::parseFromArgs(int argc, const char* const argv[])
                 _settings->checkLibrary = true;
             }
 
+            // Threads that run the checks of one file
+            else if (std::strncmp(argv[i], "--check-threads=", 16) == 0) {
+                std::istringstream iss(16+argv[i]);
+                if (!(iss >> _settings->checkThreads)) {
+                    printMessage("cppcheck: argument to '--check-threads=' is not a number.");
+                    return false;
+                }
+
+                if (_settings->checkThreads < 1) {
+                    printMessage("cppcheck: argument to '--check-threads=' must be greater than 0.");
+                    return false;
+                }
+            }
+
             else if (std::strncmp(argv[i], "--enable=", 9) == 0) {
                 const std::string errmsg = _settings->addEnabled(argv[i] + 9);
                 if (!errmsg.empty()) {
@@ -497,20 +557,14 @@ bool CmdLineParser::parseFromArgs(int argc, const char* const argv[])
 
             // --library
             else if (std::strncmp(argv[i], "--library=", 10) == 0) {
-                if (!CppCheckExecutor::tryLoadLibrary(_settings->library, argv[0], argv[i]+10))
-                    return false;
+                libraries.push_back(argv[i]+10);
             }
 
             // --project
             else if (std::strncmp(argv[i], "--project=", 10) == 0) {
                 _settings->project.import(argv[i]+10);
-                if (std::strstr(argv[i], ".sln") || std::strstr(argv[i], ".vcxproj")) {
-                    if (!CppCheckExecutor::tryLoadLibrary(_settings->library, argv[0], "windows.cfg")) {
-                        // This shouldn't happen normally.
-                        printMessage("cppcheck: Failed to load 'windows.cfg'. Your Cppcheck installation is broken. Please re-install.");
-                        return false;
-                    }
-                }
+                if (std::strstr(argv[i], ".sln") || std::strstr(argv[i], ".vcxproj"))
+                    windowsProject = true;
             }
 
             // Report progress
@@ -792,6 +846,19 @@ bool CmdLineParser::parseFromArgs(int argc, const char* const argv[])
         }
     }
 
+    // The libraries are loaded when the snapshot dir is known, so the order
+    // of the options does not matter
+    _settings->library.setSnapshotDir(_settings->buildDir.empty() ? getDefaultSnapshotDir() : _settings->buildDir);
+    for (std::list<std::string>::const_iterator it = libraries.begin(); it != libraries.end(); ++it) {
+        if (!CppCheckExecutor::tryLoadLibrary(_settings->library, argv[0], it->c_str()))
+            return false;
+    }
+    if (windowsProject && !CppCheckExecutor::tryLoadLibrary(_settings->library, argv[0], "windows.cfg")) {
+        // This shouldn't happen normally.
+        printMessage("cppcheck: Failed to load 'windows.cfg'. Your Cppcheck installation is broken. Please re-install.");
+        return false;
+    }
+
     _settings->project.ignorePaths(_ignoredPaths);
 
     if (_settings->force)
@@ -800,10 +867,6 @@ bool CmdLineParser::parseFromArgs(int argc, const char* const argv[])
     else if ((def || _settings->preprocessOnly) && !maxconfigs)
         _settings->maxConfigs = 1U;
 
-    if (_settings->isEnabled(Settings::UNUSED_FUNCTION) && _settings->jobs > 1) {
-        printMessage("cppcheck: unusedFunction check can't be used with '-j' option. Disabling unusedFunction check.");
-    }
-
     if (argc <= 1) {
         _showHelp = true;
         _exitAfterPrint = true;
@@ -841,10 +904,14 @@ void CmdLineParser::printHelp()
               "                         Analysis output directory. Useful for various data.\n"
               "                         Some possible usages are; whole program analysis,\n"
               "                         incremental analysis, distributed analysis.\n"
+              "                         The loaded library configuration is cached there,\n"
+              "                         otherwise in the user cache directory.\n"
               "    --check-config       Check cppcheck configuration. The normal code\n"
               "                         analysis is disabled by this flag.\n"
               "    --check-library      Show information messages when library files have\n"
               "                         incomplete info.\n"
+              "    --check-threads=<n>  Run the checks of each file in <n> threads. Can be\n"
+              "                         combined with -j. Default is 1.\n"
               "    --config-exclude=<dir>\n"
               "                         Path (prefix) to be excluded from configuration\n"
               "                         checking. Preprocessor configurations defined in\n"
@@ -851,6 +851,7 @@ int CppCheckExecutor::check_internal(CppCheck& cppcheck, int /*argc*/, const cha
         for (std::map<std::string, std::size_t>::const_iterator i = _files.begin(); i != _files.end(); ++i)
             fileNames.push_back(i->first);
         AnalyzerInformation::writeFilesTxt(settings.buildDir, fileNames, settings.project.fileSettings);
+        settings.functionSummaries = AnalyzerInformation::loadFunctionSummaries(settings.buildDir);
     }
 
     unsigned int returnValue = 0;
@@ -904,6 +905,8 @@ int CppCheckExecutor::check_internal(CppCheck& cppcheck, int /*argc*/, const cha
         // Multiple processes
         ThreadExecutor executor(_files, settings, *this);
         returnValue = executor.check();
+        if (cppcheck.analyseWholeProgram())
+            returnValue++;
     }
 
     cppcheck.analyseWholeProgram(_settings->buildDir, _files);
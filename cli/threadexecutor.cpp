@@ -18,6 +18,7 @@
 
 #include "threadexecutor.h"
 
+#include "checkunusedfunctions.h"
 #include "config.h"
 #include "cppcheck.h"
 #include "cppcheckexecutor.h"
@@ -31,14 +32,15 @@
 #include <cstring>
 #include <iostream>
 #include <utility>
+#include <vector>
 
 #ifdef __SVR4  // Solaris
 #include <sys/loadavg.h>
 #endif
 #ifdef THREADING_MODEL_FORK
-#include <sys/select.h>
 #include <sys/wait.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #endif
 #ifdef THREADING_MODEL_WIN
@@ -46,9 +48,6 @@
 #include <windows.h>
 #endif
 
-// required for FD_ZERO
-using std::memset;
-
 ThreadExecutor::ThreadExecutor(const std::map<std::string, std::size_t> &files, Settings &settings, ErrorLogger &errorLogger)
     : _files(files), _settings(settings), _errorLogger(errorLogger), _fileCount(0)
       // Not initialized _fileSync, _errorSync, _reportSync
@@ -68,6 +67,27 @@ ThreadExecutor::~ThreadExecutor()
     //dtor
 }
 
+#if defined(THREADING_MODEL_FORK) || defined(THREADING_MODEL_WIN)
+/**
+ * Group the project files that are preprocessed with the same settings.
+ * CppCheck::check() reuses the settings for consecutive files of a group.
+ * @return indexes of the files of each group, the groups are in the order of their first file
+ */
+static std::vector<std::vector<std::size_t> > groupFileSettings(const std::list<ImportProject::FileSettings> &fileSettings)
+{
+    std::vector<std::vector<std::size_t> > groups;
+    std::map<std::string, std::size_t> groupIndex;
+    std::size_t index = 0;
+    for (std::list<ImportProject::FileSettings>::const_iterator it = fileSettings.begin(); it != fileSettings.end(); ++it, ++index) {
+        const std::pair<std::map<std::string, std::size_t>::iterator, bool> group = groupIndex.insert(std::make_pair(it->contextKey(), groups.size()));
+        if (group.second)
+            groups.emplace_back();
+        groups[group.first->second].push_back(index);
+    }
+    return groups;
+}
+#endif
+
 
 ///////////////////////////////////////////////////////////////////////////////
 ////// This code is for platforms that support fork() only ////////////////////
@@ -80,65 +100,74 @@ void ThreadExecutor::addFileContent(const std::string &path, const std::string &
     _fileContents[ path ] = content;
 }
 
-int ThreadExecutor::handleRead(int rpipe, unsigned int &result)
+int ThreadExecutor::handleRead(int rpipe, std::string &buffer, const std::vector<std::size_t> &task, std::size_t &filesDone, std::vector<std::string> &unusedFunctions, unsigned int &result)
 {
-    char type = 0;
-    if (read(rpipe, &type, 1) <= 0) {
-        if (errno == EAGAIN)
-            return 0;
-
-        return -1;
-    }
-
-    if (type != REPORT_OUT && type != REPORT_ERROR && type != REPORT_INFO && type != CHILD_END) {
-        std::cerr << "#### You found a bug from cppcheck.\nThreadExecutor::handleRead error, type was:" << type << std::endl;
-        std::exit(0);
+    // Drain the pipe. A message may be split across reads so the
+    // unparsed tail is kept in the buffer until the rest arrives.
+    bool eof = false;
+    char chunk[65536];
+    for (;;) {
+        const ssize_t n = read(rpipe, chunk, sizeof(chunk));
+        if (n > 0) {
+            buffer.append(chunk, n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            eof = (n == 0 || errno != EAGAIN);
+            break;
+        }
     }
 
-    unsigned int len = 0;
-    if (read(rpipe, &len, sizeof(len)) <= 0) {
-        std::cerr << "#### You found a bug from cppcheck.\nThreadExecutor::handleRead error, type was:" << type << std::endl;
-        std::exit(0);
-    }
+    std::string::size_type pos = 0;
+    int res = 0;
+    while (buffer.size() - pos >= 1 + sizeof(unsigned int)) {
+        const char type = buffer[pos];
+        unsigned int len = 0;
+        std::memcpy(&len, &buffer[pos + 1], sizeof(len));
+        if (buffer.size() - pos - 1 - sizeof(len) < len)
+            break;
+        const char *data = buffer.data() + pos + 1 + sizeof(len);
+        pos += 1 + sizeof(len) + len;
+        res = 1;
+
+        if (type == REPORT_OUT) {
+            _errorLogger.reportOut(std::string(data, len));
+        } else if (type == REPORT_ERROR || type == REPORT_INFO) {
+            ErrorLogger::ErrorMessage msg;
+            if (!msg.deserializeBinary(data, len)) {
+                std::cerr << "#### You found a bug from cppcheck.\nThreadExecutor::handleRead error, invalid message" << std::endl;
+                std::exit(0);
+            }
 
-    // Don't rely on incoming data being null-terminated.
-    // Allocate +1 element and null-terminate the buffer.
-    char *buf = new char[len + 1];
-    const ssize_t readIntoBuf = read(rpipe, buf, len);
-    if (readIntoBuf <= 0) {
-        std::cerr << "#### You found a bug from cppcheck.\nThreadExecutor::handleRead error, type was:" << type << std::endl;
-        std::exit(0);
-    }
-    buf[readIntoBuf] = 0;
-
-    if (type == REPORT_OUT) {
-        _errorLogger.reportOut(buf);
-    } else if (type == REPORT_ERROR || type == REPORT_INFO) {
-        ErrorLogger::ErrorMessage msg;
-        msg.deserialize(buf);
-
-        if (!_settings.nomsg.isSuppressed(msg.toSuppressionsErrorMessage())) {
-            // Alert only about unique errors
-            std::string errmsg = msg.toString(_settings.verbose);
-            if (std::find(_errorList.begin(), _errorList.end(), errmsg) == _errorList.end()) {
-                _errorList.push_back(errmsg);
-                if (type == REPORT_ERROR)
-                    _errorLogger.reportErr(msg);
-                else
-                    _errorLogger.reportInfo(msg);
+            if (!_settings.nomsg.isSuppressed(msg.toSuppressionsErrorMessage())) {
+                // Alert only about unique errors
+                if (_errorList.insert(msg.toString(_settings.verbose)).second) {
+                    if (type == REPORT_ERROR)
+                        _errorLogger.reportErr(msg);
+                    else
+                        _errorLogger.reportInfo(msg);
+                }
             }
+        } else if (type == REPORT_UNUSED_FUNCTIONS) {
+            if (filesDone < task.size())
+                unusedFunctions[task[filesDone]].assign(data, len);
+        } else if (type == FILE_END) {
+            unsigned int fileResult = 0;
+            if (len == sizeof(fileResult))
+                std::memcpy(&fileResult, data, sizeof(fileResult));
+            result += fileResult;
+            ++filesDone;
+        } else if (type == CHILD_END) {
+            buffer.clear();
+            return -1;
+        } else {
+            std::cerr << "#### You found a bug from cppcheck.\nThreadExecutor::handleRead error, type was:" << type << std::endl;
+            std::exit(0);
         }
-    } else if (type == CHILD_END) {
-        std::istringstream iss(buf);
-        unsigned int fileResult = 0;
-        iss >> fileResult;
-        result += fileResult;
-        delete [] buf;
-        return -1;
     }
+    buffer.erase(0, pos);
 
-    delete [] buf;
-    return 1;
+    return eof ? -1 : res;
 }
 
 bool ThreadExecutor::checkLoadAverage(size_t nchildren)
@@ -166,21 +195,50 @@ unsigned int ThreadExecutor::check()
     _fileCount = 0;
     unsigned int result = 0;
 
+    // The files are numbered, first the project files and then the other files
+    std::vector<const ImportProject::FileSettings *> fileSettings;
+    for (std::list<ImportProject::FileSettings>::const_iterator i = _settings.project.fileSettings.begin(); i != _settings.project.fileSettings.end(); ++i)
+        fileSettings.push_back(&*i);
+    std::vector<std::map<std::string, std::size_t>::const_iterator> files;
     std::size_t totalfilesize = 0;
     for (std::map<std::string, std::size_t>::const_iterator i = _files.begin(); i != _files.end(); ++i) {
+        files.push_back(i);
         totalfilesize += i->second;
     }
+    const std::size_t totalfiles = fileSettings.size() + files.size();
+
+    // Each child checks a task. The project files of a task are preprocessed
+    // with the same settings so the child sets them up once. Large groups
+    // are split so all jobs get work.
+    std::vector<std::vector<std::size_t> > tasks;
+    const std::size_t maxTaskSize = std::max<std::size_t>(1, fileSettings.size() / (2 * _settings.jobs));
+    const std::vector<std::vector<std::size_t> > groups = groupFileSettings(_settings.project.fileSettings);
+    for (std::vector<std::vector<std::size_t> >::const_iterator group = groups.begin(); group != groups.end(); ++group) {
+        for (std::size_t i = 0; i < group->size(); i += maxTaskSize)
+            tasks.emplace_back(group->begin() + i, group->begin() + std::min(i + maxTaskSize, group->size()));
+    }
+    for (std::size_t i = 0; i < files.size(); ++i)
+        tasks.push_back(std::vector<std::size_t>(1, fileSettings.size() + i));
+
+    const auto fileName = [&](std::size_t index) -> std::string {
+        if (index < fileSettings.size())
+            return fileSettings[index]->filename + ' ' + fileSettings[index]->cfg;
+        return files[index - fileSettings.size()]->first;
+    };
 
     std::list<int> rpipes;
     std::map<pid_t, std::string> childFile;
-    std::map<int, std::string> pipeFile;
+    std::map<int, pid_t> pipeChild;
+    std::map<int, std::string> pipeBuffer;
+    std::map<int, std::size_t> pipeTask;
+    std::map<int, std::size_t> pipeFilesDone;
+    std::vector<std::string> unusedFunctions(totalfiles);
     std::size_t processedsize = 0;
-    std::map<std::string, std::size_t>::const_iterator iFile = _files.begin();
-    std::list<ImportProject::FileSettings>::const_iterator iFileSettings = _settings.project.fileSettings.begin();
+    std::size_t nextTask = 0;
     for (;;) {
         // Start a new child
         size_t nchildren = rpipes.size();
-        if ((iFile != _files.end() || iFileSettings != _settings.project.fileSettings.end()) && nchildren < _settings.jobs && checkLoadAverage(nchildren)) {
+        if (nextTask < tasks.size() && nchildren < _settings.jobs && checkLoadAverage(nchildren)) {
             int pipes[2];
             if (pipe(pipes) == -1) {
                 std::cerr << "pipe() failed: "<< std::strerror(errno) << std::endl;
@@ -209,71 +267,91 @@ unsigned int ThreadExecutor::check()
 
                 CppCheck fileChecker(*this, false);
                 fileChecker.settings() = _settings;
-                unsigned int resultOfCheck = 0;
-
-                if (iFileSettings != _settings.project.fileSettings.end()) {
-                    resultOfCheck = fileChecker.check(*iFileSettings);
-                } else if (!_fileContents.empty() && _fileContents.find(iFile->first) != _fileContents.end()) {
-                    // File content was given as a string
-                    resultOfCheck = fileChecker.check(iFile->first, _fileContents[ iFile->first ]);
-                } else {
-                    // Read file from a file
-                    resultOfCheck = fileChecker.check(iFile->first);
-                }
 
-                std::ostringstream oss;
-                oss << resultOfCheck;
-                writeToPipe(CHILD_END, oss.str());
+                const std::vector<std::size_t> &task = tasks[nextTask];
+                for (std::vector<std::size_t>::const_iterator index = task.begin(); index != task.end(); ++index) {
+                    unsigned int resultOfCheck = 0;
+                    if (*index < fileSettings.size()) {
+                        resultOfCheck = fileChecker.check(*fileSettings[*index]);
+                    } else {
+                        const std::string &file = files[*index - fileSettings.size()]->first;
+                        const std::map<std::string, std::string>::const_iterator fileContent = _fileContents.find(file);
+                        if (fileContent != _fileContents.end()) {
+                            // File content was given as a string
+                            resultOfCheck = fileChecker.check(file, fileContent->second);
+                        } else {
+                            // Read file from a file
+                            resultOfCheck = fileChecker.check(file);
+                        }
+                    }
+
+                    if (_settings.isEnabled(Settings::UNUSED_FUNCTION) && _settings.buildDir.empty()) {
+                        writeToPipe(REPORT_UNUSED_FUNCTIONS, CheckUnusedFunctions::instance.summary());
+                        CheckUnusedFunctions::clear();
+                    }
+                    writeToPipe(FILE_END, std::string(reinterpret_cast<const char *>(&resultOfCheck), sizeof(resultOfCheck)));
+                }
+                writeToPipe(CHILD_END, emptyString);
                 std::exit(0);
             }
 
             close(pipes[1]);
             rpipes.push_back(pipes[0]);
-            if (iFileSettings != _settings.project.fileSettings.end()) {
-                childFile[pid] = iFileSettings->filename + ' ' + iFileSettings->cfg;
-                pipeFile[pipes[0]] = iFileSettings->filename + ' ' + iFileSettings->cfg;
-                ++iFileSettings;
-            } else {
-                childFile[pid] = iFile->first;
-                pipeFile[pipes[0]] = iFile->first;
-                ++iFile;
-            }
+            pipeChild[pipes[0]] = pid;
+            pipeTask[pipes[0]] = nextTask;
+            pipeFilesDone[pipes[0]] = 0;
+            childFile[pid] = fileName(tasks[nextTask].front());
+            ++nextTask;
         } else if (!rpipes.empty()) {
-            fd_set rfds;
-            FD_ZERO(&rfds);
-            for (std::list<int>::const_iterator rp = rpipes.begin(); rp != rpipes.end(); ++rp)
-                FD_SET(*rp, &rfds);
-            struct timeval tv; // for every second polling of load average condition
-            tv.tv_sec = 1;
-            tv.tv_usec = 0;
-            int r = select(*std::max_element(rpipes.begin(), rpipes.end()) + 1, &rfds, nullptr, nullptr, &tv);
+            std::vector<struct pollfd> pfds(rpipes.size());
+            std::size_t i = 0;
+            for (std::list<int>::const_iterator rp = rpipes.begin(); rp != rpipes.end(); ++rp, ++i) {
+                pfds[i].fd = *rp;
+                pfds[i].events = POLLIN;
+                pfds[i].revents = 0;
+            }
+            // wake up every second for polling of load average condition
+            const int r = poll(pfds.data(), pfds.size(), 1000);
 
             if (r > 0) {
                 std::list<int>::iterator rp = rpipes.begin();
-                while (rp != rpipes.end()) {
-                    if (FD_ISSET(*rp, &rfds)) {
-                        int readRes = handleRead(*rp, result);
-                        if (readRes == -1) {
-                            std::size_t size = 0;
-                            std::map<int, std::string>::iterator p = pipeFile.find(*rp);
-                            if (p != pipeFile.end()) {
-                                std::string name = p->second;
-                                pipeFile.erase(p);
-                                std::map<std::string, std::size_t>::const_iterator fs = _files.find(name);
-                                if (fs != _files.end()) {
-                                    size = fs->second;
-                                }
-                            }
-
-                            _fileCount++;
-                            processedsize += size;
-                            if (!_settings.quiet)
-                                CppCheckExecutor::reportStatus(_fileCount, _files.size() + _settings.project.fileSettings.size(), processedsize, totalfilesize);
-
-                            close(*rp);
-                            rp = rpipes.erase(rp);
-                        } else
-                            ++rp;
+                for (i = 0; i < pfds.size(); ++i) {
+                    if (pfds[i].revents == 0) {
+                        ++rp;
+                        continue;
+                    }
+                    const std::vector<std::size_t> &task = tasks[pipeTask[*rp]];
+                    std::size_t &filesDone = pipeFilesDone[*rp];
+                    const std::size_t filesDoneBefore = filesDone;
+                    const int readRes = handleRead(*rp, pipeBuffer[*rp], task, filesDone, unusedFunctions, result);
+                    if (filesDone > filesDoneBefore && filesDone < task.size())
+                        childFile[pipeChild[*rp]] = fileName(task[filesDone]);
+
+                    // A child that crashed did not finish the file it was checking,
+                    // the crash is reported for that file
+                    const bool crashed = (readRes == -1 && filesDone < task.size());
+                    const std::size_t filesEnd = crashed ? (filesDone + 1) : filesDone;
+                    for (std::size_t f = filesDoneBefore; f < filesEnd; ++f) {
+                        if (task[f] >= fileSettings.size())
+                            processedsize += files[task[f] - fileSettings.size()]->second;
+                        _fileCount++;
+                        if (!_settings.quiet)
+                            CppCheckExecutor::reportStatus(_fileCount, totalfiles, processedsize, totalfilesize);
+                    }
+
+                    // The files after it are checked by a new child
+                    if (crashed && filesEnd < task.size()) {
+                        const std::vector<std::size_t> rest(task.begin() + filesEnd, task.end());
+                        tasks.push_back(rest);
+                    }
+
+                    if (readRes == -1) {
+                        pipeBuffer.erase(*rp);
+                        pipeChild.erase(*rp);
+                        pipeTask.erase(*rp);
+                        pipeFilesDone.erase(*rp);
+                        close(*rp);
+                        rp = rpipes.erase(rp);
                     } else
                         ++rp;
                 }
@@ -312,25 +390,37 @@ unsigned int ThreadExecutor::check()
         }
     }
 
+    // Add the function declarations and calls of the files in the order
+    // they are checked without -j so the same function location is reported
+    for (std::vector<std::string>::const_iterator it = unusedFunctions.begin(); it != unusedFunctions.end(); ++it)
+        CheckUnusedFunctions::instance.addSummary(*it);
 
     return result;
 }
 
 void ThreadExecutor::writeToPipe(PipeSignal type, const std::string &data)
 {
-    unsigned int len = static_cast<unsigned int>(data.length() + 1);
-    char *out = new char[ len + 1 + sizeof(len)];
-    out[0] = static_cast<char>(type);
-    std::memcpy(&(out[1]), &len, sizeof(len));
-    std::memcpy(&(out[1+sizeof(len)]), data.c_str(), len);
-    if (write(_wpipe, out, len + 1 + sizeof(len)) <= 0) {
-        delete [] out;
-        out = nullptr;
-        std::cerr << "#### ThreadExecutor::writeToPipe, Failed to write to pipe" << std::endl;
-        std::exit(0);
+    // The message is written at once so the parent never waits for the rest
+    // of a message. It is not held back, the parent gets it even if the
+    // child crashes later.
+    const unsigned int len = static_cast<unsigned int>(data.length());
+    std::string message(1 + sizeof(len), static_cast<char>(type));
+    std::memcpy(&message[1], &len, sizeof(len));
+    message += data;
+
+    const char *p = message.data();
+    std::size_t remaining = message.size();
+    while (remaining > 0) {
+        const ssize_t n = write(_wpipe, p, remaining);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            std::cerr << "#### ThreadExecutor::writeToPipe, Failed to write to pipe" << std::endl;
+            std::exit(0);
+        }
+        p += n;
+        remaining -= n;
     }
-
-    delete [] out;
 }
 
 void ThreadExecutor::reportOut(const std::string &outmsg)
@@ -340,12 +430,16 @@ void ThreadExecutor::reportOut(const std::string &outmsg)
 
 void ThreadExecutor::reportErr(const ErrorLogger::ErrorMessage &msg)
 {
-    writeToPipe(REPORT_ERROR, msg.serialize());
+    std::string data;
+    msg.serializeBinary(data);
+    writeToPipe(REPORT_ERROR, data);
 }
 
 void ThreadExecutor::reportInfo(const ErrorLogger::ErrorMessage &msg)
 {
-    writeToPipe(REPORT_INFO, msg.serialize());
+    std::string data;
+    msg.serializeBinary(data);
+    writeToPipe(REPORT_INFO, data);
 }
 
 #elif defined(THREADING_MODEL_WIN)
@@ -359,8 +453,20 @@ unsigned int ThreadExecutor::check()
 {
     HANDLE *threadHandles = new HANDLE[_settings.jobs];
 
+    // Files that are preprocessed with the same settings are checked one
+    // after the other so the threads can reuse the settings
+    std::vector<const ImportProject::FileSettings *> fileSettings;
+    for (std::list<ImportProject::FileSettings>::const_iterator i = _settings.project.fileSettings.begin(); i != _settings.project.fileSettings.end(); ++i)
+        fileSettings.push_back(&*i);
+    const std::vector<std::vector<std::size_t> > groups = groupFileSettings(_settings.project.fileSettings);
+    _fileSettings.clear();
+    for (std::vector<std::vector<std::size_t> >::const_iterator group = groups.begin(); group != groups.end(); ++group) {
+        for (std::vector<std::size_t>::const_iterator index = group->begin(); index != group->end(); ++index)
+            _fileSettings.push_back(fileSettings[*index]);
+    }
+
     _itNextFile = _files.begin();
-    _itNextFileSettings = _settings.project.fileSettings.begin();
+    _itNextFileSettings = _fileSettings.begin();
 
     _processedFiles = 0;
     _processedSize = 0;
@@ -425,7 +531,7 @@ unsigned int __stdcall ThreadExecutor::threadProc(void *args)
 
     ThreadExecutor *threadExecutor = static_cast<ThreadExecutor*>(args);
     std::map<std::string, std::size_t>::const_iterator &itFile = threadExecutor->_itNextFile;
-    std::list<ImportProject::FileSettings>::const_iterator &itFileSettings = threadExecutor->_itNextFileSettings;
+    std::vector<const ImportProject::FileSettings *>::const_iterator &itFileSettings = threadExecutor->_itNextFileSettings;
 
     // guard static members of CppCheck against concurrent access
     EnterCriticalSection(&threadExecutor->_fileSync);
@@ -434,7 +540,7 @@ unsigned int __stdcall ThreadExecutor::threadProc(void *args)
     fileChecker.settings() = threadExecutor->_settings;
 
     for (;;) {
-        if (itFile == threadExecutor->_files.end() && itFileSettings == threadExecutor->_settings.project.fileSettings.end()) {
+        if (itFile == threadExecutor->_files.end() && itFileSettings == threadExecutor->_fileSettings.end()) {
             LeaveCriticalSection(&threadExecutor->_fileSync);
             break;
         }
@@ -456,7 +562,7 @@ unsigned int __stdcall ThreadExecutor::threadProc(void *args)
                 result += fileChecker.check(file);
             }
         } else { // file settings..
-            const ImportProject::FileSettings &fs = *itFileSettings;
+            const ImportProject::FileSettings &fs = **itFileSettings;
             ++itFileSettings;
             LeaveCriticalSection(&threadExecutor->_fileSync);
             result += fileChecker.check(fs);
@@ -503,10 +609,8 @@ void ThreadExecutor::report(const ErrorLogger::ErrorMessage &msg, MessageType ms
     const std::string errmsg = msg.toString(_settings.verbose);
 
     EnterCriticalSection(&_errorSync);
-    if (std::find(_errorList.begin(), _errorList.end(), errmsg) == _errorList.end()) {
-        _errorList.push_back(errmsg);
+    if (_errorList.insert(errmsg).second)
         reportError = true;
-    }
     LeaveCriticalSection(&_errorSync);
 
     if (reportError) {
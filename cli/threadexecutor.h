@@ -26,6 +26,8 @@
 #include <list>
 #include <map>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 #if (defined(__GNUC__) || defined(__sun)) && !defined(__MINGW32__)
 #define THREADING_MODEL_FORK
@@ -73,21 +75,29 @@ private:
     /** @brief Key is file name, and value is the content of the file */
     std::map<std::string, std::string> _fileContents;
 private:
-    enum PipeSignal {REPORT_OUT='1',REPORT_ERROR='2', REPORT_INFO='3', CHILD_END='4'};
+    enum PipeSignal {REPORT_OUT='1',REPORT_ERROR='2', REPORT_INFO='3', CHILD_END='4', REPORT_UNUSED_FUNCTIONS='5', FILE_END='6'};
 
     /**
-     * Read from the pipe, parse and handle what ever is in there.
-     *@return -1 in case of error
-     *         0 if there is nothing in the pipe to be read
+     * Read everything that is in the pipe and handle the complete
+     * messages. An incomplete message is kept in buffer.
+     *@param task indexes of the files that the child checks
+     *@param filesDone number of files of the task that the child has checked
+     *@param unusedFunctions gets the CheckUnusedFunctions summary of each file, by file index
+     *@return -1 if the child is done or in case of error
+     *         0 if there was no complete message in the pipe
      *         1 if we did read something
      */
-    int handleRead(int rpipe, unsigned int &result);
+    int handleRead(int rpipe, std::string &buffer, const std::vector<std::size_t> &task, std::size_t &filesDone, std::vector<std::string> &unusedFunctions, unsigned int &result);
+
+    /** Write a message for the parent: type, length and data */
     void writeToPipe(PipeSignal type, const std::string &data);
+
+    std::unordered_set<std::string> _errorList;
+
     /**
      * Write end of status pipe, different for each child.
      * Not used in master process.
      */
-    std::list<std::string> _errorList;
     int _wpipe;
 
     /**
@@ -112,14 +122,16 @@ private:
 
     std::map<std::string, std::string> _fileContents;
     std::map<std::string, std::size_t>::const_iterator _itNextFile;
-    std::list<ImportProject::FileSettings>::const_iterator _itNextFileSettings;
+    /** Project files, files that are preprocessed with the same settings are next to each other */
+    std::vector<const ImportProject::FileSettings *> _fileSettings;
+    std::vector<const ImportProject::FileSettings *>::const_iterator _itNextFileSettings;
     std::size_t _processedFiles;
     std::size_t _totalFiles;
     std::size_t _processedSize;
     std::size_t _totalFileSize;
     CRITICAL_SECTION _fileSync;
 
-    std::list<std::string> _errorList;
+    std::unordered_set<std::string> _errorList;
     CRITICAL_SECTION _errorSync;
 
     CRITICAL_SECTION _reportSync;
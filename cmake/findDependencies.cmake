@@ -4,6 +4,8 @@ if (BUILD_GUI)
     find_package(Qt5LinguistTools)
 endif()
 
+find_package(Threads REQUIRED)
+
 if (HAVE_RULES)
     find_library(PCRE pcre)
     if (NOT PCRE)
@@ -23,12 +23,16 @@
 #include "simplecpp.h"
 
 #include <algorithm>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <exception>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <limits>
+#include <mutex>
 #include <sstream>
 #include <stack>
 #include <stdexcept>
@@ -38,6 +42,12 @@
 #include <windows.h>
 #undef ERROR
 #undef TRUE
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 static bool isHex(const std::string &s)
@@ -268,7 +278,74 @@ std::string simplecpp::TokenList::stringify() const
     return ret.str();
 }
 
-static unsigned char readChar(std::istream &istr, unsigned int bom)
+namespace simplecpp {
+    /**
+     * Code that is read by TokenList::readfile(). The code is in memory,
+     * get(), peek() and unget() work like the std::istream functions.
+     */
+    class Stream {
+    public:
+        Stream(const unsigned char *data, std::size_t size) : begin(data), cur(data), end(data + size), eofbit(false), failbit(false) {}
+
+        bool good() const {
+            return !eofbit && !failbit;
+        }
+
+        int get() {
+            if (!good()) {
+                failbit = true;
+                return EOF;
+            }
+            if (cur == end) {
+                eofbit = failbit = true;
+                return EOF;
+            }
+            return *cur++;
+        }
+
+        int peek() {
+            if (!good()) {
+                failbit = true;
+                return EOF;
+            }
+            if (cur == end) {
+                eofbit = true;
+                return EOF;
+            }
+            return *cur;
+        }
+
+        void unget() {
+            eofbit = false;
+            if (!failbit && cur == begin)
+                failbit = true;
+            if (!failbit)
+                --cur;
+        }
+
+        /** The code that is not read yet is [position(),endPosition()) */
+        const unsigned char *position() const {
+            return cur;
+        }
+        const unsigned char *endPosition() const {
+            return end;
+        }
+
+        /** Continue reading at pos, a position that is not read yet */
+        void skipTo(const unsigned char *pos) {
+            cur = pos;
+        }
+
+    private:
+        const unsigned char * const begin;
+        const unsigned char *cur;
+        const unsigned char * const end;
+        bool eofbit;
+        bool failbit;
+    };
+}
+
+static unsigned char readChar(simplecpp::Stream &istr, unsigned int bom)
 {
     unsigned char ch = (unsigned char)istr.get();
 
@@ -299,7 +376,7 @@ static unsigned char readChar(std::istream &istr, unsigned int bom)
     return ch;
 }
 
-static unsigned char peekChar(std::istream &istr, unsigned int bom)
+static unsigned char peekChar(simplecpp::Stream &istr, unsigned int bom)
 {
     unsigned char ch = (unsigned char)istr.peek();
 
@@ -320,14 +397,14 @@ static unsigned char peekChar(std::istream &istr, unsigned int bom)
     return ch;
 }
 
-static void ungetChar(std::istream &istr, unsigned int bom)
+static void ungetChar(simplecpp::Stream &istr, unsigned int bom)
 {
     istr.unget();
     if (bom == 0xfeff || bom == 0xfffe)
         istr.unget();
 }
 
-static unsigned short getAndSkipBOM(std::istream &istr)
+static unsigned short getAndSkipBOM(simplecpp::Stream &istr)
 {
     const unsigned char ch1 = istr.peek();
 
@@ -388,7 +465,55 @@ static bool isRawStringId(const std::string &str)
     return str == "R" || str == "uR" || str == "UR" || str == "LR" || str == "u8R";
 }
 
+simplecpp::TokenList::TokenList(const unsigned char *data, std::size_t size, std::vector<std::string> &filenames, const std::string &filename, OutputList *outputList)
+    : frontToken(NULL), backToken(NULL), files(filenames)
+{
+    Stream stream(data, size);
+    readfile(stream,filename,outputList);
+}
+
+simplecpp::TokenList::TokenList(const std::string &filename, std::vector<std::string> &filenames, OutputList *outputList)
+    : frontToken(NULL), backToken(NULL), files(filenames)
+{
+#ifndef SIMPLECPP_WINDOWS
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        void *data = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+            data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data != MAP_FAILED) {
+            Stream stream(static_cast<const unsigned char *>(data), st.st_size);
+            readfile(stream,filename,outputList);
+            munmap(data, st.st_size);
+            return;
+        }
+    }
+#endif
+    std::ifstream fin(filename.c_str());
+    readfile(fin,filename,outputList);
+}
+
 void simplecpp::TokenList::readfile(std::istream &istr, const std::string &filename, OutputList *outputList)
+{
+    // reading the code at once is much faster than reading each character from the stream
+    const std::string code((std::istreambuf_iterator<char>(istr)), std::istreambuf_iterator<char>());
+    Stream stream(reinterpret_cast<const unsigned char *>(code.data()), code.size());
+    readfile(stream, filename, outputList);
+}
+
+/** Find the first CR or LF, or end */
+static const unsigned char *findNewline(const unsigned char *begin, const unsigned char *end)
+{
+    const void *nl = std::memchr(begin, '\n', end - begin);
+    if (nl)
+        end = static_cast<const unsigned char *>(nl);
+    const void *cr = std::memchr(begin, '\r', end - begin);
+    return cr ? static_cast<const unsigned char *>(cr) : end;
+}
+
+void simplecpp::TokenList::readfile(Stream &istr, const std::string &filename, OutputList *outputList)
 {
     std::stack<simplecpp::Location> loc;
 
@@ -479,8 +604,18 @@ void simplecpp::TokenList::readfile(std::istream &istr, const std::string &filen
             continue;
         }
 
+        // name, without BOM the characters are read directly
+        if (bom == 0 && isNameChar(ch) && !std::isdigit(ch)) {
+            const unsigned char * const start = istr.position() - 1;
+            const unsigned char *pos = istr.position();
+            while (pos != istr.endPosition() && isNameChar(*pos))
+                ++pos;
+            currentToken.assign(start, pos);
+            istr.skipTo(pos);
+        }
+
         // number or name
-        if (isNameChar(ch)) {
+        else if (isNameChar(ch)) {
             const bool num = std::isdigit(ch);
             while (istr.good() && isNameChar(ch)) {
                 currentToken += ch;
@@ -494,6 +629,12 @@ void simplecpp::TokenList::readfile(std::istream &istr, const std::string &filen
 
         // comment
         else if (ch == '/' && peekChar(istr,bom) == '/') {
+            if (bom == 0) {
+                const unsigned char * const newline = findNewline(istr.position(), istr.endPosition());
+                currentToken.assign(istr.position() - 1, newline);
+                istr.skipTo(newline);
+                ch = readChar(istr, bom);
+            }
             while (istr.good() && ch != '\r' && ch != '\n') {
                 currentToken += ch;
                 ch = readChar(istr, bom);
@@ -513,12 +654,30 @@ void simplecpp::TokenList::readfile(std::istream &istr, const std::string &filen
         else if (ch == '/' && peekChar(istr,bom) == '*') {
             currentToken = "/*";
             (void)readChar(istr,bom);
-            ch = readChar(istr,bom);
-            while (istr.good()) {
-                currentToken += ch;
-                if (currentToken.size() >= 4U && endsWith(currentToken, "*/"))
+
+            // without BOM and CR the comment is copied directly
+            const unsigned char * const start = istr.position();
+            const unsigned char *end = start;
+            while ((end = static_cast<const unsigned char *>(std::memchr(end, '*', istr.endPosition() - end))) != NULL) {
+                if (end + 1 != istr.endPosition() && end[1] == '/') {
+                    end += 2;
                     break;
+                }
+                ++end;
+            }
+            if (!end)
+                end = istr.endPosition();
+            if (bom == 0 && !std::memchr(start, '\r', end - start)) {
+                currentToken.append(start, end);
+                istr.skipTo(end);
+            } else {
                 ch = readChar(istr,bom);
+                while (istr.good()) {
+                    currentToken += ch;
+                    if (currentToken.size() >= 4U && endsWith(currentToken, "*/"))
+                        break;
+                    ch = readChar(istr,bom);
+                }
             }
             // multiline..
 
@@ -1038,7 +1197,7 @@ void simplecpp::TokenList::removeComments()
     }
 }
 
-std::string simplecpp::TokenList::readUntil(std::istream &istr, const Location &location, const char start, const char end, OutputList *outputList)
+std::string simplecpp::TokenList::readUntil(Stream &istr, const Location &location, const char start, const char end, OutputList *outputList)
 {
     std::string ret;
     ret += start;
@@ -1130,8 +1289,8 @@ namespace simplecpp {
 
         Macro(const std::string &name, const std::string &value, std::vector<std::string> &f) : nameTokDef(NULL), files(f), tokenListDefine(f) {
             const std::string def(name + ' ' + value);
-            std::istringstream istr(def);
-            tokenListDefine.readfile(istr);
+            Stream stream(reinterpret_cast<const unsigned char *>(def.data()), def.size());
+            tokenListDefine.readfile(stream);
             if (!parseDefine(tokenListDefine.cfront()))
                 throw std::runtime_error("bad macro syntax");
         }
@@ -2085,22 +2244,140 @@ static const simplecpp::Token *gotoNextLine(const simplecpp::Token *tok)
     return tok;
 }
 
-static std::string openHeader(std::ifstream &f, const simplecpp::DUI &dui, const std::string &sourcefile, const std::string &header, bool systemheader)
+#ifndef SIMPLECPP_WINDOWS
+namespace {
+    /**
+     * Cache of the include file lookups, shared by all files that are
+     * preprocessed. Instead of trying to open a header in each include
+     * path, the file names of a directory are read once. The found and
+     * the missing headers are cached as well. A directory is read again
+     * when its modification time is changed, see update(). The time has a
+     * coarse resolution, so a directory that was changed shortly before it
+     * was read is read again as well.
+     */
+    class IncludeCache {
+    public:
+        /** Check if the cached directories are changed. Call this before a file is preprocessed. */
+        void update() {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (std::map<std::string, Directory>::iterator it = directories.begin(); it != directories.end(); ++it) {
+                Directory dir;
+                readTime(it->first, &dir);
+                if (!it->second.racy && dir.exists == it->second.exists && dir.mtime == it->second.mtime)
+                    continue;
+                readDirectory(it->first, &dir);
+                if (dir.exists != it->second.exists || dir.listed != it->second.listed || dir.files != it->second.files)
+                    headers.clear();
+                it->second = dir;
+            }
+        }
+
+        /** Id of the include paths, used in the header lookup keys */
+        std::string includePathsId(const std::list<std::string> &includePaths) {
+            std::string paths;
+            for (std::list<std::string>::const_iterator it = includePaths.begin(); it != includePaths.end(); ++it)
+                paths += *it + '\n';
+            std::lock_guard<std::mutex> lock(mutex);
+            const std::map<std::string, std::size_t>::const_iterator id = includePathsIds.insert(std::make_pair(paths, includePathsIds.size())).first;
+            std::ostringstream ostr;
+            ostr << id->second;
+            return ostr.str();
+        }
+
+        /** Cached header lookup, the header is empty if it was not found. Returns false if the lookup is not cached. */
+        bool findHeader(const std::string &key, std::string *header) {
+            std::lock_guard<std::mutex> lock(mutex);
+            const std::map<std::string, std::string>::const_iterator it = headers.find(key);
+            if (it == headers.end())
+                return false;
+            *header = it->second;
+            return true;
+        }
+
+        void addHeader(const std::string &key, const std::string &header) {
+            std::lock_guard<std::mutex> lock(mutex);
+            headers[key] = header;
+        }
+
+        /** Is there a file with the given path? */
+        bool exists(const std::string &path) {
+            const std::string::size_type sep = path.find_last_of('/');
+            const std::string dirname = (sep == std::string::npos) ? std::string(".") : path.substr(0, sep + 1U);
+            const std::string filename = (sep == std::string::npos) ? path : path.substr(sep + 1U);
+            std::lock_guard<std::mutex> lock(mutex);
+            std::map<std::string, Directory>::iterator it = directories.find(dirname);
+            if (it == directories.end()) {
+                it = directories.insert(std::make_pair(dirname, Directory())).first;
+                readDirectory(dirname, &it->second);
+            }
+            if (!it->second.listed)
+                return it->second.exists;
+            return it->second.files.find(filename) != it->second.files.end();
+        }
+
+    private:
+        struct Directory {
+            Directory() : exists(false), listed(false), racy(false), mtime(0) {}
+            bool exists;
+            /** false if the files could not be read, then the files are opened to see if they exist */
+            bool listed;
+            /** the directory might be changed in the same second after it was read */
+            bool racy;
+            std::time_t mtime;
+            std::set<std::string> files;
+        };
+
+        static void readTime(const std::string &dirname, Directory *dir) {
+            struct stat st;
+            dir->exists = (stat(dirname.c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+            dir->mtime = dir->exists ? st.st_mtime : 0;
+        }
+
+        static void readDirectory(const std::string &dirname, Directory *dir) {
+            const std::time_t now = std::time(NULL);
+            readTime(dirname, dir);
+            dir->racy = dir->exists && dir->mtime + 1 >= now;
+            if (!dir->exists)
+                return;
+            DIR *d = opendir(dirname.c_str());
+            if (!d)
+                return;
+            dir->listed = true;
+            while (const struct dirent *entry = readdir(d))
+                dir->files.insert(entry->d_name);
+            closedir(d);
+        }
+
+        std::mutex mutex;
+        std::map<std::string, Directory> directories;
+        std::map<std::string, std::size_t> includePathsIds;
+        std::map<std::string, std::string> headers;
+    };
+
+    IncludeCache includeCache;
+}
+#endif
+
+/** Open the header if it exists, the header directories are looked up in the IncludeCache */
+static bool openFile(std::ifstream &f, const std::string &path)
 {
-    if (isAbsolutePath(header)) {
-        f.open(header.c_str());
-        return f.is_open() ? simplecpp::simplifyPath(header) : "";
-    }
+#ifndef SIMPLECPP_WINDOWS
+    if (!includeCache.exists(path))
+        return false;
+#endif
+    f.open(path.c_str());
+    return f.is_open();
+}
 
+static std::string findHeader(std::ifstream &f, const simplecpp::DUI &dui, const std::string &sourcefile, const std::string &header, bool systemheader)
+{
     if (!systemheader) {
         if (sourcefile.find_first_of("\\/") != std::string::npos) {
             const std::string s = sourcefile.substr(0, sourcefile.find_last_of("\\/") + 1U) + header;
-            f.open(s.c_str());
-            if (f.is_open())
+            if (openFile(f, s))
                 return simplecpp::simplifyPath(s);
         } else {
-            f.open(header.c_str());
-            if (f.is_open())
+            if (openFile(f, header))
                 return simplecpp::simplifyPath(header);
         }
     }
@@ -2110,15 +2387,96 @@ static std::string openHeader(std::ifstream &f, const simplecpp::DUI &dui, const
         if (!s.empty() && s[s.size()-1U]!='/' && s[s.size()-1U]!='\\')
             s += '/';
         s += header;
-        f.open(s.c_str());
-        if (f.is_open())
+        if (openFile(f, s))
             return simplecpp::simplifyPath(s);
     }
 
     return "";
 }
 
-static std::string getFileName(const std::map<std::string, simplecpp::TokenList *> &filedata, const std::string &sourcefile, const std::string &header, const simplecpp::DUI &dui, bool systemheader)
+/** Prepare the include file lookups for a new file, returns the id of the include paths for openHeader() */
+static std::string startIncludeLookups(const simplecpp::DUI &dui)
+{
+#ifdef SIMPLECPP_WINDOWS
+    (void)dui;
+    return "";
+#else
+    includeCache.update();
+    return includeCache.includePathsId(dui.includePaths);
+#endif
+}
+
+static std::string openHeader(std::ifstream &f, const simplecpp::DUI &dui, const std::string &includePathsId, const std::string &sourcefile, const std::string &header, bool systemheader)
+{
+    if (isAbsolutePath(header)) {
+        f.open(header.c_str());
+        return f.is_open() ? simplecpp::simplifyPath(header) : "";
+    }
+
+#ifdef SIMPLECPP_WINDOWS
+    (void)includePathsId;
+    return findHeader(f, dui, sourcefile, header, systemheader);
+#else
+    // The lookup depends on the directory of the source file, the header and the include paths
+    std::string key = includePathsId + (systemheader ? '<' : '"') + header;
+    if (!systemheader && sourcefile.find_first_of("\\/") != std::string::npos)
+        key += '\n' + sourcefile.substr(0, sourcefile.find_last_of("\\/") + 1U);
+
+    std::string header2;
+    if (includeCache.findHeader(key, &header2)) {
+        if (header2.empty())
+            return header2;
+        f.open(header2.c_str());
+        if (f.is_open())
+            return header2;
+        // the file can't be opened anymore, look it up again
+    }
+    header2 = findHeader(f, dui, sourcefile, header, systemheader);
+    includeCache.addHeader(key, header2);
+    return header2;
+#endif
+}
+
+/** The include paths with a trailing '/', simplified. See getFileName(). */
+static std::vector<std::string> getIncludeDirs(const simplecpp::DUI &dui)
+{
+    std::vector<std::string> dirs;
+    for (std::list<std::string>::const_iterator it = dui.includePaths.begin(); it != dui.includePaths.end(); ++it) {
+        std::string s = *it;
+        if (!s.empty() && s[s.size()-1U]!='/' && s[s.size()-1U]!='\\')
+            s += '/';
+        s = simplecpp::simplifyPath(s);
+        if (s == ".")
+            s.clear();
+        dirs.push_back(s);
+    }
+    return dirs;
+}
+
+/** Is the header path simplified if it is appended to a simplified directory? */
+static bool isSimpleHeaderPath(const std::string &header)
+{
+#ifdef SIMPLECPP_WINDOWS
+    // simplifyPath() changes the case of the path
+    (void)header;
+    return false;
+#else
+    if (header.empty() || header[0] == '/' || header.find_first_of("\\*?") != std::string::npos || header.find("//") != std::string::npos)
+        return false;
+    std::string::size_type pos = 0;
+    for (;;) {
+        const std::string::size_type end = header.find('/', pos);
+        const std::string part = header.substr(pos, end - pos);
+        if (part == "." || part == "..")
+            return false;
+        if (end == std::string::npos)
+            return true;
+        pos = end + 1U;
+    }
+#endif
+}
+
+static std::string getFileName(const std::map<std::string, simplecpp::TokenList *> &filedata, const std::string &sourcefile, const std::string &header, const std::vector<std::string> &includeDirs, bool systemheader)
 {
     if (filedata.empty()) {
         return "";
@@ -2139,12 +2497,12 @@ static std::string getFileName(const std::map<std::string, simplecpp::TokenList
         }
     }
 
-    for (std::list<std::string>::const_iterator it = dui.includePaths.begin(); it != dui.includePaths.end(); ++it) {
-        std::string s = *it;
-        if (!s.empty() && s[s.size()-1U]!='/' && s[s.size()-1U]!='\\')
-            s += '/';
-        s += header;
-        s = simplecpp::simplifyPath(s);
+    // simplifying each include path is slow, skip it when possible
+    const bool simpleHeader = isSimpleHeaderPath(header);
+    for (std::vector<std::string>::const_iterator it = includeDirs.begin(); it != includeDirs.end(); ++it) {
+        std::string s = *it + header;
+        if (!simpleHeader || (!it->empty() && (*it)[it->size()-1U] != '/'))
+            s = simplecpp::simplifyPath(s);
         if (filedata.find(s) != filedata.end())
             return s;
     }
@@ -2152,9 +2510,9 @@ static std::string getFileName(const std::map<std::string, simplecpp::TokenList
     return "";
 }
 
-static bool hasFile(const std::map<std::string, simplecpp::TokenList *> &filedata, const std::string &sourcefile, const std::string &header, const simplecpp::DUI &dui, bool systemheader)
+static bool hasFile(const std::map<std::string, simplecpp::TokenList *> &filedata, const std::string &sourcefile, const std::string &header, const std::vector<std::string> &includeDirs, bool systemheader)
 {
-    return !getFileName(filedata, sourcefile, header, dui, systemheader).empty();
+    return !getFileName(filedata, sourcefile, header, includeDirs, systemheader).empty();
 }
 
 std::map<std::string, simplecpp::TokenList*> simplecpp::load(const simplecpp::TokenList &rawtokens, std::vector<std::string> &fileNumbers, const simplecpp::DUI &dui, simplecpp::OutputList *outputList)
@@ -2163,6 +2521,9 @@ std::map<std::string, simplecpp::TokenList*> simplecpp::load(const simplecpp::To
 
     std::list<const Token *> filelist;
 
+    const std::string includePathsId = startIncludeLookups(dui);
+    const std::vector<std::string> includeDirs = getIncludeDirs(dui);
+
     // -include files
     for (std::list<std::string>::const_iterator it = dui.includes.begin(); it != dui.includes.end(); ++it) {
         const std::string &filename = realFilename(*it);
@@ -2206,11 +2567,11 @@ std::map<std::string, simplecpp::TokenList*> simplecpp::load(const simplecpp::To
         bool systemheader = (htok->str()[0] == '<');
 
         const std::string header(realFilename(htok->str().substr(1U, htok->str().size() - 2U)));
-        if (hasFile(ret, sourcefile, header, dui, systemheader))
+        if (hasFile(ret, sourcefile, header, includeDirs, systemheader))
             continue;
 
         std::ifstream f;
-        const std::string header2 = openHeader(f,dui,sourcefile,header,systemheader);
+        const std::string header2 = openHeader(f,dui,includePathsId,sourcefile,header,systemheader);
         if (!f.is_open())
             continue;
 
@@ -2252,6 +2613,9 @@ static bool preprocessToken(simplecpp::TokenList &output, const simplecpp::Token
 
 void simplecpp::preprocess(simplecpp::TokenList &output, const simplecpp::TokenList &rawtokens, std::vector<std::string> &files, std::map<std::string, simplecpp::TokenList *> &filedata, const simplecpp::DUI &dui, simplecpp::OutputList *outputList, std::list<simplecpp::MacroUsage> *macroUsage)
 {
+    const std::string includePathsId = startIncludeLookups(dui);
+    const std::vector<std::string> includeDirs = getIncludeDirs(dui);
+
     std::map<std::string, std::size_t> sizeOfType(rawtokens.sizeOfType);
     sizeOfType.insert(std::pair<std::string, std::size_t>("char", sizeof(char)));
     sizeOfType.insert(std::pair<std::string, std::size_t>("short", sizeof(short)));
@@ -2427,11 +2791,11 @@ void simplecpp::preprocess(simplecpp::TokenList &output, const simplecpp::TokenL
 
                 const bool systemheader = (inctok->op == '<');
                 const std::string header(realFilename(inctok->str().substr(1U, inctok->str().size() - 2U)));
-                std::string header2 = getFileName(filedata, rawtok->location.file(), header, dui, systemheader);
+                std::string header2 = getFileName(filedata, rawtok->location.file(), header, includeDirs, systemheader);
                 if (header2.empty()) {
                     // try to load file..
                     std::ifstream f;
-                    header2 = openHeader(f, dui, rawtok->location.file(), header, systemheader);
+                    header2 = openHeader(f, dui, includePathsId, rawtok->location.file(), header, systemheader);
                     if (f.is_open()) {
                         TokenList *tokens = new TokenList(f, files, header2, outputList);
                         filedata[header2] = tokens;
@@ -173,11 +173,17 @@ namespace simplecpp {
 
     typedef std::list<Output> OutputList;
 
+    class Stream;
+
     /** List of tokens. */
     class SIMPLECPP_LIB TokenList {
     public:
         explicit TokenList(std::vector<std::string> &filenames);
         TokenList(std::istream &istr, std::vector<std::string> &filenames, const std::string &filename=std::string(), OutputList *outputList = 0);
+        /** Read the code in memory */
+        TokenList(const unsigned char *data, std::size_t size, std::vector<std::string> &filenames, const std::string &filename=std::string(), OutputList *outputList = 0);
+        /** Read the file, it is memory mapped when possible */
+        TokenList(const std::string &filename, std::vector<std::string> &filenames, OutputList *outputList = 0);
         TokenList(const TokenList &other);
         ~TokenList();
         TokenList &operator=(const TokenList &other);
@@ -192,6 +198,7 @@ namespace simplecpp {
         std::string stringify() const;
 
         void readfile(std::istream &istr, const std::string &filename=std::string(), OutputList *outputList = 0);
+        void readfile(Stream &stream, const std::string &filename=std::string(), OutputList *outputList = 0);
         void constFold();
 
         void removeComments();
@@ -256,7 +263,7 @@ namespace simplecpp {
         void constFoldLogicalOp(Token *tok);
         void constFoldQuestionOp(Token **tok1);
 
-        std::string readUntil(std::istream &istr, const Location &location, const char start, const char end, OutputList *outputList);
+        std::string readUntil(Stream &stream, const Location &location, const char start, const char end, OutputList *outputList);
 
         std::string lastLine(int maxsize=10) const;
 
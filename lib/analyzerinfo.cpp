@@ -16,15 +16,194 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+
 #include "analyzerinfo.h"
 
+#include "functionsummaries.h"
 #include "path.h"
 #include "utils.h"
 
 #include <tinyxml2.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
-#include <map>
+#include <ctime>
+#include <fstream>
+#include <mutex>
 #include <sstream>
+#include <utility>
+#include <set>
+#include <vector>
+
+#include <sys/stat.h>
+
+// Record: magic, key length, data length, checksum, key, data
+static const char recordMagic[4] = { 'C', 'A', 'I', '1' };
+static const std::size_t recordHeaderSize = sizeof(recordMagic) + 4U + 4U + 8U;
+
+static std::string getKey(const std::string &sourcefile, const std::string &cfg)
+{
+    return cfg + ':' + Path::fromNativeSeparators(sourcefile);
+}
+
+AnalyzerInfoStore::AnalyzerInfoStore(const std::string &buildDir)
+    : _filename(getStoreFile(buildDir))
+{
+    load();
+}
+
+std::string AnalyzerInfoStore::getStoreFile(const std::string &buildDir)
+{
+    return buildDir + "/analyzerinfo.dat";
+}
+
+void AnalyzerInfoStore::load()
+{
+    _data.clear();
+    _index.clear();
+
+    std::ifstream fin(_filename, std::ios::in | std::ios::binary);
+    if (!fin.is_open())
+        return;
+    fin.seekg(0, std::ios::end);
+    const std::streamoff size = fin.tellg();
+    if (size <= 0)
+        return;
+    fin.seekg(0, std::ios::beg);
+    _data.resize(static_cast<std::size_t>(size));
+    if (!fin.read(&_data[0], size)) {
+        _data.clear();
+        return;
+    }
+
+    std::size_t pos = 0;
+    while (_data.size() - pos >= recordHeaderSize) {
+        const char *header = _data.data() + pos;
+        if (std::memcmp(header, recordMagic, sizeof(recordMagic)) != 0)
+            break;
+        std::uint32_t keyLen = 0, dataLen = 0;
+        std::uint64_t checksum = 0;
+        std::memcpy(&keyLen, header + 4, 4);
+        std::memcpy(&dataLen, header + 8, 4);
+        std::memcpy(&checksum, header + 12, 8);
+        if (_data.size() - pos - recordHeaderSize < static_cast<std::size_t>(keyLen) + dataLen)
+            break;
+        Record &record = _index[_data.substr(pos + recordHeaderSize, keyLen)];
+        record.offset = pos + recordHeaderSize + keyLen;
+        record.size = dataLen;
+        record.checksum = checksum;
+        pos = record.offset + dataLen;
+    }
+
+    // Drop a record that was not completely written. It is also removed
+    // from the file, records that are appended after it would be lost.
+    if (pos < _data.size()) {
+        _data.resize(pos);
+        std::ofstream fout(_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+        fout.write(_data.data(), _data.size());
+    }
+}
+
+bool AnalyzerInfoStore::read(const std::string &sourcefile, const std::string &cfg, unsigned long long *checksum, std::string *data) const
+{
+    const std::map<std::string, Record>::const_iterator it = _index.find(getKey(sourcefile, cfg));
+    if (it == _index.end())
+        return false;
+    *checksum = it->second.checksum;
+    data->assign(_data, it->second.offset, it->second.size);
+    return true;
+}
+
+void AnalyzerInfoStore::readAll(std::vector<std::string> *data) const
+{
+    for (std::map<std::string, Record>::const_iterator it = _index.begin(); it != _index.end(); ++it)
+        data->push_back(_data.substr(it->second.offset, it->second.size));
+}
+
+void AnalyzerInfoStore::append(const std::string &sourcefile, const std::string &cfg, unsigned long long checksum, const std::string &data)
+{
+    const std::string key = getKey(sourcefile, cfg);
+    const std::uint32_t keyLen = static_cast<std::uint32_t>(key.size());
+    const std::uint32_t dataLen = static_cast<std::uint32_t>(data.size());
+    const std::uint64_t checksum64 = checksum;
+
+    char header[recordHeaderSize];
+    std::memcpy(header, recordMagic, sizeof(recordMagic));
+    std::memcpy(header + 4, &keyLen, 4);
+    std::memcpy(header + 8, &dataLen, 4);
+    std::memcpy(header + 12, &checksum64, 8);
+
+    std::string record;
+    record.reserve(recordHeaderSize + key.size() + data.size());
+    record.append(header, recordHeaderSize);
+    record += key;
+    record += data;
+
+    // The record is written with one unbuffered write to a file that is
+    // opened in append mode so records from parallel jobs don't mix.
+    FILE *f = std::fopen(_filename.c_str(), "ab");
+    if (!f)
+        return;
+    std::setvbuf(f, nullptr, _IONBF, 0);
+    const bool written = (std::fwrite(record.data(), 1, record.size(), f) == record.size());
+    std::fclose(f);
+    if (!written)
+        return;
+
+    Record &r = _index[key];
+    r.offset = _data.size() + recordHeaderSize + key.size();
+    r.size = data.size();
+    r.checksum = checksum;
+    _data += record;
+}
+
+void AnalyzerInfoStore::compact()
+{
+    std::vector<std::pair<std::size_t, std::size_t> > records;
+    std::size_t liveSize = 0;
+    for (std::map<std::string, Record>::const_iterator it = _index.begin(); it != _index.end(); ++it) {
+        const std::size_t begin = it->second.offset - it->first.size() - recordHeaderSize;
+        records.emplace_back(begin, it->second.offset + it->second.size - begin);
+        liveSize += records.back().second;
+    }
+    if (liveSize * 2U >= _data.size())
+        return;
+
+    std::sort(records.begin(), records.end());
+    std::string data;
+    data.reserve(liveSize);
+    for (std::vector<std::pair<std::size_t, std::size_t> >::const_iterator it = records.begin(); it != records.end(); ++it)
+        data.append(_data, it->first, it->second);
+
+    const std::string tempfile = _filename + ".tmp";
+    {
+        std::ofstream fout(tempfile, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!fout.is_open() || !fout.write(data.data(), data.size()))
+            return;
+    }
+    std::remove(_filename.c_str());
+    std::rename(tempfile.c_str(), _filename.c_str());
+    load();
+}
+
+/** Protects the stores that are loaded in this process */
+static std::mutex storeMutex;
+
+/** Get the store of a build dir. It is only loaded once in each process. */
+static AnalyzerInfoStore &getStore(const std::string &buildDir)
+{
+    static std::map<std::string, AnalyzerInfoStore> stores;
+    std::map<std::string, AnalyzerInfoStore>::iterator it = stores.find(buildDir);
+    if (it == stores.end())
+        it = stores.emplace(buildDir, AnalyzerInfoStore(buildDir)).first;
+    return it->second;
+}
+
+AnalyzerInformation::AnalyzerInformation() : currentChecksum(0)
+{
+}
 
 AnalyzerInformation::~AnalyzerInformation()
 {
@@ -62,21 +241,41 @@ void AnalyzerInformation::writeFilesTxt(const std::string &buildDir, const std::
             fileCount[afile] = 0;
         fout << afile << ".a" << (++fileCount[afile]) << ":" << fs->cfg << ":" << Path::fromNativeSeparators(fs->filename) << std::endl;
     }
+
+    // Load the store before the files are checked so -j children share it
+    std::lock_guard<std::mutex> lock(storeMutex);
+    getStore(buildDir).compact();
 }
 
 void AnalyzerInformation::close()
 {
-    analyzerInfoFile.clear();
-    if (fout.is_open()) {
-        fout << "</analyzerinfo>\n";
-        fout.close();
+    if (currentBuildDir.empty())
+        return;
+    const std::string data = "<analyzerinfo>\n" + dependencies + analyzerInfo + "</analyzerinfo>\n";
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        getStore(currentBuildDir).append(currentFile, currentCfg, currentChecksum, data);
     }
+    currentBuildDir.clear();
+    analyzerInfo.clear();
+    dependencies.clear();
 }
 
-static bool skipAnalysis(const std::string &analyzerInfoFile, unsigned long long checksum, std::list<ErrorLogger::ErrorMessage> *errors)
+/** Are the summaries of the functions of other TUs the same as when the TU was analyzed? */
+static bool isSummariesUnchanged(const tinyxml2::XMLElement *rootNode, const FunctionSummaries *functionSummaries)
+{
+    static const FunctionSummaries noSummaries;
+    for (const tinyxml2::XMLElement *e = rootNode->FirstChildElement("summaries"); e; e = e->NextSiblingElement("summaries")) {
+        if (!(functionSummaries ? functionSummaries : &noSummaries)->isUnchanged(e))
+            return false;
+    }
+    return true;
+}
+
+static bool skipAnalysis(const std::string &data, const FunctionSummaries *functionSummaries, std::list<ErrorLogger::ErrorMessage> *errors)
 {
     tinyxml2::XMLDocument doc;
-    const tinyxml2::XMLError error = doc.LoadFile(analyzerInfoFile.c_str());
+    const tinyxml2::XMLError error = doc.Parse(data.data(), data.size());
     if (error != tinyxml2::XML_SUCCESS)
         return false;
 
@@ -84,8 +283,7 @@ static bool skipAnalysis(const std::string &analyzerInfoFile, unsigned long long
     if (rootNode == nullptr)
         return false;
 
-    const char *attr = rootNode->Attribute("checksum");
-    if (!attr || attr != std::to_string(checksum))
+    if (!isSummariesUnchanged(rootNode, functionSummaries))
         return false;
 
     for (const tinyxml2::XMLElement *e = rootNode->FirstChildElement(); e; e = e->NextSiblingElement()) {
@@ -126,36 +324,244 @@ std::string AnalyzerInformation::getAnalyzerInfoFile(const std::string &buildDir
     return filename;
 }
 
-bool AnalyzerInformation::analyzeFile(const std::string &buildDir, const std::string &sourcefile, const std::string &cfg, unsigned long long checksum, std::list<ErrorLogger::ErrorMessage> *errors)
+static bool getFileStatus(const std::string &path, bool *isDir, long long *size, long long *mtime)
 {
-    if (buildDir.empty() || sourcefile.empty())
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) == -1)
+        return false;
+    *isDir = ((file_stat.st_mode & S_IFMT) == S_IFDIR);
+    *size = file_stat.st_size;
+    *mtime = file_stat.st_mtime;
+    return true;
+}
+
+/** FNV-1a hash of the file content */
+static bool getFileHash(const std::string &path, unsigned long long *hash)
+{
+    std::ifstream fin(path, std::ios::in | std::ios::binary);
+    if (!fin.is_open())
+        return false;
+    unsigned long long h = 14695981039346656037ULL;
+    char buf[65536];
+    while (fin) {
+        fin.read(buf, sizeof(buf));
+        const std::streamsize n = fin.gcount();
+        for (std::streamsize i = 0; i < n; ++i) {
+            h ^= static_cast<unsigned char>(buf[i]);
+            h *= 1099511628211ULL;
+        }
+    }
+    *hash = h;
+    return true;
+}
+
+static long long getLongLongAttribute(const tinyxml2::XMLElement *e, const char name[])
+{
+    const char *attr = e->Attribute(name);
+    return attr ? std::strtoll(attr, nullptr, 10) : -1;
+}
+
+static bool isDependencyUnchanged(const tinyxml2::XMLElement *e, long long time)
+{
+    const char *name = e->Attribute("name");
+    if (!name)
+        return false;
+    bool isDir = false;
+    long long size = 0, mtime = 0;
+    if (!getFileStatus(name, &isDir, &size, &mtime))
+        return std::strcmp(e->Name(), "missing") == 0;
+    if (isDir != (std::strcmp(e->Name(), "dir") == 0))
+        return false;
+    if (isDir)
+        return mtime == getLongLongAttribute(e, "mtime") && mtime < time;
+    if (size != getLongLongAttribute(e, "size"))
+        return false;
+    // A file that was written in the same second as the analysis might
+    // have been modified after it without a change of the mtime.
+    if (mtime == getLongLongAttribute(e, "mtime") && mtime < time)
         return true;
-    close();
+    unsigned long long hash = 0;
+    const char *hashAttr = e->Attribute("hash");
+    return hashAttr && getFileHash(name, &hash) && hash == std::strtoull(hashAttr, nullptr, 10);
+}
+
+/** Are the files and directories that a TU depends on unchanged? */
+static bool isDependenciesUnchanged(const tinyxml2::XMLElement *dependenciesNode)
+{
+    const long long time = getLongLongAttribute(dependenciesNode, "time");
+    for (const tinyxml2::XMLElement *e = dependenciesNode->FirstChildElement(); e; e = e->NextSiblingElement()) {
+        if (!isDependencyUnchanged(e, time))
+            return false;
+    }
+    return true;
+}
 
-    analyzerInfoFile = AnalyzerInformation::getAnalyzerInfoFile(buildDir,sourcefile,cfg);
+/** The include paths are added to the toolinfo, they determine which headers are found */
+static std::string getDependencyToolinfo(const std::string &toolinfo, const std::list<std::string> &includePaths)
+{
+    std::string ret = toolinfo;
+    for (std::list<std::string>::const_iterator i = includePaths.begin(); i != includePaths.end(); ++i)
+        ret += " -I" + *i;
+    return ret;
+}
 
-    if (skipAnalysis(analyzerInfoFile, checksum, errors))
+bool AnalyzerInformation::skipUnchangedFile(const std::string &buildDir, const std::string &sourcefile, const std::string &cfg, const std::string &toolinfo, const std::list<std::string> &includePaths, const FunctionSummaries *functionSummaries, std::list<ErrorLogger::ErrorMessage> *errors)
+{
+    if (buildDir.empty() || sourcefile.empty())
+        return false;
+
+    unsigned long long checksum = 0;
+    std::string data;
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        if (!getStore(buildDir).read(sourcefile, cfg, &checksum, &data))
+            return false;
+    }
+
+    tinyxml2::XMLDocument doc;
+    if (doc.Parse(data.data(), data.size()) != tinyxml2::XML_SUCCESS)
+        return false;
+    const tinyxml2::XMLElement * const rootNode = doc.FirstChildElement();
+    if (rootNode == nullptr)
+        return false;
+    const tinyxml2::XMLElement * const dependenciesNode = rootNode->FirstChildElement("dependencies");
+    if (dependenciesNode == nullptr)
+        return false;
+    const char *toolinfoAttr = dependenciesNode->Attribute("toolinfo");
+    if (!toolinfoAttr || getDependencyToolinfo(toolinfo, includePaths) != toolinfoAttr)
         return false;
+    if (!isDependenciesUnchanged(dependenciesNode) || !isSummariesUnchanged(rootNode, functionSummaries))
+        return false;
+
+    for (const tinyxml2::XMLElement *e = rootNode->FirstChildElement(); e; e = e->NextSiblingElement()) {
+        if (std::strcmp(e->Name(), "error") == 0)
+            errors->emplace_back(e);
+    }
+    return true;
+}
+
+/** Add the directory of a file to dirs, "." for the current directory */
+static void addDirectory(const std::string &filename, std::set<std::string> &dirs)
+{
+    const std::string dir = Path::getPathFromFilename(Path::simplifyPath(filename));
+    dirs.insert(dir.empty() ? std::string(".") : dir);
+}
+
+void AnalyzerInformation::setDependencies(const std::string &toolinfo, const std::vector<std::string> &files, const std::list<std::pair<std::string, std::string> > &includes, const std::list<std::string> &includePaths)
+{
+    dependencies.clear();
+    if (currentBuildDir.empty())
+        return;
 
-    fout.open(analyzerInfoFile);
-    if (fout.is_open()) {
-        fout << "<?xml version=\"1.0\"?>\n";
-        fout << "<analyzerinfo checksum=\"" << checksum << "\">\n";
-    } else {
-        analyzerInfoFile.clear();
+    std::ostringstream ostr;
+    ostr << "  <dependencies toolinfo=\"" << ErrorLogger::toxml(getDependencyToolinfo(toolinfo, includePaths)) << "\" time=\"" << static_cast<long long>(std::time(nullptr)) << "\">\n";
+
+    // A new file in one of these directories might be included instead
+    // of a file that is found later in the include paths, or that was not
+    // found at all. Each header is looked up in the directory of the
+    // including file and in every include path, the directories where it
+    // is looked up are recorded whether they exist or not.
+    std::set<std::string> dirs(includePaths.begin(), includePaths.end());
+    for (std::list<std::pair<std::string, std::string> >::const_iterator i = includes.begin(); i != includes.end(); ++i) {
+        const std::string &header = i->second;
+        if (header.size() < 3U)
+            continue;
+        const std::string name = header.substr(1, header.size() - 2U);
+        if (Path::isAbsolute(name))
+            continue;
+        if (header[0] == '\"')
+            addDirectory(Path::getPathFromFilename(i->first) + name, dirs);
+        for (std::list<std::string>::const_iterator p = includePaths.begin(); p != includePaths.end(); ++p)
+            addDirectory(endsWith(*p, '/') ? (*p + name) : (*p + '/' + name), dirs);
+    }
+    for (std::vector<std::string>::const_iterator f = files.begin(); f != files.end(); ++f) {
+        addDirectory(*f, dirs);
+
+        bool isDir = false;
+        long long size = 0, mtime = 0;
+        unsigned long long hash = 0;
+        if (!getFileStatus(*f, &isDir, &size, &mtime) || isDir || !getFileHash(*f, &hash))
+            return;
+        ostr << "    <file name=\"" << ErrorLogger::toxml(*f) << "\" size=\"" << size << "\" mtime=\"" << mtime << "\" hash=\"" << hash << "\"/>\n";
+    }
+
+    for (std::set<std::string>::const_iterator d = dirs.begin(); d != dirs.end(); ++d) {
+        bool isDir = false;
+        long long size = 0, mtime = 0;
+        if (!getFileStatus(*d, &isDir, &size, &mtime))
+            ostr << "    <missing name=\"" << ErrorLogger::toxml(*d) << "\"/>\n";
+        else
+            ostr << "    <dir name=\"" << ErrorLogger::toxml(*d) << "\" mtime=\"" << mtime << "\"/>\n";
     }
 
+    ostr << "  </dependencies>\n";
+    dependencies = ostr.str();
+}
+
+bool AnalyzerInformation::analyzeFile(const std::string &buildDir, const std::string &sourcefile, const std::string &cfg, unsigned long long checksum, const FunctionSummaries *functionSummaries, std::list<ErrorLogger::ErrorMessage> *errors)
+{
+    if (buildDir.empty() || sourcefile.empty())
+        return true;
+    close();
+
+    unsigned long long oldChecksum = 0;
+    std::string oldAnalyzerInfo;
+    bool found;
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        found = getStore(buildDir).read(sourcefile, cfg, &oldChecksum, &oldAnalyzerInfo);
+    }
+    if (found && oldChecksum == checksum && skipAnalysis(oldAnalyzerInfo, functionSummaries, errors))
+        return false;
+
+    currentBuildDir = buildDir;
+    currentFile = sourcefile;
+    currentCfg = cfg;
+    currentChecksum = checksum;
     return true;
 }
 
 void AnalyzerInformation::reportErr(const ErrorLogger::ErrorMessage &msg, bool /*verbose*/)
 {
-    if (fout.is_open())
-        fout << msg.toXML() << '\n';
+    if (!currentBuildDir.empty())
+        analyzerInfo += msg.toXML() + '\n';
 }
 
 void AnalyzerInformation::setFileInfo(const std::string &check, const std::string &fileInfo)
 {
-    if (fout.is_open() && !fileInfo.empty())
-        fout << "  <FileInfo check=\"" << check << "\">\n" << fileInfo << "  </FileInfo>\n";
+    if (!currentBuildDir.empty() && !fileInfo.empty())
+        analyzerInfo += "  <FileInfo check=\"" + check + "\">\n" + fileInfo + "  </FileInfo>\n";
+}
+
+void AnalyzerInformation::setFunctionSummaries(const std::string &summaries)
+{
+    if (!currentBuildDir.empty())
+        analyzerInfo += summaries;
+}
+
+std::shared_ptr<const FunctionSummaries> AnalyzerInformation::loadFunctionSummaries(const std::string &buildDir)
+{
+    std::vector<std::string> records;
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        getStore(buildDir).readAll(&records);
+    }
+
+    // The summaries of a TU that is modified are not used, the TU is
+    // analyzed again and its new summaries are used in the next analysis
+    std::shared_ptr<FunctionSummaries> functionSummaries = std::make_shared<FunctionSummaries>();
+    for (std::vector<std::string>::const_iterator it = records.begin(); it != records.end(); ++it) {
+        tinyxml2::XMLDocument doc;
+        if (doc.Parse(it->data(), it->size()) != tinyxml2::XML_SUCCESS)
+            continue;
+        const tinyxml2::XMLElement * const rootNode = doc.FirstChildElement();
+        if (rootNode == nullptr)
+            continue;
+        const tinyxml2::XMLElement * const dependenciesNode = rootNode->FirstChildElement("dependencies");
+        if (dependenciesNode == nullptr || !isDependenciesUnchanged(dependenciesNode))
+            continue;
+        for (const tinyxml2::XMLElement *e = rootNode->FirstChildElement("summaries"); e; e = e->NextSiblingElement("summaries"))
+            functionSummaries->load(e);
+    }
+    return functionSummaries;
 }
@@ -25,13 +25,68 @@
 #include "errorlogger.h"
 #include "importproject.h"
 
-#include <fstream>
+#include <cstddef>
 #include <list>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+
+class FunctionSummaries;
 
 /// @addtogroup Core
 /// @{
 
+/**
+ * @brief Analyzer information of all TUs, stored in one file in the build dir
+ *
+ * The file is a sequence of records (checksum, source file, configuration
+ * and the data of the TU). Records are only appended so parallel jobs can
+ * write to the file at the same time. A later record of a TU replaces the
+ * earlier ones; compact() drops the replaced records.
+ */
+class CPPCHECKLIB AnalyzerInfoStore {
+public:
+    explicit AnalyzerInfoStore(const std::string &buildDir);
+
+    /**
+     * Get the data of a TU
+     * @return false if the TU is not in the store
+     */
+    bool read(const std::string &sourcefile, const std::string &cfg, unsigned long long *checksum, std::string *data) const;
+
+    /** Get the data of all TUs */
+    void readAll(std::vector<std::string> *data) const;
+
+    /** Append a record for a TU */
+    void append(const std::string &sourcefile, const std::string &cfg, unsigned long long checksum, const std::string &data);
+
+    /** Rewrite the file without the records that are replaced by later records */
+    void compact();
+
+    static std::string getStoreFile(const std::string &buildDir);
+
+private:
+    /** Read the records of a file into _data and index them */
+    void load();
+
+    struct Record {
+        Record() : offset(0), size(0), checksum(0) {}
+        std::size_t offset;
+        std::size_t size;
+        unsigned long long checksum;
+    };
+
+    const std::string _filename;
+
+    /** Content of the file */
+    std::string _data;
+
+    /** Latest record of each TU, key is cfg:sourcefile */
+    std::map<std::string, Record> _index;
+};
+
 /**
 * @brief Analyzer information
 *
@@ -47,19 +102,64 @@
 */
 class CPPCHECKLIB AnalyzerInformation {
 public:
+    AnalyzerInformation();
     ~AnalyzerInformation();
 
+    /** Write files.txt and prepare the analyzer info store. Call this before the TUs are checked. */
     static void writeFilesTxt(const std::string &buildDir, const std::list<std::string> &sourcefiles, const std::list<ImportProject::FileSettings> &fileSettings);
 
-    /** Close current TU.analyzerinfo file */
+    /**
+     * Load the function summaries of the TUs whose files are not modified
+     * since they were analyzed. Call this before the TUs are checked.
+     */
+    static std::shared_ptr<const FunctionSummaries> loadFunctionSummaries(const std::string &buildDir);
+
+    /** Write the data of the current TU to the store */
     void close();
-    bool analyzeFile(const std::string &buildDir, const std::string &sourcefile, const std::string &cfg, unsigned long long checksum, std::list<ErrorLogger::ErrorMessage> *errors);
+
+    /**
+     * Check if the TU has to be analyzed
+     * @param functionSummaries the summaries of the functions of other TUs, the TU is analyzed if the summaries it used are changed
+     * @param errors gets the errors of the last analysis if the TU is not analyzed
+     * @return true if the TU has to be analyzed
+     */
+    bool analyzeFile(const std::string &buildDir, const std::string &sourcefile, const std::string &cfg, unsigned long long checksum, const FunctionSummaries *functionSummaries, std::list<ErrorLogger::ErrorMessage> *errors);
+
+    /**
+     * Check if the TU, the files it includes and the include paths are not
+     * modified since the last analysis, without reading the TU.
+     * @param functionSummaries the summaries of the functions of other TUs, the TU is not skipped if the summaries it used are changed
+     * @param errors gets the errors of the last analysis if the TU is unchanged
+     * @return true if the TU is unchanged
+     */
+    static bool skipUnchangedFile(const std::string &buildDir, const std::string &sourcefile, const std::string &cfg, const std::string &toolinfo, const std::list<std::string> &includePaths, const FunctionSummaries *functionSummaries, std::list<ErrorLogger::ErrorMessage> *errors);
+
+    /**
+     * Record the files that the current TU is read from and the directories they are searched in
+     * @param toolinfo tool information, see skipUnchangedFile()
+     * @param files the files that are read
+     * @param includes the including file and the header name with its quotes or angle brackets of each include directive
+     * @param includePaths the include paths
+     */
+    void setDependencies(const std::string &toolinfo, const std::vector<std::string> &files, const std::list<std::pair<std::string, std::string> > &includes, const std::list<std::string> &includePaths);
     void reportErr(const ErrorLogger::ErrorMessage &msg, bool verbose);
     void setFileInfo(const std::string &check, const std::string &fileInfo);
+
+    /** Add the \<summaries\> element of the current TU, see FunctionSummaries::toXml() */
+    void setFunctionSummaries(const std::string &summaries);
     static std::string getAnalyzerInfoFile(const std::string &buildDir, const std::string &sourcefile, const std::string &cfg);
 private:
-    std::ofstream fout;
-    std::string analyzerInfoFile;
+    /** TU that is analyzed, the build dir is empty if no TU is analyzed */
+    std::string currentBuildDir;
+    std::string currentFile;
+    std::string currentCfg;
+    unsigned long long currentChecksum;
+
+    /** analyzer info of the current TU */
+    std::string analyzerInfo;
+
+    /** dependencies of the current TU */
+    std::string dependencies;
 };
 
 /// @}
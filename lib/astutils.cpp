@@ -139,6 +139,9 @@ bool isSameExpression(bool cpp, bool macro, const Token *tok1, const Token *tok2
         return true;
     if (tok1 == nullptr || tok2 == nullptr)
         return false;
+    // different structure => not same
+    if (tok1->exprHash() && tok2->exprHash() && tok1->exprHash() != tok2->exprHash())
+        return false;
     if (cpp) {
         if (tok1->str() == "." && tok1->astOperand1() && tok1->astOperand1()->str() == "this")
             tok1 = tok1->astOperand2();
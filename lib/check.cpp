@@ -20,6 +20,10 @@
 
 #include "check.h"
 
+#include "functionsummaries.h"
+#include "library.h"
+#include "symboldatabase.h"
+
 #include <iostream>
 
 //---------------------------------------------------------------------------
@@ -36,6 +40,43 @@ Check::Check(const std::string &aname)
     instances().push_back(this);
 }
 
+Check::TokenCensus::TokenCensus(const Tokenizer *tokenizer, const Settings *settings)
+    : _allocation(false)
+{
+    for (const Token *tok = tokenizer->tokens(); tok; tok = tok->next()) {
+        if (!tok->isName())
+            continue;
+        if (!_names.insert(tok->str()).second)
+            continue;
+        if (_allocation)
+            continue;
+        // Library lookups are done once per distinct name
+        if (Token::Match(tok, "new|delete|realloc|g_realloc|g_try_realloc|auto_ptr|unique_ptr|shared_ptr"))
+            _allocation = true;
+        else if (settings->standards.posix && Token::Match(tok, "open|openat|creat|mkstemp|mkostemp|socket|popen|close|pclose"))
+            _allocation = true;
+        else if (settings->library.alloc(tok->str().c_str()) || settings->library.dealloc(tok->str().c_str()))
+            _allocation = true;
+        else if (settings->functionSummaries && tok->function() && !tok->function()->hasBody()) {
+            // function of another TU that returns allocated memory
+            const FunctionSummaries::Summary *summary = settings->functionSummaries->find(tok->function());
+            if (summary && summary->returnAllocType != 0)
+                _allocation = true;
+        }
+    }
+
+    if (_allocation)
+        return;
+
+    // qualified or inherited Library functions
+    for (const Token *tok = tokenizer->tokens(); tok; tok = tok->next()) {
+        if (Token::Match(tok, "%name% (") && (settings->library.alloc(tok) || settings->library.dealloc(tok))) {
+            _allocation = true;
+            break;
+        }
+    }
+}
+
 void Check::reportError(const ErrorLogger::ErrorMessage &errmsg)
 {
     std::cout << errmsg.toXML() << std::endl;
@@ -29,6 +29,7 @@
 #include "valueflow.h"
 
 #include <list>
+#include <set>
 #include <string>
 
 namespace tinyxml2 {
@@ -81,6 +82,52 @@ public:
     /** get information about this class, used to generate documentation */
     virtual std::string classInfo() const = 0;
 
+    /**
+     * @brief Cheap summary of a token list, collected in one pass.
+     * It is shared by all checks so they can tell if they are relevant at all.
+     */
+    class CPPCHECKLIB TokenCensus {
+    public:
+        TokenCensus(const Tokenizer *tokenizer, const Settings *settings);
+
+        /** is there a token with the given name? */
+        bool hasName(const std::string &name) const {
+            return _names.find(name) != _names.end();
+        }
+
+        /** is there any allocation or deallocation (new/delete, Library alloc/dealloc, posix resources)? */
+        bool hasAllocation() const {
+            return _allocation;
+        }
+
+    private:
+        std::set<std::string> _names;
+        bool _allocation;
+    };
+
+    /**
+     * Can this check report anything for the token list summarized by the census?
+     * Checks that return false are not executed.
+     */
+    virtual bool isRelevant(const TokenCensus &census) const {
+        (void)census;
+        return true;
+    }
+
+    /**
+     * Can this check run concurrently with other checks on the same
+     * token list (--check-threads)? Checks that modify shared state,
+     * or report errors through something else than the given error
+     * logger, must return false. Tokenizer::IsScopeNoReturn() is such a
+     * case: with --check-library it reports through the Tokenizer's
+     * logger, so checks that call it are only thread safe without
+     * --check-library.
+     */
+    virtual bool isThreadSafe(const Settings *settings) const {
+        (void)settings;
+        return true;
+    }
+
     /**
      * Write given error to errorlogger or to out stream in xml format.
      * This is for for printout out the error list with --errorlist
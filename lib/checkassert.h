@@ -54,6 +54,10 @@ public:
         check.assertWithSideEffects();
     }
 
+    bool isRelevant(const TokenCensus &census) const override {
+        return census.hasName("assert");
+    }
+
     void assertWithSideEffects();
 
 protected:
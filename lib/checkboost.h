@@ -58,6 +58,10 @@ public:
         checkBoost.checkBoostForeachModification();
     }
 
+    bool isRelevant(const TokenCensus &census) const override {
+        return census.hasName("BOOST_FOREACH");
+    }
+
     /** @brief %Check for container modification while using the BOOST_FOREACH macro */
     void checkBoostForeachModification();
 
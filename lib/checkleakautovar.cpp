@@ -38,6 +38,7 @@
 #include <list>
 #include <stack>
 #include <utility>
+#include <vector>
 
 //---------------------------------------------------------------------------
 
@@ -169,16 +170,16 @@ void CheckLeakAutoVar::check()
         varInfo.conditionalAlloc.clear();
 
         // Clear reference arguments from varInfo..
-        std::map<unsigned int, VarInfo::AllocInfo>::iterator it = varInfo.alloctype.begin();
-        while (it != varInfo.alloctype.end()) {
+        std::vector<unsigned int> nonLocal;
+        for (std::map<unsigned int, VarInfo::AllocInfo>::const_iterator it = varInfo.alloctype.begin(); it != varInfo.alloctype.end(); ++it) {
             const Variable *var = symbolDatabase->getVariableFromVarId(it->first);
             if (!var ||
                 (var->isArgument() && var->isReference()) ||
                 (!var->isArgument() && !var->isLocal()))
-                varInfo.alloctype.erase(it++);
-            else
-                ++it;
+                nonLocal.push_back(it->first);
         }
+        for (unsigned int varid : nonLocal)
+            varInfo.alloctype.erase(varid);
 
         ret(scope->bodyEnd, varInfo);
     }
@@ -236,8 +237,8 @@ void CheckLeakAutoVar::checkScope(const Token * const startToken,
                                   VarInfo *varInfo,
                                   std::set<unsigned int> notzero)
 {
-    std::map<unsigned int, VarInfo::AllocInfo> &alloctype = varInfo->alloctype;
-    std::map<unsigned int, std::string> &possibleUsage = varInfo->possibleUsage;
+    CowMap<unsigned int, VarInfo::AllocInfo> &alloctype = varInfo->alloctype;
+    CowMap<unsigned int, std::string> &possibleUsage = varInfo->possibleUsage;
     const std::set<unsigned int> conditionalAlloc(varInfo->conditionalAlloc);
 
     // Parse all tokens
@@ -463,53 +464,62 @@ void CheckLeakAutoVar::checkScope(const Token * const startToken,
                 old.swap(*varInfo);
 
                 std::map<unsigned int, VarInfo::AllocInfo>::const_iterator it;
+                std::set<unsigned int>::const_iterator varId;
 
-                for (it = old.alloctype.begin(); it != old.alloctype.end(); ++it) {
-                    const unsigned int varId = it->first;
-                    if (old.conditionalAlloc.find(varId) == old.conditionalAlloc.end())
+                for (varId = old.conditionalAlloc.begin(); varId != old.conditionalAlloc.end(); ++varId) {
+                    if (old.alloctype.find(*varId) == old.alloctype.end())
                         continue;
-                    if (varInfo1.alloctype.find(varId) == varInfo1.alloctype.end() ||
-                        varInfo2.alloctype.find(varId) == varInfo2.alloctype.end()) {
-                        varInfo1.erase(varId);
-                        varInfo2.erase(varId);
+                    if (varInfo1.alloctype.find(*varId) == varInfo1.alloctype.end() ||
+                        varInfo2.alloctype.find(*varId) == varInfo2.alloctype.end()) {
+                        varInfo1.erase(*varId);
+                        varInfo2.erase(*varId);
                     }
                 }
 
+                // The branches share their state with the old state until they change it,
+                // variables can only be conditionally allocated in a branch that changed it.
+
                 // Conditional allocation in varInfo1
-                for (it = varInfo1.alloctype.begin(); it != varInfo1.alloctype.end(); ++it) {
-                    if (varInfo2.alloctype.find(it->first) == varInfo2.alloctype.end() &&
-                        old.alloctype.find(it->first) == old.alloctype.end()) {
-                        varInfo->conditionalAlloc.insert(it->first);
+                if (!varInfo1.alloctype.shares(old.alloctype) && !varInfo1.alloctype.shares(varInfo2.alloctype)) {
+                    for (it = varInfo1.alloctype.begin(); it != varInfo1.alloctype.end(); ++it) {
+                        if (varInfo2.alloctype.find(it->first) == varInfo2.alloctype.end() &&
+                            old.alloctype.find(it->first) == old.alloctype.end()) {
+                            varInfo->conditionalAlloc.insert(it->first);
+                        }
                     }
                 }
 
                 // Conditional allocation in varInfo2
-                for (it = varInfo2.alloctype.begin(); it != varInfo2.alloctype.end(); ++it) {
-                    if (varInfo1.alloctype.find(it->first) == varInfo1.alloctype.end() &&
-                        old.alloctype.find(it->first) == old.alloctype.end()) {
-                        varInfo->conditionalAlloc.insert(it->first);
+                if (!varInfo2.alloctype.shares(old.alloctype) && !varInfo2.alloctype.shares(varInfo1.alloctype)) {
+                    for (it = varInfo2.alloctype.begin(); it != varInfo2.alloctype.end(); ++it) {
+                        if (varInfo1.alloctype.find(it->first) == varInfo1.alloctype.end() &&
+                            old.alloctype.find(it->first) == old.alloctype.end()) {
+                            varInfo->conditionalAlloc.insert(it->first);
+                        }
                     }
                 }
 
                 // Conditional allocation/deallocation
-                for (it = varInfo1.alloctype.begin(); it != varInfo1.alloctype.end(); ++it) {
-                    if (it->second.managed() && conditionalAlloc.find(it->first) != conditionalAlloc.end()) {
-                        varInfo->conditionalAlloc.erase(it->first);
-                        varInfo2.erase(it->first);
+                for (varId = conditionalAlloc.begin(); varId != conditionalAlloc.end(); ++varId) {
+                    it = varInfo1.alloctype.find(*varId);
+                    if (it != varInfo1.alloctype.end() && it->second.managed()) {
+                        varInfo->conditionalAlloc.erase(*varId);
+                        varInfo2.erase(*varId);
                     }
                 }
-                for (it = varInfo2.alloctype.begin(); it != varInfo2.alloctype.end(); ++it) {
-                    if (it->second.managed() && conditionalAlloc.find(it->first) != conditionalAlloc.end()) {
-                        varInfo->conditionalAlloc.erase(it->first);
-                        varInfo1.erase(it->first);
+                for (varId = conditionalAlloc.begin(); varId != conditionalAlloc.end(); ++varId) {
+                    it = varInfo2.alloctype.find(*varId);
+                    if (it != varInfo2.alloctype.end() && it->second.managed()) {
+                        varInfo->conditionalAlloc.erase(*varId);
+                        varInfo1.erase(*varId);
                     }
                 }
 
-                alloctype.insert(varInfo1.alloctype.begin(), varInfo1.alloctype.end());
-                alloctype.insert(varInfo2.alloctype.begin(), varInfo2.alloctype.end());
+                alloctype.insert(varInfo1.alloctype);
+                alloctype.insert(varInfo2.alloctype);
 
-                possibleUsage.insert(varInfo1.possibleUsage.begin(), varInfo1.possibleUsage.end());
-                possibleUsage.insert(varInfo2.possibleUsage.begin(), varInfo2.possibleUsage.end());
+                possibleUsage.insert(varInfo1.possibleUsage);
+                possibleUsage.insert(varInfo2.possibleUsage);
             }
         }
 
@@ -669,7 +679,7 @@ void CheckLeakAutoVar::checkScope(const Token * const startToken,
 
 const Token * CheckLeakAutoVar::checkTokenInsideExpression(const Token * const tok, VarInfo *varInfo)
 {
-    std::map<unsigned int, VarInfo::AllocInfo> &alloctype = varInfo->alloctype;
+    const CowMap<unsigned int, VarInfo::AllocInfo> &alloctype = varInfo->alloctype;
 
     // Deallocation and then dereferencing pointer..
     if (tok->varId() > 0) {
@@ -705,9 +715,9 @@ const Token * CheckLeakAutoVar::checkTokenInsideExpression(const Token * const t
 
 void CheckLeakAutoVar::changeAllocStatus(VarInfo *varInfo, const VarInfo::AllocInfo& allocation, const Token* tok, const Token* arg)
 {
-    std::map<unsigned int, VarInfo::AllocInfo> &alloctype = varInfo->alloctype;
-    std::map<unsigned int, std::string> &possibleUsage = varInfo->possibleUsage;
-    const std::map<unsigned int, VarInfo::AllocInfo>::iterator var = alloctype.find(arg->varId());
+    CowMap<unsigned int, VarInfo::AllocInfo> &alloctype = varInfo->alloctype;
+    CowMap<unsigned int, std::string> &possibleUsage = varInfo->possibleUsage;
+    const std::map<unsigned int, VarInfo::AllocInfo>::const_iterator var = alloctype.find(arg->varId());
     if (var != alloctype.end()) {
         if (allocation.status == VarInfo::NOALLOC) {
             // possible usage
@@ -722,8 +732,9 @@ void CheckLeakAutoVar::changeAllocStatus(VarInfo *varInfo, const VarInfo::AllocI
             varInfo->erase(arg->varId());
         } else {
             // deallocation
-            var->second.status = allocation.status;
-            var->second.type = allocation.type;
+            VarInfo::AllocInfo &varAlloc = alloctype[arg->varId()];
+            varAlloc.status = allocation.status;
+            varAlloc.type = allocation.type;
         }
     } else if (allocation.status != VarInfo::NOALLOC) {
         alloctype[arg->varId()].status = VarInfo::DEALLOC;
@@ -819,8 +830,8 @@ void CheckLeakAutoVar::functionCall(const Token *tokName, const Token *tokOpenin
 void CheckLeakAutoVar::leakIfAllocated(const Token *vartok,
                                        const VarInfo &varInfo)
 {
-    const std::map<unsigned int, VarInfo::AllocInfo> &alloctype = varInfo.alloctype;
-    const std::map<unsigned int, std::string> &possibleUsage = varInfo.possibleUsage;
+    const CowMap<unsigned int, VarInfo::AllocInfo> &alloctype = varInfo.alloctype;
+    const CowMap<unsigned int, std::string> &possibleUsage = varInfo.possibleUsage;
 
     const std::map<unsigned int, VarInfo::AllocInfo>::const_iterator var = alloctype.find(vartok->varId());
     if (var != alloctype.end() && var->second.status == VarInfo::ALLOC) {
@@ -835,8 +846,8 @@ void CheckLeakAutoVar::leakIfAllocated(const Token *vartok,
 
 void CheckLeakAutoVar::ret(const Token *tok, const VarInfo &varInfo)
 {
-    const std::map<unsigned int, VarInfo::AllocInfo> &alloctype = varInfo.alloctype;
-    const std::map<unsigned int, std::string> &possibleUsage = varInfo.possibleUsage;
+    const CowMap<unsigned int, VarInfo::AllocInfo> &alloctype = varInfo.alloctype;
+    const CowMap<unsigned int, std::string> &possibleUsage = varInfo.possibleUsage;
 
     const SymbolDatabase *symbolDatabase = _tokenizer->getSymbolDatabase();
     for (std::map<unsigned int, VarInfo::AllocInfo>::const_iterator it = alloctype.begin(); it != alloctype.end(); ++it) {
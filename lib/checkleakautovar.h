@@ -27,6 +27,7 @@
 #include "library.h"
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 
@@ -36,6 +37,83 @@ class Token;
 class Tokenizer;
 
 
+/**
+ * std::map with copy-on-write semantic. Copies share the data until one
+ * of them is modified, so copying the state at a branch is cheap.
+ * Only read access is possible through iterators.
+ */
+template<class K, class V>
+class CowMap {
+public:
+    typedef std::map<K, V> Map;
+    typedef typename Map::const_iterator const_iterator;
+    typedef typename Map::size_type size_type;
+
+    CowMap() : _map(std::make_shared<Map>()) {}
+
+    const_iterator begin() const {
+        return _map->begin();
+    }
+    const_iterator end() const {
+        return _map->end();
+    }
+    const_iterator find(const K &key) const {
+        return _map->find(key);
+    }
+    size_type size() const {
+        return _map->size();
+    }
+    bool empty() const {
+        return _map->empty();
+    }
+    /** is the data shared with other? then both maps are equal */
+    bool shares(const CowMap &other) const {
+        return _map == other._map;
+    }
+
+    V &operator[](const K &key) {
+        return modify()[key];
+    }
+    void insert(const std::pair<const K, V> &value) {
+        if (_map->find(value.first) == _map->end())
+            modify().insert(value);
+    }
+    void insert(const_iterator first, const_iterator last) {
+        if (_map->empty() && first == last)
+            return;
+        for (; first != last; ++first)
+            insert(*first);
+    }
+    /** insert all elements of other, existing elements are not changed */
+    void insert(const CowMap &other) {
+        if (_map->empty())
+            _map = other._map;
+        else if (_map != other._map)
+            insert(other.begin(), other.end());
+    }
+    size_type erase(const K &key) {
+        if (_map->find(key) == _map->end())
+            return 0;
+        return modify().erase(key);
+    }
+    void clear() {
+        if (!_map->empty())
+            _map = std::make_shared<Map>();
+    }
+    void swap(CowMap &other) {
+        _map.swap(other._map);
+    }
+
+private:
+    Map &modify() {
+        if (_map.use_count() > 1)
+            _map = std::make_shared<Map>(*_map);
+        return *_map;
+    }
+
+    std::shared_ptr<Map> _map;
+};
+
 class CPPCHECKLIB VarInfo {
 public:
     enum AllocStatus { OWNED = -2, DEALLOC = -1, NOALLOC = 0, ALLOC = 1 };
@@ -52,8 +130,8 @@ public:
             return status < 0;
         }
     };
-    std::map<unsigned int, AllocInfo> alloctype;
-    std::map<unsigned int, std::string> possibleUsage;
+    CowMap<unsigned int, AllocInfo> alloctype;
+    CowMap<unsigned int, std::string> possibleUsage;
     std::set<unsigned int> conditionalAlloc;
     std::set<unsigned int> referenced;
 
@@ -109,6 +187,15 @@ public:
         checkLeakAutoVar.check();
     }
 
+    bool isRelevant(const TokenCensus &census) const override {
+        return census.hasAllocation();
+    }
+
+    /** checkScope() asks IsScopeNoReturn() about calls that might not return */
+    bool isThreadSafe(const Settings *settings) const override {
+        return !settings->checkLibrary;
+    }
+
 private:
 
     /** check for leaks in all scopes */
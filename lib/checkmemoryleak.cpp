@@ -20,6 +20,7 @@
 #include "checkmemoryleak.h"
 
 #include "astutils.h"
+#include "functionsummaries.h"
 #include "library.h"
 #include "mathlib.h"
 #include "settings.h"
@@ -182,13 +183,29 @@ CheckMemoryLeak::AllocType CheckMemoryLeak::getAllocationType(const Token *tok2,
     if (func == nullptr)
         return No;
 
+    // Function that is defined in another TU
+    if (!func->hasBody()) {
+        const FunctionSummaries::Summary *summary = settings1->functionSummaries ? settings1->functionSummaries->find(func) : nullptr;
+        if (summary && summary->returnAllocType > No && summary->returnAllocType < Many)
+            return static_cast<AllocType>(summary->returnAllocType);
+        return No;
+    }
+
     // Prevent recursion
     if (callstack && std::find(callstack->begin(), callstack->end(), func) != callstack->end())
         return No;
 
-    std::list<const Function*> cs;
-    if (!callstack)
-        callstack = &cs;
+    // The result for an outermost call does not depend on the caller, so it
+    // is computed once per function and then reused.
+    if (!callstack) {
+        const std::map<const Function *, AllocType>::const_iterator it = functionReturnTypes.find(func);
+        if (it != functionReturnTypes.end())
+            return it->second;
+        std::list<const Function*> cs(1, func);
+        const AllocType allocType = functionReturnType(func, &cs);
+        functionReturnTypes[func] = allocType;
+        return allocType;
+    }
 
     callstack->push_back(func);
     return functionReturnType(func, callstack);
@@ -2013,6 +2030,189 @@ const Token *CheckMemoryLeakInFunction::findleak(const Token *tokens)
 }
 
 
+namespace {
+    // Allocation states of a variable. A set of states is tracked, one bit per state.
+    enum AllocState { Unallocated = 1, Allocated = 2, Deallocated = 4, Used = 8 };
+
+    /** Problem that the allocation state dataflow found */
+    struct AllocFlowProblem {
+        AllocFlowProblem() : tok(nullptr), deallocDealloc(false), deallocDeallocAllowed(true), leakAllowed(true), loops(0) {}
+
+        /** Leak or second deallocation, nullptr if there is no problem */
+        const Token *tok;
+        bool deallocDealloc;
+
+        /** A deallocation of a deallocated pointer may be reported */
+        bool deallocDeallocAllowed;
+
+        /** A leak may be reported, a function that is called might not return */
+        bool leakAllowed;
+
+        /** Number of loops that the code is in, findleak() handles problems in loops differently */
+        unsigned int loops;
+
+        /** Record a problem, there must only be one */
+        bool set(const Token *t, bool dd) {
+            if (tok || loops > 0U || (dd ? !deallocDeallocAllowed : !leakAllowed))
+                return false;
+            tok = t;
+            deallocDealloc = dd;
+            return true;
+        }
+    };
+}
+
+/** The memory is not released at tok. It is only reported if it is allocated on all paths. */
+static bool leak(unsigned int state, AllocFlowProblem &problem, const Token *tok)
+{
+    return !(state & Unallocated) && problem.set(tok, false);
+}
+
+static bool allocFlowStatement(const Token *&tok, unsigned int &state, AllocFlowProblem &problem);
+
+/** Flow through statements until "}" or the end of the code */
+static bool allocFlowBlock(const Token *&tok, unsigned int &state, AllocFlowProblem &problem)
+{
+    while (tok && tok->str() != "}") {
+        if (!allocFlowStatement(tok, state, problem))
+            return false;
+    }
+    return true;
+}
+
+static bool allocFlowStatement(const Token *&tok, unsigned int &state, AllocFlowProblem &problem)
+{
+    if (tok->str() == ";") {
+        tok = tok->next();
+        return true;
+    }
+
+    if (tok->str() == "{") {
+        tok = tok->next();
+        if (!allocFlowBlock(tok, state, problem) || !tok)
+            return false;
+        tok = tok->next();
+        return true;
+    }
+
+    if (Token::Match(tok, "if|ifv|if(var)|if(!var)")) {
+        // the variable is null in one of the branches of "if(var)" and "if(!var)",
+        // and it might be null in the branches of "ifv"
+        unsigned int nullState = state;
+        if (nullState & (Allocated | Used))
+            nullState = (nullState & ~(Allocated | Used)) | Unallocated;
+        if (tok->str() == "ifv")
+            nullState |= state;
+        unsigned int thenState = (tok->str() == "if(!var)" || tok->str() == "ifv") ? nullState : state;
+        unsigned int elseState = (tok->str() == "if(var)" || tok->str() == "ifv") ? nullState : state;
+        tok = tok->next();
+        if (!tok || !allocFlowStatement(tok, thenState, problem))
+            return false;
+        if (tok && tok->str() == "else") {
+            tok = tok->next();
+            if (!tok || !allocFlowStatement(tok, elseState, problem))
+                return false;
+        }
+        state = thenState | elseState;
+        return true;
+    }
+
+    if (tok->str() == "loop") {
+        // The body is executed any number of times. The states are joined
+        // until they don't change, there are only a few states.
+        const Token * const body = tok->next();
+        if (!body)
+            return false;
+        ++problem.loops;
+        for (;;) {
+            tok = body;
+            unsigned int bodyState = state;
+            if (!allocFlowStatement(tok, bodyState, problem))
+                return false;
+            if ((state | bodyState) == state)
+                break;
+            state |= bodyState;
+        }
+        --problem.loops;
+        return true;
+    }
+
+    // simple statement. A leak is only reported if the memory is allocated
+    // on all paths, and a deallocation of a deallocated pointer if it is
+    // deallocated on all paths.
+    const Token *returnTok = nullptr;
+    bool isExit = false;
+    for (; tok && tok->str() != ";"; tok = tok->next()) {
+        const std::string &str = tok->str();
+        if (str == "alloc") {
+            if (state & Used)
+                return false;
+            if ((state & Allocated) && !leak(state, problem, tok))
+                return false;
+            if (state)
+                state = Allocated;
+        } else if (str == "dealloc") {
+            if ((state & Deallocated) && (state != Deallocated || !problem.set(tok, true)))
+                return false;
+            if (state)
+                state = Deallocated;
+        } else if (str == "use") {
+            if (state & Deallocated)
+                return false;
+            if (state & Allocated)
+                state = (state & ~Allocated) | Used;
+        } else if (str == "assign") {
+            if (state & Used)
+                return false;
+            if ((state & Allocated) && !leak(state, problem, tok))
+                return false;
+            if (state)
+                state = Unallocated;
+        } else if (str == "return") {
+            returnTok = tok;
+        } else if (str == "exit") {
+            isExit = true;
+        } else if (str == "callfunc") {
+            if (state & Allocated)
+                problem.leakAllowed = false;
+        } else {
+            return false;
+        }
+    }
+    if (!tok)
+        return false;
+    tok = tok->next();
+
+    if (isExit) {
+        state = 0;
+    } else if (returnTok) {
+        if ((state & Allocated) && !leak(state, problem, returnTok))
+            return false;
+        state = 0;
+    }
+    return true;
+}
+
+bool CheckMemoryLeakInFunction::allocFlow(const Token *tokens, bool deallocDeallocAllowed, const Token **problemTok, bool *deallocDealloc)
+{
+    AllocFlowProblem problem;
+    problem.deallocDeallocAllowed = deallocDeallocAllowed;
+    unsigned int state = Unallocated;
+    const Token *tok = tokens;
+    if (!allocFlowBlock(tok, state, problem))
+        return false;
+
+    // the code must end with the "}" of the scope
+    if (!tok || tok->next())
+        return false;
+    if ((state & Allocated) && !leak(state, problem, tok))
+        return false;
+
+    *problemTok = problem.tok;
+    *deallocDealloc = problem.deallocDealloc;
+    return true;
+}
+
 // Check for memory leaks for a function variable.
 void CheckMemoryLeakInFunction::checkScope(const Token *startTok, const std::string &varname, unsigned int varid, bool classmember, unsigned int sz)
 {
@@ -2064,6 +2264,18 @@ void CheckMemoryLeakInFunction::checkScope(const Token *startTok, const std::str
         return;
     }
 
+    // The code only needs to be simplified if the dataflow can't handle it
+    const Token *problemTok = nullptr;
+    bool deallocDealloc = false;
+    if (!_settings->debugwarnings && !(_settings->debug && _settings->verbose) && allocFlow(tok, !use_addr, &problemTok, &deallocDealloc)) {
+        if (problemTok && deallocDealloc)
+            deallocDeallocError(problemTok, varname);
+        else if (problemTok)
+            memoryLeak(problemTok, varname, alloctype);
+        TokenList::deleteTokens(tok);
+        return;
+    }
+
     simplifycode(tok);
 
     if (_settings->debug && _settings->verbose) {
@@ -38,6 +38,7 @@
 #include "tokenize.h"
 
 #include <list>
+#include <map>
 #include <string>
 
 class Function;
@@ -158,6 +159,10 @@ public:
 
     /** Function allocates pointed-to argument (a la asprintf)? */
     const char *functionArgAlloc(const Function *func, unsigned int targetpar, AllocType &allocType) const;
+
+private:
+    /** Cached return allocation type of user functions, see getAllocationType() */
+    mutable std::map<const Function *, AllocType> functionReturnTypes;
 };
 
 /// @}
@@ -201,6 +206,15 @@ public:
         checkMemoryLeak.check();
     }
 
+    bool isRelevant(const TokenCensus &census) const override {
+        return census.hasAllocation();
+    }
+
+    /** checkReallocUsage() asks IsScopeNoReturn() about the failure handling of realloc */
+    bool isThreadSafe(const Settings *settings) const override {
+        return !settings->checkLibrary;
+    }
+
     /** @brief Unit testing : testing the white list */
     static bool test_white_list(const std::string &funcname, const Settings *settings, bool cpp);
 
@@ -276,6 +290,16 @@ public:
 
     static const Token *findleak(const Token *tokens);
 
+    /**
+     * Allocation state dataflow over the code generated by getcode().
+     * @param tokens code generated by getcode()
+     * @param deallocDeallocAllowed report the deallocation of a deallocated pointer
+     * @param problemTok gets the token of the leak or of the second deallocation, nullptr if there is none
+     * @param deallocDealloc gets true if the problem is a second deallocation
+     * @return false if the code can't be analysed, then simplifycode() and findleak() must be used
+     */
+    static bool allocFlow(const Token *tokens, bool deallocDeallocAllowed, const Token **problemTok, bool *deallocDealloc);
+
     /**
      * Checking the variable varname
      * @param startTok start token
@@ -344,6 +368,10 @@ public:
         checkMemoryLeak.check();
     }
 
+    bool isRelevant(const TokenCensus &census) const override {
+        return census.hasAllocation();
+    }
+
     void check();
 
 private:
@@ -388,6 +416,10 @@ public:
         checkMemoryLeak.check();
     }
 
+    bool isRelevant(const TokenCensus &census) const override {
+        return census.hasAllocation();
+    }
+
     void check();
 
 private:
@@ -427,6 +459,10 @@ public:
         checkMemoryLeak.check();
     }
 
+    bool isRelevant(const TokenCensus &census) const override {
+        return census.hasAllocation();
+    }
+
     void check();
 
 private:
@@ -21,6 +21,7 @@
 #include "checknullpointer.h"
 
 #include "errorlogger.h"
+#include "functionsummaries.h"
 #include "library.h"
 #include "settings.h"
 #include "symboldatabase.h"
@@ -33,6 +34,8 @@
 #include <cctype>
 #include <cstddef>
 #include <set>
+#include <utility>
+#include <vector>
 //---------------------------------------------------------------------------
 
 // Register this check class (by creating a static instance of it)
@@ -56,7 +59,7 @@ static bool checkNullpointerFunctionCallPlausibility(const Function* func, unsig
  * @param var variables that the function read / write.
  * @param library --library files data
  */
-void CheckNullPointer::parseFunctionCall(const Token &tok, std::list<const Token *> &var, const Library *library)
+void CheckNullPointer::parseFunctionCall(const Token &tok, std::list<const Token *> &var, const Library *library, const FunctionSummaries *functionSummaries)
 {
     if (Token::Match(&tok, "%name% ( )") || !tok.tokAt(2))
         return;
@@ -69,11 +72,15 @@ void CheckNullPointer::parseFunctionCall(const Token &tok, std::list<const Token
         var.push_back(firstParam);
 
     if (library || tok.function() != nullptr) {
+        // function of another TU that dereferences arguments
+        const FunctionSummaries::Summary *summary = (functionSummaries && tok.function() && !tok.function()->hasBody()) ? functionSummaries->find(tok.function()) : nullptr;
         const Token *param = firstParam;
         int argnr = 1;
         while (param) {
             if (library && library->isnullargbad(&tok, argnr) && checkNullpointerFunctionCallPlausibility(tok.function(), argnr))
                 var.push_back(param);
+            else if (summary && summary->nullArgBad.find(argnr) != summary->nullArgBad.end())
+                var.push_back(param);
             else if (tok.function()) {
                 const Variable* argVar = tok.function()->getArgumentVar(argnr-1);
                 if (argVar && argVar->isStlStringType() && !argVar->isArrayOrPointer())
@@ -249,6 +256,71 @@ bool CheckNullPointer::isPointerDeRef(const Token *tok, bool &unknown)
 }
 
 
+/** Value of the condition when the pointer is null: 1 true, 0 false, -1 unknown */
+static int conditionValueWhenNull(const Token *condition, unsigned int varid)
+{
+    if (!condition)
+        return -1;
+    if (condition->varId() == varid)
+        return 0;
+    if (condition->str() == "!" && condition->astOperand1() && condition->astOperand1()->varId() == varid)
+        return 1;
+    if (Token::Match(condition, "==|!=") && condition->astOperand1() && condition->astOperand2()) {
+        const Token *vartok = condition->astOperand1();
+        const Token *zerotok = condition->astOperand2();
+        if (vartok->str() == "0")
+            std::swap(vartok, zerotok);
+        if (vartok->varId() == varid && zerotok->str() == "0")
+            return (condition->str() == "==") ? 1 : 0;
+    }
+    if (condition->str() == "&&" && (conditionValueWhenNull(condition->astOperand1(), varid) == 0 || conditionValueWhenNull(condition->astOperand2(), varid) == 0))
+        return 0;
+    if (condition->str() == "||" && (conditionValueWhenNull(condition->astOperand1(), varid) == 1 || conditionValueWhenNull(condition->astOperand2(), varid) == 1))
+        return 1;
+    return -1;
+}
+
+/**
+ * Can the target token be reached from the block while the pointer is still
+ * null? Paths where the pointer is assigned are not followed, conditions that
+ * test the pointer are only followed in the direction where it is null.
+ */
+static bool isReachedWhileNull(const ControlFlowGraph &cfg, std::size_t start, const Token *target, unsigned int varid)
+{
+    const std::vector<ControlFlowGraph::Block> &blocks = cfg.blocks();
+    std::vector<bool> visited(blocks.size(), false);
+    std::vector<std::size_t> worklist(1, start);
+    visited[start] = true;
+    while (!worklist.empty()) {
+        const ControlFlowGraph::Block &block = blocks[worklist.back()];
+        worklist.pop_back();
+
+        // the assignment takes effect at the end of the statement
+        bool assigned = false;
+        for (const Token *tok = block.start; tok && tok != block.end && !(assigned && tok->str() == ";"); tok = tok->next()) {
+            if (tok == target)
+                return true;
+            if (Token::Match(tok, "%varid% =", varid))
+                assigned = true;
+        }
+        if (assigned)
+            continue;
+
+        // conditions of if/while are blocks that end with the ")", the first successor is the true branch
+        int value = -1;
+        if (block.successors.size() == 2U && block.end && block.end->str() == ")" && Token::Match(block.end->link()->previous(), "if|while ("))
+            value = conditionValueWhenNull(block.end->link()->astOperand2(), varid);
+        for (std::size_t i = 0; i < block.successors.size(); ++i) {
+            const std::size_t s = block.successors[i];
+            if ((value == 1 && i != 0) || (value == 0 && i != 1) || visited[s])
+                continue;
+            visited[s] = true;
+            worklist.push_back(s);
+        }
+    }
+    return false;
+}
+
 void CheckNullPointer::nullPointerLinkedList()
 {
 
@@ -269,6 +341,16 @@ void CheckNullPointer::nullPointerLinkedList()
         if (i->type != Scope::eFor || !tok1)
             continue;
 
+        // control flow graph of the function
+        const Scope *functionScope = i->nestedIn;
+        while (functionScope && functionScope->isExecutable() && functionScope->type != Scope::eFunction && functionScope->type != Scope::eLambda)
+            functionScope = functionScope->nestedIn;
+        if (!functionScope || functionScope->type != Scope::eFunction)
+            continue;
+        const ControlFlowGraph *cfg = symbolDatabase->getControlFlowGraph(functionScope);
+        if (!cfg || cfg->hasUnknownFlow())
+            continue;
+
         // is there any dereferencing occurring in the for statement
         const Token* end2 = tok1->linkAt(1);
         for (const Token *tok2 = tok1->tokAt(2); tok2 != end2; tok2 = tok2->next()) {
@@ -293,22 +375,18 @@ void CheckNullPointer::nullPointerLinkedList()
                         continue;
 
                     // TODO: are there false negatives for "while ( %varid% ||"
-                    if (Token::Match(scope->classDef->next(), "( %varid% &&|)", varid)) {
-                        // Make sure there is a "break" or "return" inside the loop.
-                        // Without the "break" a null pointer could be dereferenced in the
-                        // for statement.
-                        for (const Token *tok4 = scope->bodyStart; tok4; tok4 = tok4->next()) {
-                            if (tok4 == i->bodyEnd) {
+                    if (!Token::Match(scope->classDef->next(), "( %varid% &&|)", varid))
+                        continue;
+
+                    // Is the dereference reached when the loop ends because the pointer is null?
+                    const std::vector<ControlFlowGraph::Block> &blocks = cfg->blocks();
+                    for (std::size_t b = 0; b < blocks.size(); ++b) {
+                        if (blocks[b].end == scope->classDef->linkAt(1) && blocks[b].successors.size() == 2U) {
+                            if (isReachedWhileNull(*cfg, blocks[b].successors[1], tok2, varid)) {
                                 const ValueFlow::Value v(scope->classDef, 0LL);
                                 nullPointerError(tok1, var->name(), &v, false);
-                                break;
                             }
-
-                            // There is a "break" or "return" inside the loop.
-                            // TODO: there can be false negatives. There could still be
-                            //       execution paths that are not properly terminated
-                            else if (tok4->str() == "break" || tok4->str() == "return")
-                                break;
+                            break;
                         }
                     }
                 }
@@ -350,7 +428,7 @@ void CheckNullPointer::nullPointerByDeRefAndChec()
             if (!ftok || !ftok->previous())
                 continue;
             std::list<const Token *> varlist;
-            parseFunctionCall(*ftok->previous(), varlist, &_settings->library);
+            parseFunctionCall(*ftok->previous(), varlist, &_settings->library, _settings->functionSummaries.get());
             if (std::find(varlist.begin(), varlist.end(), tok) != varlist.end()) {
                 nullPointerError(tok, tok->str(), value, value->isInconclusive());
             }
@@ -418,7 +496,7 @@ void CheckNullPointer::nullConstantDereference()
                         nullPointerError(tok);
                 } else { // function call
                     std::list<const Token *> var;
-                    parseFunctionCall(*tok, var, &_settings->library);
+                    parseFunctionCall(*tok, var, &_settings->library, _settings->functionSummaries.get());
 
                     // is one of the var items a NULL pointer?
                     for (std::list<const Token *>::const_iterator it = var.begin(); it != var.end(); ++it) {
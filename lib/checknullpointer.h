@@ -30,6 +30,7 @@
 #include <string>
 
 class ErrorLogger;
+class FunctionSummaries;
 class Library;
 class Settings;
 class Token;
@@ -71,10 +72,12 @@ public:
      * @param tok first token
      * @param var variables that the function read / write.
      * @param library --library files data
+     * @param functionSummaries summaries of the functions of other TUs
      */
     static void parseFunctionCall(const Token &tok,
                                   std::list<const Token *> &var,
-                                  const Library *library);
+                                  const Library *library,
+                                  const FunctionSummaries *functionSummaries = nullptr);
 
     /**
      * Is there a pointer dereference? Everything that should result in
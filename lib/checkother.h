@@ -104,6 +104,11 @@ public:
         checkOther.checkAccessOfMovedVariable();
     }
 
+    /** checkRedundantAssignment() asks IsScopeNoReturn() about functions called in a switch */
+    bool isThreadSafe(const Settings *settings) const override {
+        return !settings->checkLibrary;
+    }
+
     /** @brief Clarify calculation for ".. a * b ? .." */
     void clarifyCalculation();
 
@@ -23,6 +23,7 @@
 #include "astutils.h"
 #include "checknullpointer.h"   // CheckNullPointer::isPointerDeref
 #include "errorlogger.h"
+#include "functionsummaries.h"
 #include "library.h"
 #include "mathlib.h"
 #include "settings.h"
@@ -33,12 +34,14 @@
 
 #include <tinyxml2.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <list>
 #include <map>
 #include <stack>
 #include <utility>
+#include <vector>
 //---------------------------------------------------------------------------
 
 // Register this check class (by creating a static instance of it)
@@ -129,7 +132,7 @@ void CheckUninitVar::checkScope(const Scope* scope, const std::set<std::string>
             checkScopeForVariable(tok, *i, nullptr, nullptr, &alloc, emptyString, variableValue);
             continue;
         }
-        if (stdtype || i->isPointer()) {
+        if ((stdtype || i->isPointer()) && !checkAssignmentDataflow(*i)) {
             Alloc alloc = NO_ALLOC;
             const std::map<unsigned int, VariableValue> variableValue;
             checkScopeForVariable(tok, *i, nullptr, nullptr, &alloc, emptyString, variableValue);
@@ -199,6 +202,200 @@ void CheckUninitVar::checkStruct(const Token *tok, const Variable &structvar)
     }
 }
 
+/** Function scope of a variable, nullptr if the variable is declared in a class or lambda inside the function */
+static const Scope *functionScopeOf(const Variable &var)
+{
+    const Scope *scope = var.scope();
+    while (scope && scope->type != Scope::eFunction) {
+        if (!scope->isExecutable() || scope->type == Scope::eLambda)
+            return nullptr;
+        scope = scope->nestedIn;
+    }
+    return scope;
+}
+
+/** Plain local variable of a standard type that is declared without initialization */
+static bool isPlainUninitializedVariable(const Variable &var)
+{
+    return var.isLocal() && !var.isStatic() && !var.isExtern() && !var.isReference() &&
+           !var.isPointer() && !var.isArray() && !var.type() &&
+           var.typeStartToken() == var.typeEndToken() && var.typeStartToken()->isStandardType() &&
+           Token::Match(var.nameToken(), "%name% ;");
+}
+
+namespace {
+    /**
+     * Forward assignment dataflow for many variables at once, each variable
+     * is a bit in the state. For each variable it is tracked whether it is
+     * assigned on every path and whether it is assigned on some path.
+     * Assignments take effect at the end of the statement so "x = x + 1;"
+     * is a usage of uninitialized x.
+     */
+    class AssignmentDataflow {
+    public:
+        AssignmentDataflow(const ControlFlowGraph &cfg, const std::map<unsigned int, std::size_t> &bits, const std::set<const Token *> &reads)
+            : _cfg(cfg), _bits(bits), _reads(reads) {
+        }
+
+        /**
+         * Run the dataflow.
+         * @param occurrences number of occurrences of each variable in the function
+         * @param unsafe gets the variables that might be used before they are assigned
+         * @param unknown gets the unsafe variables that are not only read where they are not assigned on any path
+         * @param uninitialized gets the reads of variables that are not assigned on any path
+         */
+        void run(std::map<unsigned int, unsigned int> occurrences, std::set<unsigned int> *unsafe, std::set<unsigned int> *unknown, std::set<const Token *> *uninitialized) const {
+            const std::vector<ControlFlowGraph::Block> &blocks = _cfg.blocks();
+
+            // blocks that can be reached from the entry
+            std::vector<bool> reachable(blocks.size(), false);
+            std::vector<std::size_t> worklist(1, ControlFlowGraph::Entry);
+            reachable[ControlFlowGraph::Entry] = true;
+            while (!worklist.empty()) {
+                const std::size_t b = worklist.back();
+                worklist.pop_back();
+                for (std::size_t i = 0; i < blocks[b].successors.size(); ++i) {
+                    const std::size_t s = blocks[b].successors[i];
+                    if (!reachable[s]) {
+                        reachable[s] = true;
+                        worklist.push_back(s);
+                    }
+                }
+            }
+
+            // fixpoint, a variable is assigned on every path if it is assigned at the end of
+            // all predecessors and it is assigned on some path if it is assigned at the end of any
+            std::vector<State> out(blocks.size(), State(_bits.size()));
+            for (std::size_t b = 0; b < blocks.size(); ++b) {
+                if (reachable[b])
+                    worklist.push_back(b);
+            }
+            std::vector<bool> queued(blocks.size(), false);
+            for (std::size_t i = 0; i < worklist.size(); ++i)
+                queued[worklist[i]] = true;
+            while (!worklist.empty()) {
+                const std::size_t b = worklist.back();
+                worklist.pop_back();
+                queued[b] = false;
+                State state = in(b, out, reachable);
+                transfer(blocks[b], state, nullptr, nullptr, nullptr, nullptr);
+                if (state == out[b])
+                    continue;
+                out[b] = state;
+                for (std::size_t i = 0; i < blocks[b].successors.size(); ++i) {
+                    const std::size_t s = blocks[b].successors[i];
+                    if (!queued[s]) {
+                        queued[s] = true;
+                        worklist.push_back(s);
+                    }
+                }
+            }
+
+            for (std::size_t b = 0; b < blocks.size(); ++b) {
+                State state(_bits.size());
+                if (reachable[b])
+                    state = in(b, out, reachable);
+                else {
+                    state.all.assign(_bits.size(), false);
+                    state.any.assign(_bits.size(), true);
+                }
+                transfer(blocks[b], state, &occurrences, unsafe, unknown, uninitialized);
+            }
+
+            // variables that are used outside the blocks are not handled
+            for (std::map<unsigned int, unsigned int>::const_iterator it = occurrences.begin(); it != occurrences.end(); ++it) {
+                if (it->second != 0) {
+                    unsafe->insert(it->first);
+                    unknown->insert(it->first);
+                }
+            }
+        }
+
+    private:
+        struct State {
+            explicit State(std::size_t size) : all(size, true), any(size, false) {}
+            bool operator==(const State &other) const {
+                return all == other.all && any == other.any;
+            }
+
+            /** variable is assigned on every path */
+            std::vector<bool> all;
+
+            /** variable is assigned on some path */
+            std::vector<bool> any;
+        };
+
+        State in(std::size_t b, const std::vector<State> &out, const std::vector<bool> &reachable) const {
+            const ControlFlowGraph::Block &block = _cfg.blocks()[b];
+            State state(_bits.size());
+            for (std::size_t i = 0; i < block.predecessors.size(); ++i) {
+                const std::size_t p = block.predecessors[i];
+                if (!reachable[p])
+                    continue;
+                for (std::size_t bit = 0; bit < _bits.size(); ++bit) {
+                    if (!out[p].all[bit])
+                        state.all[bit] = false;
+                    if (out[p].any[bit])
+                        state.any[bit] = true;
+                }
+            }
+            return state;
+        }
+
+        void transfer(const ControlFlowGraph::Block &block, State &state, std::map<unsigned int, unsigned int> *occurrences, std::set<unsigned int> *unsafe, std::set<unsigned int> *unknown, std::set<const Token *> *uninitialized) const {
+            std::vector<std::size_t> assigned;
+            for (const Token *tok = block.start; tok && tok != block.end; tok = tok->next()) {
+                if (tok->str() == ";") {
+                    for (std::size_t i = 0; i < assigned.size(); ++i)
+                        state.all[assigned[i]] = state.any[assigned[i]] = true;
+                    assigned.clear();
+                    continue;
+                }
+                if (tok->varId() == 0)
+                    continue;
+                const std::map<unsigned int, std::size_t>::const_iterator it = _bits.find(tok->varId());
+                if (it == _bits.end())
+                    continue;
+                const std::size_t bit = it->second;
+                if (occurrences)
+                    --(*occurrences)[tok->varId()];
+                if (tok->variable() && tok == tok->variable()->nameToken()) {
+                    state.all[bit] = state.any[bit] = false;
+                    continue;
+                }
+                if (tok->next()->str() == "=" && tok->next()->astOperand1() == tok) {
+                    assigned.push_back(bit);
+                    continue;
+                }
+                bool read = _reads.find(tok) != _reads.end();
+                if (read && std::find(assigned.begin(), assigned.end(), bit) != assigned.end()) {
+                    // "x = f(), x" is handled as in the path-sensitive walk where x is assigned
+                    const Token *parent = tok->astParent();
+                    while (parent && !(parent->str() == "=" && parent->astOperand1() && parent->astOperand1()->varId() == tok->varId()))
+                        parent = parent->astParent();
+                    read = (parent != nullptr);
+                }
+                if (unsafe && !state.all[bit]) {
+                    unsafe->insert(tok->varId());
+                    if (read && !state.any[bit])
+                        uninitialized->insert(tok);
+                    else
+                        unknown->insert(tok->varId());
+                }
+                // the variable might be assigned through a pointer or reference
+                if (!read)
+                    state.any[bit] = true;
+            }
+            for (std::size_t i = 0; i < assigned.size(); ++i)
+                state.all[assigned[i]] = state.any[assigned[i]] = true;
+        }
+
+        const ControlFlowGraph &_cfg;
+        const std::map<unsigned int, std::size_t> &_bits;
+        const std::set<const Token *> &_reads;
+    };
+}
+
 static VariableValue operator!(VariableValue v)
 {
     v.notEqual = !v.notEqual;
@@ -294,6 +491,121 @@ static void conditionAlwaysTrueOrFalse(const Token *tok, const std::map<unsigned
     }
 }
 
+/**
+ * Does the path-sensitive walk bail out for code in the function or can it
+ * rule out paths by the values of the conditions? Then the dataflow is only
+ * used to prove that variables are assigned before they are used.
+ */
+static bool walkBailsOutOrPrunesPaths(const Scope *functionScope)
+{
+    std::set<unsigned int> constantVars;
+    for (const Token *tok = functionScope->bodyStart; tok != functionScope->bodyEnd; tok = tok->next()) {
+        if (Token::Match(tok, "asm|setjmp (") || Token::simpleMatch(tok, "( {"))
+            return true;
+        if (Token::Match(tok, "%name% {") && !Token::Match(tok, "else|do|try"))
+            return true;
+        if (Token::Match(tok, "[;{}] %name% :") && !Token::Match(tok->next(), "default|public|protected|private"))
+            return true;
+        if (Token::Match(tok, "[;{}.] %var% = %num% ;") || Token::Match(tok, "[;{}.] %var% = - %name% ;"))
+            constantVars.insert(tok->next()->varId());
+    }
+    for (const Token *tok = functionScope->bodyStart; tok != functionScope->bodyEnd; tok = tok->next()) {
+        if (!Token::simpleMatch(tok, "if ("))
+            continue;
+        bool alwaysTrue = false;
+        bool alwaysFalse = false;
+        conditionAlwaysTrueOrFalse(tok->next()->astOperand2(), std::map<unsigned int, VariableValue>(), &alwaysTrue, &alwaysFalse);
+        if (alwaysTrue || alwaysFalse)
+            return true;
+        for (const Token *tok2 = tok->next(); tok2 != tok->next()->link(); tok2 = tok2->next()) {
+            if (tok2->varId() && constantVars.find(tok2->varId()) != constantVars.end())
+                return true;
+        }
+    }
+    return false;
+}
+
+/** Is the variable read by an expression that is always evaluated? */
+static bool isUnconditionalRead(const Token *vartok)
+{
+    for (const Token *parent = vartok->astParent(); parent; parent = parent->astParent()) {
+        if (Token::Match(parent, "&&|%oror%|?|:"))
+            return false;
+        if (parent->str() == "(" && Token::Match(parent->previous(), "sizeof|typeof|offsetof|decltype|__alignof__"))
+            return false;
+    }
+    return true;
+}
+
+bool CheckUninitVar::checkAssignmentDataflow(const Variable &var)
+{
+    if (!isPlainUninitializedVariable(var))
+        return false;
+    const Scope *functionScope = functionScopeOf(var);
+    if (!functionScope || var.scope()->type == Scope::eFor)
+        return false;
+
+    std::map<const Scope *, std::map<unsigned int, std::vector<const Token *> > >::const_iterator cached = _assignmentDataflow.find(functionScope);
+    if (cached == _assignmentDataflow.end()) {
+        std::map<unsigned int, std::vector<const Token *> > &result = _assignmentDataflow[functionScope];
+        const ControlFlowGraph *cfg = _tokenizer->getSymbolDatabase()->getControlFlowGraph(functionScope);
+        if (!cfg || cfg->hasUnknownFlow() || functionScope->hasInlineOrLambdaFunction())
+            return false;
+
+        // One bit for each plain variable in the function
+        std::map<unsigned int, std::size_t> bits;
+        std::map<unsigned int, unsigned int> occurrences;
+        for (const Token *tok = functionScope->bodyStart; tok != functionScope->bodyEnd; tok = tok->next()) {
+            if (tok->varId() == 0 || !tok->variable())
+                continue;
+            const Variable *v = tok->variable();
+            if (tok == v->nameToken() && isPlainUninitializedVariable(*v) && functionScopeOf(*v) == functionScope)
+                bits.insert(std::make_pair(tok->varId(), bits.size()));
+            ++occurrences[tok->varId()];
+        }
+        for (std::map<unsigned int, unsigned int>::iterator it = occurrences.begin(); it != occurrences.end();) {
+            if (bits.find(it->first) == bits.end())
+                occurrences.erase(it++);
+            else
+                ++it;
+        }
+        if (bits.empty())
+            return false;
+
+        // Occurrences that the path-sensitive walk would report as usage
+        std::set<const Token *> reads;
+        const bool report = !walkBailsOutOrPrunesPaths(functionScope);
+        for (const Token *tok = functionScope->bodyStart; report && tok != functionScope->bodyEnd; tok = tok->next()) {
+            if (tok->varId() && bits.find(tok->varId()) != bits.end() && tok != tok->variable()->nameToken() &&
+                isUnconditionalRead(tok) && isVariableUsage(tok, false, NO_ALLOC))
+                reads.insert(tok);
+        }
+
+        std::set<unsigned int> unsafe, unknown;
+        std::set<const Token *> uninitialized;
+        AssignmentDataflow(*cfg, bits, reads).run(occurrences, &unsafe, &unknown, &uninitialized);
+        for (std::map<unsigned int, std::size_t>::const_iterator it = bits.begin(); it != bits.end(); ++it) {
+            if (unsafe.find(it->first) == unsafe.end())
+                result[it->first];
+            else if (unknown.find(it->first) == unknown.end()) {
+                std::vector<const Token *> &usages = result[it->first];
+                for (const Token *tok = functionScope->bodyStart; tok != functionScope->bodyEnd; tok = tok->next()) {
+                    if (tok->varId() == it->first && uninitialized.find(tok) != uninitialized.end())
+                        usages.push_back(tok);
+                }
+            }
+        }
+        cached = _assignmentDataflow.find(functionScope);
+    }
+
+    const std::map<unsigned int, std::vector<const Token *> >::const_iterator it = cached->second.find(var.declarationId());
+    if (it == cached->second.end())
+        return false;
+    for (std::size_t i = 0; i < it->second.size(); ++i)
+        uninitvarError(it->second[i], var.name());
+    return true;
+}
+
 static bool isVariableUsed(const Token *tok, const Variable& var)
 {
     if (!tok)
@@ -1067,6 +1379,11 @@ int CheckUninitVar::isFunctionParUsage(const Token *vartok, bool pointer, Alloc
         // check how function handle uninitialized data arguments..
         const Function *func = start->previous()->function();
         if (func) {
+            // function of another TU that reads the data of a pointer argument
+            const FunctionSummaries::Summary *summary = (_settings->functionSummaries && !func->hasBody()) ? _settings->functionSummaries->find(func) : nullptr;
+            if (summary && (address || array || alloc != NO_ALLOC) && summary->uninitArgBad.find(argumentNumber + 1) != summary->uninitArgBad.end())
+                return 1;
+
             const Variable *arg = func->getArgumentVar(argumentNumber);
             if (arg) {
                 const Token *argStart = arg->typeStartToken();
@@ -25,8 +25,10 @@
 #include "check.h"
 #include "config.h"
 
+#include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 class ErrorLogger;
 class Scope;
@@ -67,10 +69,24 @@ public:
         checkUninitVar.valueFlowUninit();
     }
 
+    /** checkScopeForVariable() asks IsScopeNoReturn() at the end of each scope */
+    bool isThreadSafe(const Settings *settings) const override {
+        return !settings->checkLibrary;
+    }
+
     /** Check for uninitialized variables */
     void check();
     void checkScope(const Scope* scope, const std::set<std::string> &arrayTypeDefs);
     void checkStruct(const Token *tok, const Variable &structvar);
+
+    /**
+     * Check the plain local variable with an assignment dataflow. All such
+     * variables of a function are analysed together in one pass over the
+     * control flow graph of the function. Usages of a variable that is not
+     * assigned on any path are reported.
+     * @return false if the dataflow can't handle the variable, then checkScopeForVariable() must be used
+     */
+    bool checkAssignmentDataflow(const Variable &var);
     enum Alloc { NO_ALLOC, NO_CTOR_CALL, CTOR_CALL, ARRAY };
     bool checkScopeForVariable(const Token *tok, const Variable& var, bool* const possibleInit, bool* const noreturn, Alloc* const alloc, const std::string &membervar, std::map<unsigned int, VariableValue> variableValue);
     bool checkIfForWhileHead(const Token *startparentheses, const Variable& var, bool suppressErrors, bool isuninit, Alloc alloc, const std::string &membervar);
@@ -100,6 +116,9 @@ public:
     void uninitStructMemberError(const Token *tok, const std::string &membername);
 
 private:
+    /** function scope => variable => usages where it is not assigned. Variables that the dataflow can't handle are not in the map. */
+    std::map<const Scope *, std::map<unsigned int, std::vector<const Token *> > > _assignmentDataflow;
+
     void getErrorMessages(ErrorLogger *errorLogger, const Settings *settings) const override {
         CheckUninitVar c(nullptr, settings, errorLogger);
 
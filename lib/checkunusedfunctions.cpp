@@ -33,7 +33,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <istream>
+#include <mutex>
+#include <sstream>
 #include <utility>
+#include <vector>
 //---------------------------------------------------------------------------
 
 
@@ -41,6 +44,9 @@
 // Register this check class
 CheckUnusedFunctions CheckUnusedFunctions::instance;
 
+/** Protects the instance when several files are checked in threads */
+static std::mutex instanceMutex;
+
 static const struct CWE CWE561(561U);   // Dead Code
 
 
@@ -288,8 +294,17 @@ static bool isOperatorFunction(const std::string & funcName)
 
 bool CheckUnusedFunctions::check(ErrorLogger * const errorLogger, const Settings& settings)
 {
+    // Report the functions in order of their names
+    std::vector<std::unordered_map<std::string, FunctionUsage>::const_iterator> functions;
+    functions.reserve(_functions.size());
+    for (std::unordered_map<std::string, FunctionUsage>::const_iterator it = _functions.begin(); it != _functions.end(); ++it)
+        functions.push_back(it);
+    std::sort(functions.begin(), functions.end(), [](std::unordered_map<std::string, FunctionUsage>::const_iterator a, std::unordered_map<std::string, FunctionUsage>::const_iterator b) {
+        return a->first < b->first;
+    });
+
     bool errors = false;
-    for (std::map<std::string, FunctionUsage>::const_iterator it = _functions.begin(); it != _functions.end(); ++it) {
+    for (std::unordered_map<std::string, FunctionUsage>::const_iterator it : functions) {
         const FunctionUsage &func = it->second;
         if (func.usedOtherFile || func.filename.empty())
             continue;
@@ -341,11 +356,68 @@ Check::FileInfo *CheckUnusedFunctions::getFileInfo(const Tokenizer *tokenizer, c
 {
     if (!settings->isEnabled(Settings::UNUSED_FUNCTION))
         return nullptr;
-    if (settings->jobs == 1 && settings->buildDir.empty())
+    if (settings->buildDir.empty()) {
+        // With -j each file is checked in its own process, which sends
+        // the summary() of the instance to the main process.
+        std::lock_guard<std::mutex> lock(instanceMutex);
         instance.parseTokens(*tokenizer, tokenizer->list.getFiles().front().c_str(), settings);
+    }
     return nullptr;
 }
 
+std::string CheckUnusedFunctions::summary() const
+{
+    // One line for each declaration and call:
+    // d<tab>line<tab>name<tab>file
+    // c<tab>name
+    std::ostringstream ret;
+    for (std::unordered_map<std::string, FunctionUsage>::const_iterator it = _functions.begin(); it != _functions.end(); ++it) {
+        if (!it->second.filename.empty())
+            ret << "d\t" << it->second.lineNumber << '\t' << it->first << '\t' << it->second.filename << '\n';
+    }
+    for (std::set<std::string>::const_iterator it = _functionCalls.begin(); it != _functionCalls.end(); ++it)
+        ret << "c\t" << *it << '\n';
+    return ret.str();
+}
+
+void CheckUnusedFunctions::addSummary(const std::string &summary)
+{
+    std::string filename;
+    std::string::size_type pos = 0;
+    while (pos < summary.size()) {
+        std::string::size_type end = summary.find('\n', pos);
+        if (end == std::string::npos)
+            end = summary.size();
+        const std::string line = summary.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (line.compare(0, 2, "d\t") == 0) {
+            const std::string::size_type tab1 = line.find('\t', 2);
+            const std::string::size_type tab2 = line.find('\t', tab1 + 1);
+            if (tab2 == std::string::npos)
+                continue;
+            const std::string name = line.substr(tab1 + 1, tab2 - tab1 - 1);
+            filename = line.substr(tab2 + 1);
+
+            // Same as for a declaration in parseTokens()
+            FunctionUsage &usage = _functions[name];
+            if (!usage.lineNumber)
+                usage.lineNumber = std::atoi(line.c_str() + 2);
+            if (usage.filename.empty())
+                usage.filename = filename;
+            else if (usage.filename != filename)
+                usage.usedOtherFile |= usage.usedSameFile;
+        } else if (line.compare(0, 2, "c\t") == 0) {
+            // Same as for a function call in parseTokens()
+            FunctionUsage &func = _functions[line.substr(2)];
+            if (func.filename.empty() || func.filename == "+" || func.filename != filename)
+                func.usedOtherFile = true;
+            else
+                func.usedSameFile = true;
+        }
+    }
+}
+
 bool CheckUnusedFunctions::analyseWholeProgram(const std::list<Check::FileInfo*> &fileInfo, const Settings& settings, ErrorLogger &errorLogger)
 {
     (void)fileInfo;
@@ -371,74 +443,20 @@ std::string CheckUnusedFunctions::analyzerInfo() const
     return ret.str();
 }
 
-namespace {
-    struct Location {
-        Location() : lineNumber(0) {}
-        Location(const std::string &f, const int l) : fileName(f), lineNumber(l) {}
-        std::string fileName;
-        int lineNumber;
-    };
-}
-
-void CheckUnusedFunctions::analyseWholeProgram(ErrorLogger * const errorLogger, const std::string &buildDir)
+std::string CheckUnusedFunctions::summaryFromAnalyzerInfo(const tinyxml2::XMLElement *fileInfo, const std::string &sourcefile)
 {
-    std::map<std::string, Location> decls;
-    std::set<std::string> calls;
-
-    const std::string filesTxt(buildDir + "/files.txt");
-    std::ifstream fin(filesTxt.c_str());
-    std::string filesTxtLine;
-    while (std::getline(fin, filesTxtLine)) {
-        const std::string::size_type firstColon = filesTxtLine.find(':');
-        if (firstColon == std::string::npos)
-            continue;
-        const std::string::size_type secondColon = filesTxtLine.find(':', firstColon+1);
-        if (secondColon == std::string::npos)
-            continue;
-        const std::string xmlfile = buildDir + '/' + filesTxtLine.substr(0,firstColon);
-        const std::string sourcefile = filesTxtLine.substr(secondColon+1);
-
-        tinyxml2::XMLDocument doc;
-        const tinyxml2::XMLError error = doc.LoadFile(xmlfile.c_str());
-        if (error != tinyxml2::XML_SUCCESS)
-            continue;
-
-        const tinyxml2::XMLElement * const rootNode = doc.FirstChildElement();
-        if (rootNode == nullptr)
-            continue;
-
-        for (const tinyxml2::XMLElement *e = rootNode->FirstChildElement(); e; e = e->NextSiblingElement()) {
-            if (std::strcmp(e->Name(), "FileInfo") != 0)
-                continue;
-            const char *checkattr = e->Attribute("check");
-            if (checkattr == nullptr || std::strcmp(checkattr,"CheckUnusedFunctions") != 0)
-                continue;
-            for (const tinyxml2::XMLElement *e2 = e->FirstChildElement(); e2; e2 = e2->NextSiblingElement()) {
-                const char* functionName = e2->Attribute("functionName");
-                if (functionName == nullptr)
-                    continue;
-                if (std::strcmp(e2->Name(),"functioncall") == 0) {
-                    calls.insert(functionName);
-                    continue;
-                } else if (std::strcmp(e2->Name(),"functiondecl") == 0) {
-                    const char* lineNumber = e2->Attribute("lineNumber");
-                    if (lineNumber)
-                        decls[functionName] = Location(sourcefile, std::atoi(lineNumber));
-                }
-            }
-        }
-    }
-
-    for (std::map<std::string, Location>::const_iterator decl = decls.begin(); decl != decls.end(); ++decl) {
-        const std::string &functionName = decl->first;
-
-        if (functionName == "main" || functionName == "WinMain" || functionName == "_tmain" ||
-            functionName == "if")
+    std::ostringstream decls, calls;
+    for (const tinyxml2::XMLElement *e = fileInfo->FirstChildElement(); e; e = e->NextSiblingElement()) {
+        const char* functionName = e->Attribute("functionName");
+        if (functionName == nullptr)
             continue;
-
-        if (calls.find(functionName) == calls.end() && !isOperatorFunction(functionName)) {
-            const Location &loc = decl->second;
-            unusedFunctionError(errorLogger, loc.fileName, loc.lineNumber, functionName);
+        if (std::strcmp(e->Name(),"functioncall") == 0) {
+            calls << "c\t" << functionName << '\n';
+        } else if (std::strcmp(e->Name(),"functiondecl") == 0) {
+            const char* lineNumber = e->Attribute("lineNumber");
+            if (lineNumber)
+                decls << "d\t" << std::atoi(lineNumber) << '\t' << functionName << '\t' << sourcefile << '\n';
         }
     }
+    return decls.str() + calls.str();
 }
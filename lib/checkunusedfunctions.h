@@ -26,9 +26,9 @@
 #include "config.h"
 
 #include <list>
-#include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 
 class ErrorLogger;
 class Function;
@@ -73,8 +73,19 @@ public:
 
     std::string analyzerInfo() const;
 
-    /** @brief Combine and analyze all analyzerInfos for all TUs */
-    static void analyseWholeProgram(ErrorLogger * const errorLogger, const std::string &buildDir);
+
+    /**
+     * @brief Function declarations and calls of the parsed TUs. Used by
+     * -j to send them from the process that checks a file to the main
+     * process.
+     */
+    std::string summary() const;
+
+    /** @brief Add the function declarations and calls of a summary() */
+    void addSummary(const std::string &summary);
+
+    /** @brief Get a summary() from the analyzerInfo() of a TU that is loaded from the build dir */
+    static std::string summaryFromAnalyzerInfo(const tinyxml2::XMLElement *fileInfo, const std::string &sourcefile);
 
 private:
 
@@ -115,7 +126,7 @@ private:
         bool   usedOtherFile;
     };
 
-    std::map<std::string, FunctionUsage> _functions;
+    std::unordered_map<std::string, FunctionUsage> _functions;
 
     class CPPCHECKLIB FunctionDecl {
     public:
@@ -54,6 +54,10 @@ public:
         check.va_list_usage();
     }
 
+    bool isRelevant(const TokenCensus &census) const override {
+        return census.hasName("va_start") || census.hasName("va_list");
+    }
+
     void va_start_argument();
     void va_list_usage();
 
@@ -19,6 +19,7 @@
 
 #include "check.h"
 #include "checkunusedfunctions.h"
+#include "functionsummaries.h"
 #include "library.h"
 #include "mathlib.h"
 #include "path.h"
@@ -34,10 +35,13 @@
 #include <simplecpp.h>
 #include <tinyxml2.h>
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <exception>
 #include <new>
 #include <set>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
 #ifdef HAVE_RULES
@@ -53,6 +57,33 @@ static TimerResults S_timerResults;
 // CWE ids used
 static const CWE CWE398(398U);  // Indicator of Poor Code Quality
 
+#ifdef HAVE_RULES
+class CppCheck::CompiledRule {
+public:
+    explicit CompiledRule(const Settings::Rule &r) : rule(r), re(nullptr), extra(nullptr) {
+    }
+
+    ~CompiledRule() {
+        if (extra) {
+#ifdef PCRE_STUDY_JIT_COMPILE
+            pcre_free_study(extra);
+#else
+            pcre_free(extra);
+#endif
+        }
+        if (re)
+            pcre_free(re);
+    }
+
+    const Settings::Rule rule;
+    pcre *re;
+    pcre_extra *extra;
+
+    CompiledRule(const CompiledRule &) = delete;
+    void operator=(const CompiledRule &) = delete;
+};
+#endif
+
 CppCheck::CppCheck(ErrorLogger &errorLogger, bool useGlobalSuppressions)
     : _errorLogger(errorLogger), exitcode(0), _useGlobalSuppressions(useGlobalSuppressions), tooManyConfigs(false), _simplify(true)
 {
@@ -79,36 +110,50 @@ const char * CppCheck::extraVersion()
 
 unsigned int CppCheck::check(const std::string &path)
 {
-    std::ifstream fin(path);
-    return checkFile(Path::simplifyPath(path), emptyString, fin);
+    return checkFile(Path::simplifyPath(path), emptyString, nullptr);
 }
 
 unsigned int CppCheck::check(const std::string &path, const std::string &content)
 {
     std::istringstream iss(content);
-    return checkFile(Path::simplifyPath(path), emptyString, iss);
+    return checkFile(Path::simplifyPath(path), emptyString, &iss);
 }
 
 unsigned int CppCheck::check(const ImportProject::FileSettings &fs)
 {
-    CppCheck temp(_errorLogger, _useGlobalSuppressions);
-    temp._settings = _settings;
-    if (!temp._settings.userDefines.empty())
-        temp._settings.userDefines += ';';
-    temp._settings.userDefines += fs.cppcheckDefines();
-    temp._settings.includePaths = fs.includePaths;
-    // TODO: temp._settings.userUndefs = fs.undefs;
-    if (fs.platformType != Settings::Unspecified) {
-        temp._settings.platform(fs.platformType);
+    // Copying the settings is expensive, files that are preprocessed with
+    // the same settings are checked with the same CppCheck instance
+    const std::string contextKey = fs.contextKey();
+    if (!_contextChecker || contextKey != _contextKey) {
+        _contextChecker.reset(new CppCheck(_errorLogger, _useGlobalSuppressions));
+        CppCheck &temp = *_contextChecker;
+        temp._settings = _settings;
+        if (!temp._settings.userDefines.empty())
+            temp._settings.userDefines += ';';
+        temp._settings.userDefines += fs.cppcheckDefines();
+        temp._settings.includePaths = fs.includePaths;
+        // TODO: temp._settings.userUndefs = fs.undefs;
+        if (fs.platformType != Settings::Unspecified) {
+            temp._settings.platform(fs.platformType);
+        }
+        _contextKey = contextKey;
+    }
+    CppCheck &temp = *_contextChecker;
+    const unsigned int ret = temp.checkFile(Path::simplifyPath(fs.filename), fs.cfg, nullptr);
+    while (!temp.fileInfo.empty()) {
+        delete temp.fileInfo.back();
+        temp.fileInfo.pop_back();
     }
-    std::ifstream fin(fs.filename);
-    return temp.checkFile(Path::simplifyPath(fs.filename), fs.cfg, fin);
+    return ret;
 }
 
-unsigned int CppCheck::checkFile(const std::string& filename, const std::string &cfgname, std::istream& fileStream)
+unsigned int CppCheck::checkFile(const std::string& filename, const std::string &cfgname, std::istream* fileStream)
 {
     exitcode = 0;
 
+    // An earlier file that returned early did not clear its errors
+    _errorList.clear();
+
     // only show debug warnings for accepted C/C++ source files
     if (!Path::acceptFile(filename))
         _settings.debugwarnings = false;
@@ -138,6 +183,32 @@ unsigned int CppCheck::checkFile(const std::string& filename, const std::string
 
     CheckUnusedFunctions checkUnusedFunctions(nullptr, nullptr, nullptr);
 
+    std::string toolinfo;
+    // The inline suppressions, the dump file and the plist file are
+    // created while the file is read, so such files are always read.
+    // Content that is given in a stream is not the file on disk.
+    const bool useDependencies = !fileStream && !_settings.buildDir.empty() && !_settings.inlineSuppressions && !_settings.dump && _settings.plistOutput.empty();
+    if (!_settings.buildDir.empty()) {
+        // Get toolinfo
+        toolinfo += CPPCHECK_VERSION_STRING;
+        toolinfo += _settings.isEnabled(Settings::WARNING) ? 'w' : ' ';
+        toolinfo += _settings.isEnabled(Settings::STYLE) ? 's' : ' ';
+        toolinfo += _settings.isEnabled(Settings::PERFORMANCE) ? 'p' : ' ';
+        toolinfo += _settings.isEnabled(Settings::PORTABILITY) ? 'p' : ' ';
+        toolinfo += _settings.isEnabled(Settings::INFORMATION) ? 'i' : ' ';
+        toolinfo += _settings.userDefines;
+
+        // Files that are not changed since the last analysis don't have to be read
+        std::list<ErrorLogger::ErrorMessage> errors;
+        if (useDependencies && AnalyzerInformation::skipUnchangedFile(_settings.buildDir, filename, cfgname, toolinfo, _settings.includePaths, _settings.functionSummaries.get(), &errors)) {
+            while (!errors.empty()) {
+                reportErr(errors.front());
+                errors.pop_front();
+            }
+            return exitcode;
+        }
+    }
+
     bool internalErrorFound(false);
     try {
         Preprocessor preprocessor(_settings, this);
@@ -145,7 +216,11 @@ unsigned int CppCheck::checkFile(const std::string& filename, const std::string
 
         simplecpp::OutputList outputList;
         std::vector<std::string> files;
-        simplecpp::TokenList tokens1(fileStream, files, filename, &outputList);
+        // files are read with the simplecpp file reader, it maps the file to memory
+        const std::unique_ptr<simplecpp::TokenList> tokenList(fileStream ?
+                new simplecpp::TokenList(*fileStream, files, filename, &outputList) :
+                new simplecpp::TokenList(filename, files, &outputList));
+        simplecpp::TokenList &tokens1 = *tokenList;
 
         // If there is a syntax error, report it and stop
         for (simplecpp::OutputList::const_iterator it = outputList.begin(); it != outputList.end(); ++it) {
@@ -232,26 +307,18 @@ unsigned int CppCheck::checkFile(const std::string& filename, const std::string
         preprocessor.removeComments();
 
         if (!_settings.buildDir.empty()) {
-            // Get toolinfo
-            std::string toolinfo;
-            toolinfo += CPPCHECK_VERSION_STRING;
-            toolinfo += _settings.isEnabled(Settings::WARNING) ? 'w' : ' ';
-            toolinfo += _settings.isEnabled(Settings::STYLE) ? 's' : ' ';
-            toolinfo += _settings.isEnabled(Settings::PERFORMANCE) ? 'p' : ' ';
-            toolinfo += _settings.isEnabled(Settings::PORTABILITY) ? 'p' : ' ';
-            toolinfo += _settings.isEnabled(Settings::INFORMATION) ? 'i' : ' ';
-            toolinfo += _settings.userDefines;
-
             // Calculate checksum so it can be compared with old checksum / future checksums
             const unsigned int checksum = preprocessor.calculateChecksum(tokens1, toolinfo);
             std::list<ErrorLogger::ErrorMessage> errors;
-            if (!analyzerInformation.analyzeFile(_settings.buildDir, filename, cfgname, checksum, &errors)) {
+            if (!analyzerInformation.analyzeFile(_settings.buildDir, filename, cfgname, checksum, _settings.functionSummaries.get(), &errors)) {
                 while (!errors.empty()) {
                     reportErr(errors.front());
                     errors.pop_front();
                 }
                 return exitcode;  // known results => no need to reanalyze file
             }
+            if (useDependencies)
+                analyzerInformation.setDependencies(toolinfo, files, preprocessor.getIncludes(tokens1), _settings.includePaths);
         }
 
         // Get directives
@@ -539,16 +606,28 @@ void CppCheck::checkRawTokens(const Tokenizer &tokenizer)
 
 void CppCheck::checkNormalTokens(const Tokenizer &tokenizer)
 {
+    const Check::TokenCensus census(&tokenizer, &_settings);
+
     // call all "runChecks" in all registered Check classes
-    for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
-        if (_settings.terminated())
+    if (_settings.checkThreads > 1) {
+        if (!runChecksConcurrently(tokenizer, census, false))
             return;
+    } else {
+        for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
+            if (_settings.terminated())
+                return;
 
-        if (tokenizer.isMaxTime())
-            return;
+            if (tokenizer.isMaxTime())
+                return;
+
+            if (!(*it)->isRelevant(census)) {
+                Timer timerSkipped((*it)->name() + "::runChecks (skipped)", _settings.showtime, &S_timerResults);
+                continue;
+            }
 
-        Timer timerRunChecks((*it)->name() + "::runChecks", _settings.showtime, &S_timerResults);
-        (*it)->runChecks(&tokenizer, &_settings, this);
+            Timer timerRunChecks((*it)->name() + "::runChecks", _settings.showtime, &S_timerResults);
+            (*it)->runChecks(&tokenizer, &_settings, this);
+        }
     }
 
     // Analyse the tokens..
@@ -560,6 +639,10 @@ void CppCheck::checkNormalTokens(const Tokenizer &tokenizer)
         }
     }
 
+    // Summaries of the functions for the other TUs..
+    if (!_settings.buildDir.empty())
+        analyzerInformation.setFunctionSummaries(FunctionSummaries::toXml(&tokenizer, &_settings));
+
     executeRules("normal", tokenizer);
 }
 
@@ -569,55 +652,143 @@ void CppCheck::checkNormalTokens(const Tokenizer &tokenizer)
 
 void CppCheck::checkSimplifiedTokens(const Tokenizer &tokenizer)
 {
+    const Check::TokenCensus census(&tokenizer, &_settings);
+
     // call all "runSimplifiedChecks" in all registered Check classes
-    for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
-        if (_settings.terminated())
+    if (_settings.checkThreads > 1) {
+        if (!runChecksConcurrently(tokenizer, census, true))
             return;
+    } else {
+        for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
+            if (_settings.terminated())
+                return;
 
-        if (tokenizer.isMaxTime())
-            return;
+            if (tokenizer.isMaxTime())
+                return;
 
-        Timer timerSimpleChecks((*it)->name() + "::runSimplifiedChecks", _settings.showtime, &S_timerResults);
-        (*it)->runSimplifiedChecks(&tokenizer, &_settings, this);
-        timerSimpleChecks.Stop();
+            if (!(*it)->isRelevant(census)) {
+                Timer timerSkipped((*it)->name() + "::runSimplifiedChecks (skipped)", _settings.showtime, &S_timerResults);
+                continue;
+            }
+
+            Timer timerSimpleChecks((*it)->name() + "::runSimplifiedChecks", _settings.showtime, &S_timerResults);
+            (*it)->runSimplifiedChecks(&tokenizer, &_settings, this);
+            timerSimpleChecks.Stop();
+        }
     }
 
     if (!_settings.terminated())
         executeRules("simple", tokenizer);
 }
 
-void CppCheck::executeRules(const std::string &tokenlist, const Tokenizer &tokenizer)
-{
-    (void)tokenlist;
-    (void)tokenizer;
+namespace {
+    /** Collects the messages of one check that runs in a worker thread */
+    class ErrorBuffer : public ErrorLogger {
+    public:
+        void reportOut(const std::string &outmsg) override {
+            output.push_back(outmsg);
+        }
 
-#ifdef HAVE_RULES
-    // Are there rules to execute?
-    bool isrule = false;
-    for (std::list<Settings::Rule>::const_iterator it = _settings.rules.begin(); it != _settings.rules.end(); ++it) {
-        if (it->tokenlist == tokenlist)
-            isrule = true;
+        void reportErr(const ErrorLogger::ErrorMessage &msg) override {
+            errors.push_back(msg);
+        }
+
+        std::list<std::string> output;
+        std::list<ErrorLogger::ErrorMessage> errors;
+    };
+}
+
+bool CppCheck::runChecksConcurrently(const Tokenizer &tokenizer, const Check::TokenCensus &census, bool simplified)
+{
+    const std::string suffix(simplified ? "::runSimplifiedChecks" : "::runChecks");
+    const std::vector<Check *> checks(Check::instances().begin(), Check::instances().end());
+
+    // Thread safe checks run in the worker threads, the others are run
+    // serially afterwards.
+    std::vector<bool> relevant(checks.size()), concurrent(checks.size());
+    for (std::size_t i = 0; i < checks.size(); ++i) {
+        relevant[i] = checks[i]->isRelevant(census);
+        concurrent[i] = relevant[i] && checks[i]->isThreadSafe(&_settings);
     }
 
-    // There is no rule to execute
-    if (isrule == false)
-        return;
+    std::vector<ErrorBuffer> buffers(checks.size());
+    std::vector<std::exception_ptr> exceptions(checks.size());
+    std::atomic<std::size_t> next(0);
+    const auto worker = [&]() {
+        for (std::size_t i = next++; i < checks.size(); i = next++) {
+            if (!concurrent[i] || _settings.terminated() || tokenizer.isMaxTime())
+                continue;
+            try {
+                if (simplified)
+                    checks[i]->runSimplifiedChecks(&tokenizer, &_settings, &buffers[i]);
+                else
+                    checks[i]->runChecks(&tokenizer, &_settings, &buffers[i]);
+            } catch (...) {
+                exceptions[i] = std::current_exception();
+            }
+        }
+    };
+
+    Timer timerConcurrent("CppCheck" + suffix + " (concurrent)", _settings.showtime, &S_timerResults);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < _settings.checkThreads && t < checks.size(); ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread &thread : threads)
+        thread.join();
+    timerConcurrent.Stop();
+
+    // Report the results in the order the checks are registered so the
+    // output is the same as when the checks run serially
+    for (std::size_t i = 0; i < checks.size(); ++i) {
+        if (_settings.terminated() || tokenizer.isMaxTime())
+            return false;
+
+        if (!relevant[i]) {
+            Timer timerSkipped(checks[i]->name() + suffix + " (skipped)", _settings.showtime, &S_timerResults);
+            continue;
+        }
+
+        if (concurrent[i]) {
+            for (const std::string &outmsg : buffers[i].output)
+                reportOut(outmsg);
+            for (const ErrorLogger::ErrorMessage &msg : buffers[i].errors)
+                reportErr(msg);
+            if (exceptions[i])
+                std::rethrow_exception(exceptions[i]);
+            continue;
+        }
+
+        Timer timerRunChecks(checks[i]->name() + suffix, _settings.showtime, &S_timerResults);
+        if (simplified)
+            checks[i]->runSimplifiedChecks(&tokenizer, &_settings, this);
+        else
+            checks[i]->runChecks(&tokenizer, &_settings, this);
+    }
+    return true;
+}
 
-    // Write all tokens in a string that can be parsed by pcre
-    std::ostringstream ostr;
-    for (const Token *tok = tokenizer.tokens(); tok; tok = tok->next())
-        ostr << " " << tok->str();
-    const std::string str(ostr.str());
+#ifdef HAVE_RULES
+void CppCheck::compileRules()
+{
+#ifdef PCRE_STUDY_JIT_COMPILE
+    const int studyOptions = PCRE_STUDY_JIT_COMPILE;
+#else
+    const int studyOptions = 0;
+#endif
 
     for (std::list<Settings::Rule>::const_iterator it = _settings.rules.begin(); it != _settings.rules.end(); ++it) {
+        CompiledRule *compiledRule = new CompiledRule(*it);
+        _compiledRules.emplace_back(compiledRule);
+
         const Settings::Rule &rule = *it;
-        if (rule.pattern.empty() || rule.id.empty() || rule.severity == Severity::none || rule.tokenlist != tokenlist)
+        if (rule.pattern.empty() || rule.id.empty() || rule.severity == Severity::none)
             continue;
 
         const char *error = nullptr;
         int erroffset = 0;
-        pcre *re = pcre_compile(rule.pattern.c_str(),0,&error,&erroffset,nullptr);
-        if (!re) {
+        compiledRule->re = pcre_compile(rule.pattern.c_str(),0,&error,&erroffset,nullptr);
+        if (!compiledRule->re) {
             if (error) {
                 ErrorLogger::ErrorMessage errmsg(std::list<ErrorLogger::ErrorMessage::FileLocation>(),
                                                  emptyString,
@@ -631,9 +802,54 @@ void CppCheck::executeRules(const std::string &tokenlist, const Tokenizer &token
             continue;
         }
 
+        // A failing pcre_study is not fatal, the pattern is then matched without the study data
+        compiledRule->extra = pcre_study(compiledRule->re, studyOptions, &error);
+    }
+}
+#endif
+
+void CppCheck::executeRules(const std::string &tokenlist, const Tokenizer &tokenizer)
+{
+    (void)tokenlist;
+    (void)tokenizer;
+
+#ifdef HAVE_RULES
+    // Are there rules to execute?
+    bool isrule = false;
+    for (std::list<Settings::Rule>::const_iterator it = _settings.rules.begin(); it != _settings.rules.end(); ++it) {
+        if (it->tokenlist == tokenlist)
+            isrule = true;
+    }
+
+    // There is no rule to execute
+    if (isrule == false)
+        return;
+
+    if (_compiledRules.empty())
+        compileRules();
+
+    // Write all tokens in a string that can be parsed by pcre. Save the
+    // end offset of each token so matches can be mapped to tokens.
+    std::string str;
+    std::vector<const Token *> tokens;
+    std::vector<std::size_t> tokenEnd;
+    for (const Token *tok = tokenizer.tokens(); tok; tok = tok->next()) {
+        str += ' ';
+        str += tok->str();
+        tokens.push_back(tok);
+        tokenEnd.push_back(str.size());
+    }
+
+    for (std::list<std::unique_ptr<CompiledRule> >::const_iterator it = _compiledRules.begin(); it != _compiledRules.end(); ++it) {
+        const Settings::Rule &rule = (*it)->rule;
+        if (!(*it)->re || rule.tokenlist != tokenlist)
+            continue;
+
+        Timer timer("Rule::" + rule.id + " '" + rule.pattern + "'", _settings.showtime, &S_timerResults);
+
         int pos = 0;
         int ovector[30]= {0};
-        while (pos < (int)str.size() && 0 <= pcre_exec(re, nullptr, str.c_str(), (int)str.size(), pos, 0, ovector, 30)) {
+        while (pos < (int)str.size() && 0 <= pcre_exec((*it)->re, (*it)->extra, str.c_str(), (int)str.size(), pos, 0, ovector, 30)) {
             const unsigned int pos1 = (unsigned int)ovector[0];
             const unsigned int pos2 = (unsigned int)ovector[1];
 
@@ -645,14 +861,11 @@ void CppCheck::executeRules(const std::string &tokenlist, const Tokenizer &token
             loc.setfile(tokenizer.list.getSourceFilePath());
             loc.line = 0;
 
-            std::size_t len = 0;
-            for (const Token *tok = tokenizer.tokens(); tok; tok = tok->next()) {
-                len = len + 1U + tok->str().size();
-                if (len > pos1) {
-                    loc.setfile(tokenizer.list.getFiles().at(tok->fileIndex()));
-                    loc.line = tok->linenr();
-                    break;
-                }
+            const std::vector<std::size_t>::const_iterator end = std::upper_bound(tokenEnd.begin(), tokenEnd.end(), pos1);
+            if (end != tokenEnd.end()) {
+                const Token *tok = tokens[end - tokenEnd.begin()];
+                loc.setfile(tokenizer.list.getFiles().at(tok->fileIndex()));
+                loc.line = tok->linenr();
             }
 
             const std::list<ErrorLogger::ErrorMessage::FileLocation> callStack(1, loc);
@@ -668,14 +881,18 @@ void CppCheck::executeRules(const std::string &tokenlist, const Tokenizer &token
             // Report error
             reportErr(errmsg);
         }
-
-        pcre_free(re);
     }
 #endif
 }
 
 Settings &CppCheck::settings()
 {
+    // the settings might be changed, don't reuse the settings of project files
+    _contextChecker.reset();
+#ifdef HAVE_RULES
+    // the rules might be changed, they are compiled again
+    _compiledRules.clear();
+#endif
     return _settings;
 }
 
@@ -746,17 +963,35 @@ void CppCheck::purgedConfigurationMessage(const std::string &file, const std::st
 
 //---------------------------------------------------------------------------
 
+/**
+ * Key that identifies a reported error. It has the same parts as the
+ * text of ErrorMessage::toString(), without formatting the message. The
+ * id is not part of it, errors with different ids and the same text are
+ * reported once.
+ */
+static std::string errorKey(const ErrorLogger::ErrorMessage &msg, bool verbose)
+{
+    std::string key(Severity::toString(msg._severity));
+    if (msg._inconclusive)
+        key += ", inconclusive";
+    for (std::list<ErrorLogger::ErrorMessage::FileLocation>::const_iterator loc = msg._callStack.begin(); loc != msg._callStack.end(); ++loc) {
+        key += '\n';
+        key += loc->getfile(false);
+        key += ':';
+        key += MathLib::toString(loc->line);
+    }
+    key += '\n';
+    key += verbose ? msg.verboseMessage() : msg.shortMessage();
+    return key;
+}
+
 void CppCheck::reportErr(const ErrorLogger::ErrorMessage &msg)
 {
     if (!_settings.library.reportErrors(msg.file0))
         return;
 
-    const std::string errmsg = msg.toString(_settings.verbose);
-    if (errmsg.empty())
-        return;
-
-    // Alert only about unique errors
-    if (std::find(_errorList.begin(), _errorList.end(), errmsg) != _errorList.end())
+    // Nothing to report
+    if (msg._callStack.empty() && msg._severity == Severity::none && (_settings.verbose ? msg.verboseMessage() : msg.shortMessage()).empty())
         return;
 
     const Suppressions::ErrorMessage errorMessage = msg.toSuppressionsErrorMessage();
@@ -769,11 +1004,13 @@ void CppCheck::reportErr(const ErrorLogger::ErrorMessage &msg)
             return;
     }
 
+    // Alert only about unique errors
+    if (!_errorList.insert(errorKey(msg, _settings.verbose)).second)
+        return;
+
     if (!_settings.nofail.isSuppressed(errorMessage) && (_useGlobalSuppressions || !_settings.nomsg.isSuppressed(errorMessage)))
         exitcode = 1;
 
-    _errorList.push_back(errmsg);
-
     _errorLogger.reportErr(msg);
     analyzerInformation.reportErr(msg, _settings.verbose);
     if (!_settings.plistOutput.empty() && plistFile.is_open()) {
@@ -838,11 +1075,9 @@ void CppCheck::analyseWholeProgram(const std::string &buildDir, const std::map<s
     (void)files;
     if (buildDir.empty())
         return;
-    if (_settings.isEnabled(Settings::UNUSED_FUNCTION))
-        CheckUnusedFunctions::analyseWholeProgram(this, buildDir);
-    std::list<Check::FileInfo*> fileInfoList;
 
-    // Load all analyzer info data..
+    // Get the source files and configurations..
+    std::vector<std::pair<std::string, std::string> > sourcefiles;
     const std::string filesTxt(buildDir + "/files.txt");
     std::ifstream fin(filesTxt);
     std::string filesTxtLine;
@@ -850,32 +1085,81 @@ void CppCheck::analyseWholeProgram(const std::string &buildDir, const std::map<s
         const std::string::size_type firstColon = filesTxtLine.find(':');
         if (firstColon == std::string::npos)
             continue;
-        const std::string::size_type lastColon = filesTxtLine.rfind(':');
-        if (firstColon == lastColon)
+        const std::string::size_type secondColon = filesTxtLine.find(':', firstColon+1);
+        if (secondColon == std::string::npos)
             continue;
-        const std::string xmlfile = buildDir + '/' + filesTxtLine.substr(0,firstColon);
-        //const std::string sourcefile = filesTxtLine.substr(lastColon+1);
+        sourcefiles.emplace_back(filesTxtLine.substr(secondColon+1), filesTxtLine.substr(firstColon+1, secondColon-firstColon-1));
+    }
 
-        tinyxml2::XMLDocument doc;
-        const tinyxml2::XMLError error = doc.LoadFile(xmlfile.c_str());
-        if (error != tinyxml2::XML_SUCCESS)
-            continue;
+    // Load all analyzer info data. The files are parsed in -j threads, the
+    // results are kept in the order of files.txt.
+    const AnalyzerInfoStore store(buildDir);
+    std::vector<std::list<Check::FileInfo*> > fileInfos(sourcefiles.size());
+    std::vector<std::string> unusedFunctions(sourcefiles.size());
+    std::vector<std::exception_ptr> exceptions(sourcefiles.size());
+    std::atomic<std::size_t> next(0);
+    const auto worker = [&]() {
+        for (std::size_t i = next++; i < sourcefiles.size(); i = next++) {
+            try {
+                unsigned long long checksum = 0;
+                std::string analyzerInfo;
+                if (!store.read(sourcefiles[i].first, sourcefiles[i].second, &checksum, &analyzerInfo))
+                    continue;
 
-        const tinyxml2::XMLElement * const rootNode = doc.FirstChildElement();
-        if (rootNode == nullptr)
-            continue;
+                tinyxml2::XMLDocument doc;
+                const tinyxml2::XMLError error = doc.Parse(analyzerInfo.data(), analyzerInfo.size());
+                if (error != tinyxml2::XML_SUCCESS)
+                    continue;
 
-        for (const tinyxml2::XMLElement *e = rootNode->FirstChildElement(); e; e = e->NextSiblingElement()) {
-            if (std::strcmp(e->Name(), "FileInfo") != 0)
-                continue;
-            const char *checkClassAttr = e->Attribute("check");
-            if (!checkClassAttr)
-                continue;
-            for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
-                if (checkClassAttr == (*it)->name())
-                    fileInfoList.push_back((*it)->loadFileInfoFromXml(e));
+                const tinyxml2::XMLElement * const rootNode = doc.FirstChildElement();
+                if (rootNode == nullptr)
+                    continue;
+
+                for (const tinyxml2::XMLElement *e = rootNode->FirstChildElement(); e; e = e->NextSiblingElement()) {
+                    if (std::strcmp(e->Name(), "FileInfo") != 0)
+                        continue;
+                    const char *checkClassAttr = e->Attribute("check");
+                    if (!checkClassAttr)
+                        continue;
+                    if (std::strcmp(checkClassAttr, "CheckUnusedFunctions") == 0) {
+                        unusedFunctions[i] = CheckUnusedFunctions::summaryFromAnalyzerInfo(e, sourcefiles[i].first);
+                        continue;
+                    }
+                    for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
+                        if (checkClassAttr == (*it)->name())
+                            fileInfos[i].push_back((*it)->loadFileInfoFromXml(e));
+                    }
+                }
+            } catch (...) {
+                exceptions[i] = std::current_exception();
             }
         }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < _settings.jobs && t < sourcefiles.size(); ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread &thread : threads)
+        thread.join();
+
+    std::list<Check::FileInfo*> fileInfoList;
+    for (std::size_t i = 0; i < fileInfos.size(); ++i)
+        fileInfoList.splice(fileInfoList.end(), fileInfos[i]);
+
+    for (std::size_t i = 0; i < exceptions.size(); ++i) {
+        if (exceptions[i]) {
+            for (std::list<Check::FileInfo*>::iterator fi = fileInfoList.begin(); fi != fileInfoList.end(); ++fi)
+                delete (*fi);
+            std::rethrow_exception(exceptions[i]);
+        }
+    }
+
+    if (_settings.isEnabled(Settings::UNUSED_FUNCTION)) {
+        CheckUnusedFunctions checkUnusedFunctions(nullptr, nullptr, nullptr);
+        for (std::size_t i = 0; i < unusedFunctions.size(); ++i)
+            checkUnusedFunctions.addSummary(unusedFunctions[i]);
+        checkUnusedFunctions.check(this, _settings);
     }
 
     // Analyse the tokens
@@ -888,5 +1172,5 @@ void CppCheck::analyseWholeProgram(const std::string &buildDir, const std::map<s
 
 bool CppCheck::isUnusedFunctionCheckEnabled() const
 {
-    return (_settings.jobs == 1 && _settings.isEnabled(Settings::UNUSED_FUNCTION));
+    return _settings.isEnabled(Settings::UNUSED_FUNCTION);
 }
@@ -32,7 +32,9 @@
 #include <istream>
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_set>
 
 class Tokenizer;
 
@@ -152,10 +154,10 @@ private:
      * @brief Check a file using stream
      * @param filename file name
      * @param cfgname  cfg name
-     * @param fileStream stream the file content can be read from
+     * @param fileStream stream the file content can be read from, if it is null the file is read
      * @return number of errors found
      */
-    unsigned int checkFile(const std::string& filename, const std::string &cfgname, std::istream& fileStream);
+    unsigned int checkFile(const std::string& filename, const std::string &cfgname, std::istream* fileStream);
 
     /**
      * @brief Check raw tokens
@@ -175,6 +177,17 @@ private:
      */
     void checkSimplifiedTokens(const Tokenizer &tokenizer);
 
+    /**
+     * @brief Run the checks of a token list in --check-threads worker threads.
+     * Checks that are not thread safe are run serially. The errors are
+     * reported in the order the checks are registered.
+     * @param tokenizer tokenizer instance
+     * @param census census of the token list
+     * @param simplified run "runSimplifiedChecks" instead of "runChecks"
+     * @return false if checking was terminated
+     */
+    bool runChecksConcurrently(const Tokenizer &tokenizer, const Check::TokenCensus &census, bool simplified);
+
     /**
      * @brief Execute rules, if any
      * @param tokenlist token list to use (normal / simple)
@@ -198,7 +211,8 @@ private:
      */
     virtual void reportOut(const std::string &outmsg) override;
 
-    std::list<std::string> _errorList;
+    /** Errors that are reported for the current file, each error is only reported once */
+    std::unordered_set<std::string> _errorList;
     Settings _settings;
 
     void reportProgress(const std::string &filename, const char stage[], const std::size_t value) override;
@@ -226,7 +240,28 @@ private:
     /** File info used for whole program analysis */
     std::list<Check::FileInfo*> fileInfo;
 
+    /**
+     * Checker for project files, its settings are the settings of the last
+     * checked file. Consecutive files with the same contextKey() reuse it.
+     */
+    std::unique_ptr<CppCheck> _contextChecker;
+    std::string _contextKey;
+
     AnalyzerInformation analyzerInformation;
+
+#ifdef HAVE_RULES
+    /** Rule with compiled pcre pattern */
+    class CompiledRule;
+
+    /** Compile the rules. Compile errors are reported. */
+    void compileRules();
+
+    /**
+     * Compiled rules, same order as the settings rules. Compiled when they
+     * are first used, and again after the settings are changed.
+     */
+    std::list<std::unique_ptr<CompiledRule> > _compiledRules;
+#endif
 };
 
 /// @}
@@ -29,6 +29,7 @@
 #include <array>
 #include <cassert>
 #include <cctype>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
@@ -335,6 +336,90 @@ bool ErrorLogger::ErrorMessage::deserialize(const std::string &data)
     return true;
 }
 
+static void writeUInt(std::string &buffer, unsigned int value)
+{
+    char data[sizeof(value)];
+    std::memcpy(data, &value, sizeof(value));
+    buffer.append(data, sizeof(value));
+}
+
+static void writeString(std::string &buffer, const std::string &str)
+{
+    writeUInt(buffer, static_cast<unsigned int>(str.size()));
+    buffer += str;
+}
+
+static bool readUInt(const char *&data, const char *end, unsigned int &value)
+{
+    if (end - data < static_cast<std::ptrdiff_t>(sizeof(value)))
+        return false;
+    std::memcpy(&value, data, sizeof(value));
+    data += sizeof(value);
+    return true;
+}
+
+static bool readString(const char *&data, const char *end, std::string &str)
+{
+    unsigned int len = 0;
+    if (!readUInt(data, end, len) || static_cast<std::size_t>(end - data) < len)
+        return false;
+    str.assign(data, len);
+    data += len;
+    return true;
+}
+
+void ErrorLogger::ErrorMessage::serializeBinary(std::string &buffer) const
+{
+    writeString(buffer, _id);
+    writeUInt(buffer, static_cast<unsigned int>(_severity));
+    writeUInt(buffer, _cwe.id);
+    writeUInt(buffer, _inconclusive ? 1U : 0U);
+    writeString(buffer, fixInvalidChars(_shortMessage));
+    writeString(buffer, fixInvalidChars(_verboseMessage));
+    writeString(buffer, _symbolNames);
+    writeUInt(buffer, static_cast<unsigned int>(_callStack.size()));
+    for (std::list<FileLocation>::const_iterator loc = _callStack.begin(); loc != _callStack.end(); ++loc) {
+        writeString(buffer, loc->getfile(false));
+        writeString(buffer, loc->getinfo());
+        writeUInt(buffer, loc->line);
+        writeUInt(buffer, loc->col);
+    }
+}
+
+bool ErrorLogger::ErrorMessage::deserializeBinary(const char *data, std::size_t size)
+{
+    const char * const end = data + size;
+    unsigned int severity = 0, cwe = 0, inconclusive = 0, stackSize = 0;
+    _callStack.clear();
+    if (!readString(data, end, _id) ||
+        !readUInt(data, end, severity) ||
+        !readUInt(data, end, cwe) ||
+        !readUInt(data, end, inconclusive) ||
+        !readString(data, end, _shortMessage) ||
+        !readString(data, end, _verboseMessage) ||
+        !readString(data, end, _symbolNames) ||
+        !readUInt(data, end, stackSize))
+        return false;
+    _severity = static_cast<Severity::SeverityType>(severity);
+    _cwe = CWE(static_cast<unsigned short>(cwe));
+    _inconclusive = (inconclusive != 0);
+
+    for (unsigned int i = 0; i < stackSize; ++i) {
+        std::string file, info;
+        FileLocation loc;
+        if (!readString(data, end, file) ||
+            !readString(data, end, info) ||
+            !readUInt(data, end, loc.line) ||
+            !readUInt(data, end, loc.col))
+            return false;
+        loc.setfile(file);
+        loc.setinfo(info);
+        _callStack.push_back(loc);
+    }
+
+    return data == end;
+}
+
 std::string ErrorLogger::ErrorMessage::getXMLHeader()
 {
     // xml_version 1 is the default xml format
@@ -267,6 +267,14 @@ public:
         std::string serialize() const;
         bool deserialize(const std::string &data);
 
+        /**
+         * Append a compact binary form of this message to the buffer. It is
+         * only meant to be read back by deserializeBinary() in a process
+         * running the same binary (the integers are in host byte order).
+         */
+        void serializeBinary(std::string &buffer) const;
+        bool deserializeBinary(const char *data, std::size_t size);
+
         std::list<FileLocation> _callStack;
         std::string _id;
 
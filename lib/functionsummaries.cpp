@@ -0,0 +1,275 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2018 Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "functionsummaries.h"
+
+#include "checkmemoryleak.h"
+#include "checknullpointer.h"
+#include "errorlogger.h"
+#include "settings.h"
+#include "symboldatabase.h"
+#include "token.h"
+#include "tokenize.h"
+#include "utils.h"
+#include "valueflow.h"
+
+#include <tinyxml2.h>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <utility>
+
+/**
+ * Key of a function that can be called from other TUs. It is empty if the
+ * function can't be called from other TUs, or if there are overloads with
+ * the same number of arguments.
+ */
+static std::string getKey(const Function *function)
+{
+    const Scope *scope = function->nestedIn;
+    if (!scope || scope->type != Scope::eGlobal || function->isStatic() || function->isOperator())
+        return emptyString;
+
+    unsigned int overloads = 0;
+    typedef std::multimap<std::string, const Function *>::const_iterator FunctionIterator;
+    const std::pair<FunctionIterator, FunctionIterator> range = scope->functionMap.equal_range(function->name());
+    for (FunctionIterator it = range.first; it != range.second; ++it) {
+        if (it->second->argCount() == function->argCount())
+            ++overloads;
+    }
+    if (overloads > 1U)
+        return emptyString;
+
+    return function->name() + ':' + MathLib::toString(function->argCount());
+}
+
+static void writeArgs(std::ostream &ostr, const char attributeName[], const std::set<int> &args)
+{
+    if (args.empty())
+        return;
+    ostr << ' ' << attributeName << "=\"";
+    for (std::set<int>::const_iterator it = args.begin(); it != args.end(); ++it)
+        ostr << (it == args.begin() ? "" : ",") << *it;
+    ostr << '\"';
+}
+
+static void readArgs(const char value[], std::set<int> *args)
+{
+    if (!value)
+        return;
+    std::istringstream istr(value);
+    std::string arg;
+    while (std::getline(istr, arg, ','))
+        args->insert(std::atoi(arg.c_str()));
+}
+
+static void writeFunction(std::ostream &ostr, const char elementName[], const std::string &key, const FunctionSummaries::Summary &summary)
+{
+    const std::string::size_type colon = key.rfind(':');
+    ostr << "    <" << elementName
+         << " name=\"" << ErrorLogger::toxml(key.substr(0, colon)) << '\"'
+         << " args=\"" << key.substr(colon + 1) << '\"';
+    if (summary.knownReturnValue)
+        ostr << " returnValue=\"" << summary.returnValue << '\"';
+    if (summary.returnAllocType != 0)
+        ostr << " alloc=\"" << summary.returnAllocType << '\"';
+    writeArgs(ostr, "notnull", summary.nullArgBad);
+    writeArgs(ostr, "notuninit", summary.uninitArgBad);
+    ostr << "/>\n";
+}
+
+/** Get the key and the summary of a \<function\> or \<call\> element */
+static bool readFunction(const tinyxml2::XMLElement *e, std::string *key, FunctionSummaries::Summary *summary)
+{
+    const char *name = e->Attribute("name");
+    const char *args = e->Attribute("args");
+    if (!name || !args)
+        return false;
+    *key = std::string(name) + ':' + args;
+
+    const char *returnValue = e->Attribute("returnValue");
+    if (returnValue && MathLib::isInt(returnValue)) {
+        summary->knownReturnValue = true;
+        summary->returnValue = MathLib::toLongNumber(returnValue);
+    }
+    const char *alloc = e->Attribute("alloc");
+    if (alloc)
+        summary->returnAllocType = std::atoi(alloc);
+    readArgs(e->Attribute("notnull"), &summary->nullArgBad);
+    readArgs(e->Attribute("notuninit"), &summary->uninitArgBad);
+    return true;
+}
+
+/** Does the function always return the same known integer value? */
+static bool getReturnValue(const Function *function, MathLib::bigint *value)
+{
+    const Scope * const functionScope = function->functionScope;
+    bool found = false;
+    for (const Token *tok = functionScope->bodyStart; tok != functionScope->bodyEnd; tok = tok->next()) {
+        if (tok->str() != "return")
+            continue;
+
+        // a return in a lambda does not return from the function
+        const Scope *scope = tok->scope();
+        while (scope != functionScope && scope->type != Scope::eLambda)
+            scope = scope->nestedIn;
+        if (scope != functionScope)
+            continue;
+
+        const Token *expr = tok->astOperand1();
+        if (!expr || expr->values().size() != 1U || !expr->valueType() || !expr->valueType()->isIntegral())
+            return false;
+        const ValueFlow::Value &v = expr->values().front();
+        if (!v.isKnown() || !v.isIntValue() || (found && v.intvalue != *value))
+            return false;
+        *value = v.intvalue;
+        found = true;
+    }
+    return found;
+}
+
+/** Is the data of the pointer read? *p = 0 writes it, f(*p) and &p[0] are not known. */
+static bool isPointerDataRead(const Token *deref)
+{
+    const Token *parent = deref->astParent();
+    if (!parent || Token::Match(parent, "(|,|{|>>"))
+        return false;
+    if (parent->str() == "&" && !parent->astOperand2())
+        return false;
+    return !(parent->str() == "=" && parent->astOperand1() == deref);
+}
+
+/**
+ * Get the pointer arguments that are dereferenced and the pointer arguments
+ * whose data is read, before anything else is done with them. Only the code
+ * at the start of the function that is always executed is used.
+ */
+static void getArgumentUsage(const Function *function, const Settings *settings, FunctionSummaries::Summary *summary)
+{
+    // declaration id of the argument => argument number
+    std::map<unsigned int, int> args;
+    for (unsigned int i = 0; i < function->argCount(); ++i) {
+        const Variable * const arg = function->getArgumentVar(i);
+        if (arg && arg->declarationId() && arg->isPointer() && !arg->isArray())
+            args[arg->declarationId()] = static_cast<int>(i) + 1;
+    }
+
+    const Scope * const functionScope = function->functionScope;
+    for (const Token *tok = functionScope->bodyStart->next(); tok != functionScope->bodyEnd && !args.empty(); tok = tok->next()) {
+        if (Token::Match(tok, "sizeof|decltype|typeof ("))
+            tok = tok->next()->link();
+        else if (Token::Match(tok, "[{}?]") || Token::Match(tok, "&&|%oror%|if|else|for|while|do|switch|case|default|return|goto|break|continue|throw|try|catch"))
+            break;
+        else if (Token::Match(tok, "%name% (") && !tok->varId() && !settings->library.isnotnoreturn(tok))
+            break;
+
+        if (!tok->varId())
+            continue;
+        const std::map<unsigned int, int>::iterator arg = args.find(tok->varId());
+        if (arg == args.end())
+            continue;
+
+        bool unknown = false;
+        if (CheckNullPointer::isPointerDeRef(tok, unknown) && !unknown)
+            summary->nullArgBad.insert(arg->second);
+
+        const ValueType * const valueType = tok->valueType();
+        const Token * const parent = tok->astParent();
+        if (valueType && valueType->pointer == 1U && (valueType->isIntegral() || valueType->isFloat()) && parent &&
+            ((parent->str() == "*" && !parent->astOperand2()) || (parent->str() == "[" && parent->astOperand1() == tok)) &&
+            isPointerDataRead(parent))
+            summary->uninitArgBad.insert(arg->second);
+
+        args.erase(arg);
+    }
+}
+
+const FunctionSummaries::Summary *FunctionSummaries::find(const Function *function) const
+{
+    const std::map<std::string, Summary>::const_iterator it = _summaries.find(getKey(function));
+    return (it != _summaries.end()) ? &it->second : nullptr;
+}
+
+void FunctionSummaries::load(const tinyxml2::XMLElement *summaries)
+{
+    for (const tinyxml2::XMLElement *e = summaries->FirstChildElement("function"); e; e = e->NextSiblingElement("function")) {
+        std::string key;
+        Summary summary;
+        if (!readFunction(e, &key, &summary) || _conflicts.find(key) != _conflicts.end())
+            continue;
+        const std::pair<std::map<std::string, Summary>::iterator, bool> inserted = _summaries.insert(std::make_pair(key, summary));
+        if (!inserted.second && !(inserted.first->second == summary)) {
+            // the function is defined differently in different TUs or configurations
+            _summaries.erase(inserted.first);
+            _conflicts.insert(key);
+        }
+    }
+}
+
+bool FunctionSummaries::isUnchanged(const tinyxml2::XMLElement *summaries) const
+{
+    for (const tinyxml2::XMLElement *e = summaries->FirstChildElement("call"); e; e = e->NextSiblingElement("call")) {
+        std::string key;
+        Summary summary;
+        if (!readFunction(e, &key, &summary))
+            return false;
+        const std::map<std::string, Summary>::const_iterator it = _summaries.find(key);
+        if (!(summary == ((it != _summaries.end()) ? it->second : Summary())))
+            return false;
+    }
+    return true;
+}
+
+std::string FunctionSummaries::toXml(const Tokenizer *tokenizer, const Settings *settings)
+{
+    std::ostringstream ostr;
+    ostr << "  <summaries>\n";
+
+    // Functions that are defined in the TU
+    const CheckMemoryLeak checkMemoryLeak(tokenizer, nullptr, settings);
+    const SymbolDatabase * const symbolDatabase = tokenizer->getSymbolDatabase();
+    for (std::size_t i = 0; i < symbolDatabase->functionScopes.size(); ++i) {
+        const Function * const function = symbolDatabase->functionScopes[i]->function;
+        if (!function)
+            continue;
+        const std::string key = getKey(function);
+        if (key.empty())
+            continue;
+        Summary summary;
+        summary.knownReturnValue = getReturnValue(function, &summary.returnValue);
+        summary.returnAllocType = checkMemoryLeak.functionReturnType(function);
+        getArgumentUsage(function, settings, &summary);
+        writeFunction(ostr, "function", key, summary);
+    }
+
+    // Functions that are called and defined in other TUs. The summaries that
+    // are used now are recorded so a change is noticed in the next analysis.
+    std::set<std::string> calls;
+    for (const Token *tok = tokenizer->tokens(); tok; tok = tok->next()) {
+        if (!tok->function() || tok->function()->hasBody() || tok == tok->function()->tokenDef || tok->strAt(1) != "(")
+            continue;
+        const std::string key = getKey(tok->function());
+        if (key.empty() || !calls.insert(key).second)
+            continue;
+        const Summary *summary = settings->functionSummaries ? settings->functionSummaries->find(tok->function()) : nullptr;
+        writeFunction(ostr, "call", key, summary ? *summary : Summary());
+    }
+
+    ostr << "  </summaries>\n";
+    return ostr.str();
+}
@@ -0,0 +1,111 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2018 Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef functionsummariesH
+#define functionsummariesH
+//---------------------------------------------------------------------------
+
+#include "config.h"
+#include "mathlib.h"
+
+#include <map>
+#include <set>
+#include <string>
+
+class Function;
+class Settings;
+class Tokenizer;
+namespace tinyxml2 {
+    class XMLElement;
+}
+
+/// @addtogroup Core
+/// @{
+
+/**
+ * @brief Summaries of functions that are defined in other TUs
+ *
+ * The summaries of the functions that a TU defines are written to its
+ * analyzer info in the build dir. Before the TUs are checked, the summaries
+ * of the TUs whose files are not modified are loaded. They are used for
+ * calls to functions that have no body in the TU that is checked.
+ *
+ * Only functions in the global scope that are not static are summarized,
+ * they are identified by their name and number of arguments.
+ */
+class CPPCHECKLIB FunctionSummaries {
+public:
+    struct CPPCHECKLIB Summary {
+        Summary() : knownReturnValue(false), returnValue(0), returnAllocType(0) {}
+
+        bool operator==(const Summary &other) const {
+            return knownReturnValue == other.knownReturnValue &&
+                   returnValue == other.returnValue &&
+                   returnAllocType == other.returnAllocType &&
+                   nullArgBad == other.nullArgBad &&
+                   uninitArgBad == other.uninitArgBad;
+        }
+
+        /** The function always returns returnValue */
+        bool knownReturnValue;
+        MathLib::bigint returnValue;
+
+        /** CheckMemoryLeak::AllocType of the returned pointer */
+        int returnAllocType;
+
+        /** Pointer arguments that are always dereferenced, the first argument is 1 */
+        std::set<int> nullArgBad;
+
+        /** Pointer arguments whose data is always read before it is written */
+        std::set<int> uninitArgBad;
+    };
+
+    /** Get the summary of a function that is defined in another TU, nullptr if there is none */
+    const Summary *find(const Function *function) const;
+
+    /**
+     * Add the summaries of a TU
+     * @param summaries the \<summaries\> element of the analyzer info of the TU
+     */
+    void load(const tinyxml2::XMLElement *summaries);
+
+    /**
+     * Are the summaries that were used when a TU was analyzed still the same?
+     * @param summaries the \<summaries\> element of the analyzer info of the TU
+     */
+    bool isUnchanged(const tinyxml2::XMLElement *summaries) const;
+
+    /**
+     * Get the \<summaries\> element of a TU for its analyzer info. It has the
+     * summaries of the functions that are defined in the TU and the summaries
+     * that are used for calls to functions that are not defined in it.
+     */
+    static std::string toXml(const Tokenizer *tokenizer, const Settings *settings);
+
+private:
+    /** Summaries, the key is the name and the number of arguments */
+    std::map<std::string, Summary> _summaries;
+
+    /** Functions that have different summaries in different TUs */
+    std::set<std::string> _conflicts;
+};
+
+/// @}
+//---------------------------------------------------------------------------
+#endif // functionsummariesH
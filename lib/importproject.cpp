@@ -23,7 +23,6 @@
 #include "tinyxml2.h"
 #include "token.h"
 #include "tokenize.h"
-#include "tokenlist.h"
 #include "utils.h"
 
 #include <cstring>
@@ -68,6 +67,22 @@ void ImportProject::ignoreOtherPlatforms(cppcheck::Platform::PlatformType platfo
     }
 }
 
+std::string ImportProject::FileSettings::contextKey() const
+{
+    std::string key = cppcheckDefines();
+    key += '\n';
+    for (std::set<std::string>::const_iterator it = undefs.begin(); it != undefs.end(); ++it)
+        key += *it + ';';
+    key += '\n';
+    for (std::list<std::string>::const_iterator it = includePaths.begin(); it != includePaths.end(); ++it)
+        key += *it + ';';
+    key += '\n';
+    for (std::list<std::string>::const_iterator it = systemIncludePaths.begin(); it != systemIncludePaths.end(); ++it)
+        key += *it + ';';
+    key += '\n' + standard + '\n' + std::to_string(static_cast<int>(platformType));
+    return key;
+}
+
 void ImportProject::FileSettings::setDefines(std::string defs)
 {
     while (defs.find(";%(") != std::string::npos) {
@@ -187,105 +202,247 @@ void ImportProject::import(const std::string &filename)
     }
 }
 
-void ImportProject::importCompileCommands(std::istream &istr)
-{
-    std::map<std::string, std::string> values;
+namespace {
+    /**
+     * Streaming reader for compile_commands.json. Only the entry that is
+     * read is kept in memory. String values are not unescaped, the
+     * command parsing handles the escapes.
+     */
+    class CompileCommandsReader {
+    public:
+        explicit CompileCommandsReader(std::istream &istr) : buf(istr.rdbuf()) {}
+
+        /**
+         * Read the next entry of the compile database. An entry that is
+         * not well-formed is skipped up to its closing brace, its values
+         * are empty.
+         * @param values the string values of the entry, "arguments" are joined into "command"
+         * @return false at the end of the input
+         */
+        bool next(std::map<std::string, std::string> &values) {
+            values.clear();
+            int c = skipWhitespace();
+            // skip the array start, separators and values that are no entries
+            while (c != '{') {
+                if (c == std::char_traits<char>::eof() || c == ']')
+                    return false;
+                if (c == '[' || c == ',' || c == '}')
+                    buf->sbumpc();
+                else if (!skipValue())
+                    return false;
+                c = skipWhitespace();
+            }
+            buf->sbumpc();
+            std::string key;
+            while ((c = skipWhitespace()) == '"' || c == ',') {
+                buf->sbumpc();
+                if (c == ',')
+                    continue;
+                key.clear();
+                readString(key);
+                if (skipWhitespace() != ':')
+                    return skipEntry(values);
+                buf->sbumpc();
+                c = skipWhitespace();
+                if (c == '"') {
+                    buf->sbumpc();
+                    std::string &value = values[key];
+                    value.clear();
+                    readString(value);
+                } else if (c == '[' && key == "arguments") {
+                    buf->sbumpc();
+                    std::string &command = values["command"];
+                    command.clear();
+                    while ((c = skipWhitespace()) != ']') {
+                        if (c == '}')
+                            return skipEntry(values);
+                        if (c == '"') {
+                            buf->sbumpc();
+                            if (!command.empty())
+                                command += ' ';
+                            readString(command);
+                        } else if (c == ',') {
+                            buf->sbumpc();
+                        } else if (!skipValue()) {
+                            return false;
+                        }
+                    }
+                    buf->sbumpc();
+                } else if (!skipValue()) {
+                    return false;
+                }
+            }
+            if (c != '}')
+                return skipEntry(values);
+            buf->sbumpc();
+            return true;
+        }
 
-    // TODO: Use a JSON parser
+    private:
+        int skipWhitespace() {
+            int c = buf->sgetc();
+            while (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+                c = buf->snextc();
+            return c;
+        }
 
-    Settings settings;
-    TokenList tokenList(&settings);
-    tokenList.createTokens(istr);
-    for (const Token *tok = tokenList.front(); tok; tok = tok->next()) {
-        if (Token::Match(tok, "%str% : %str% [,}]")) {
-            const std::string& key = tok->str();
-            const std::string& value = tok->strAt(2);
-            values[key.substr(1, key.size() - 2U)] = value.substr(1, value.size() - 2U);
+        /** Append the string content up to the closing quote to str */
+        void readString(std::string &str) {
+            int c;
+            while ((c = buf->sbumpc()) != std::char_traits<char>::eof() && c != '"') {
+                str += (char)c;
+                if (c == '\\' && (c = buf->sbumpc()) != std::char_traits<char>::eof())
+                    str += (char)c;
+            }
         }
 
-        else if (Token::Match(tok, "%str% : [ %str%") && tok->str() == "\"arguments\"") {
-            std::string cmd;
-            tok = tok->tokAt(2);
-            while (Token::Match(tok, ",|[ %str%")) {
-                const std::string &s = tok->next()->str();
-                cmd += ' ' + s.substr(1, s.size() - 2);
-                tok = tok->tokAt(2);
+        /** Skip a number, literal, array or object */
+        bool skipValue() {
+            int level = 0;
+            for (int c = skipWhitespace(); c != std::char_traits<char>::eof(); c = buf->sgetc()) {
+                if (c == '"') {
+                    buf->sbumpc();
+                    std::string ignore;
+                    readString(ignore);
+                    continue;
+                }
+                if (level == 0 && (c == ',' || c == '}' || c == ']'))
+                    return true;
+                if (c == '[' || c == '{')
+                    ++level;
+                else if (c == ']' || c == '}')
+                    --level;
+                buf->sbumpc();
             }
-            values["command"] = cmd.substr(1);
+            return false;
         }
 
-        else if (tok->str() == "}") {
-            if (!values["file"].empty() && !values["command"].empty()) {
-                struct FileSettings fs;
-                fs.filename = Path::fromNativeSeparators(values["file"]);
-                const std::string& command = values["command"];
-                const std::string directory = Path::fromNativeSeparators(values["directory"]);
-                std::string::size_type pos = 0;
-                while (std::string::npos != (pos = command.find(' ',pos))) {
-                    pos++;
-                    if (pos >= command.size())
-                        break;
-                    if (command[pos] != '/' && command[pos] != '-')
-                        continue;
-                    pos++;
-                    if (pos >= command.size())
-                        break;
-                    const char F = command[pos++];
-                    if (std::strchr("DUI", F)) {
-                        while (pos < command.size() && command[pos] == ' ')
-                            ++pos;
-                    }
-                    std::string fval;
-                    while (pos < command.size() && command[pos] != ' ' && command[pos] != '=') {
-                        if (command[pos] != '\\')
-                            fval += command[pos];
-                        pos++;
-                    }
-                    if (F=='D') {
-                        std::string defval;
-                        bool escape = false;
-                        while (pos < command.size() && command[pos] != ' ') {
-                            if (command[pos] != '\\') {
-                                defval += command[pos];
-                                escape = false;
-                            } else {
-                                if (escape) {
-                                    defval += '\\';
-                                    escape = false;
-                                } else {
-                                    escape = true;
-                                }
-                            }
-                            pos++;
-                        }
-                        fs.defines += fval;
-                        if (!defval.empty())
-                            fs.defines += defval;
-                        fs.defines += ';';
-                    } else if (F=='U')
-                        fs.undefs.insert(fval);
-                    else if (F=='I')
-                        fs.includePaths.push_back(fval);
-                    else if (F=='s' && fval.compare(0,3,"td=") == 0)
-                        fs.standard = fval.substr(3);
-                    else if (F == 'i' && fval == "system") {
-                        ++pos;
-                        std::string isystem;
-                        while (pos < command.size() && command[pos] != ' ') {
-                            if (command[pos] != '\\')
-                                isystem += command[pos];
-                            pos++;
+        /**
+         * Skip the rest of an entry that is not well-formed, up to and
+         * including the closing brace, and clear its values
+         * @return false at the end of the input
+         */
+        bool skipEntry(std::map<std::string, std::string> &values) {
+            values.clear();
+            int level = 0;
+            for (int c = buf->sgetc(); c != std::char_traits<char>::eof(); c = buf->sgetc()) {
+                buf->sbumpc();
+                if (c == '"') {
+                    std::string ignore;
+                    readString(ignore);
+                } else if (c == '[' || c == '{') {
+                    ++level;
+                } else if (c == ']' || c == '}') {
+                    if (--level < 0 && c == '}')
+                        return true;
+                    if (level < 0)
+                        level = 0;
+                }
+            }
+            return false;
+        }
+
+        std::streambuf *buf;
+    };
+}
+
+void ImportProject::importCompileCommands(std::istream &istr)
+{
+    // The same flags are used for many files, process them once
+    std::map<std::string, std::string> definesCache;
+    std::map<std::string, std::list<std::string> > includePathsCache;
+
+    CompileCommandsReader reader(istr);
+    std::map<std::string, std::string> values;
+    while (reader.next(values)) {
+        if (values["file"].empty() || values["command"].empty())
+            continue;
+
+        struct FileSettings fs;
+        fs.filename = Path::fromNativeSeparators(values["file"]);
+        const std::string& command = values["command"];
+        const std::string directory = Path::fromNativeSeparators(values["directory"]);
+        std::string::size_type pos = 0;
+        while (std::string::npos != (pos = command.find(' ',pos))) {
+            pos++;
+            if (pos >= command.size())
+                break;
+            if (command[pos] != '/' && command[pos] != '-')
+                continue;
+            pos++;
+            if (pos >= command.size())
+                break;
+            const char F = command[pos++];
+            if (std::strchr("DUI", F)) {
+                while (pos < command.size() && command[pos] == ' ')
+                    ++pos;
+            }
+            std::string fval;
+            while (pos < command.size() && command[pos] != ' ' && command[pos] != '=') {
+                if (command[pos] != '\\')
+                    fval += command[pos];
+                pos++;
+            }
+            if (F=='D') {
+                std::string defval;
+                bool escape = false;
+                while (pos < command.size() && command[pos] != ' ') {
+                    if (command[pos] != '\\') {
+                        defval += command[pos];
+                        escape = false;
+                    } else {
+                        if (escape) {
+                            defval += '\\';
+                            escape = false;
+                        } else {
+                            escape = true;
                         }
-                        fs.systemIncludePaths.push_back(isystem);
                     }
+                    pos++;
+                }
+                fs.defines += fval;
+                if (!defval.empty())
+                    fs.defines += defval;
+                fs.defines += ';';
+            } else if (F=='U')
+                fs.undefs.insert(fval);
+            else if (F=='I')
+                fs.includePaths.push_back(fval);
+            else if (F=='s' && fval.compare(0,3,"td=") == 0)
+                fs.standard = fval.substr(3);
+            else if (F == 'i' && fval == "system") {
+                ++pos;
+                std::string isystem;
+                while (pos < command.size() && command[pos] != ' ') {
+                    if (command[pos] != '\\')
+                        isystem += command[pos];
+                    pos++;
                 }
-                std::map<std::string, std::string, cppcheck::stricmp> variables;
-                fs.setIncludePaths(directory, fs.includePaths, variables);
-                fs.setDefines(fs.defines);
-                fileSettings.push_back(fs);
+                fs.systemIncludePaths.push_back(isystem);
             }
-            values.clear();
         }
+
+        std::string includePathsKey = directory;
+        for (std::list<std::string>::const_iterator it = fs.includePaths.begin(); it != fs.includePaths.end(); ++it)
+            includePathsKey += '\n' + *it;
+        const std::map<std::string, std::list<std::string> >::const_iterator includePaths = includePathsCache.find(includePathsKey);
+        if (includePaths != includePathsCache.end()) {
+            fs.includePaths = includePaths->second;
+        } else {
+            std::map<std::string, std::string, cppcheck::stricmp> variables;
+            fs.setIncludePaths(directory, fs.includePaths, variables);
+            includePathsCache[includePathsKey] = fs.includePaths;
+        }
+
+        std::string &defines = definesCache[fs.defines];
+        if (defines.empty() && !fs.defines.empty()) {
+            fs.setDefines(fs.defines);
+            defines = fs.defines;
+        } else {
+            fs.defines = defines;
+        }
+
+        fileSettings.push_back(fs);
     }
 }
 
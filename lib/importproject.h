@@ -64,6 +64,12 @@ public:
         bool msc;
         bool useMfc;
 
+        /**
+         * Key of the settings the file is preprocessed with. Files
+         * with the same key can be checked with the same Settings.
+         */
+        std::string contextKey() const;
+
         void setDefines(std::string defs);
         void setIncludePaths(const std::string &basepath, const std::list<std::string> &in, std::map<std::string, std::string, cppcheck::stricmp> &variables);
     };
@@ -34,6 +34,7 @@ HEADERS += $${PWD}/check.h \
            $${PWD}/checkvaarg.h \
            $${PWD}/cppcheck.h \
            $${PWD}/errorlogger.h \
+           $${PWD}/functionsummaries.h \
            $${PWD}/importproject.h \
            $${PWD}/library.h \
            $${PWD}/mathlib.h \
@@ -82,6 +83,7 @@ SOURCES += $${PWD}/analyzerinfo.cpp \
            $${PWD}/checkvaarg.cpp \
            $${PWD}/cppcheck.cpp \
            $${PWD}/errorlogger.cpp \
+           $${PWD}/functionsummaries.cpp \
            $${PWD}/importproject.cpp \
            $${PWD}/library.cpp \
            $${PWD}/mathlib.cpp \
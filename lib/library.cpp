@@ -28,9 +28,12 @@
 #include "utils.h"
 
 #include <cctype>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <list>
+#include <mutex>
+#include <stdexcept>
 
 static std::vector<std::string> getnames(const char *names)
 {
@@ -43,10 +46,34 @@ static std::vector<std::string> getnames(const char *names)
     return ret;
 }
 
-Library::Library() : allocid(0)
+Library::Library() : allocid(0), _snapshotKey(14695981039346656037ULL), _indexedDefines(0)
 {
 }
 
+/** Read the whole file. Returns false if it can't be opened. */
+static bool readFile(const std::string &filename, std::string *data)
+{
+    FILE *f = std::fopen(filename.c_str(), "rb");
+    if (!f)
+        return false;
+    char buf[65536];
+    std::size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0)
+        data->append(buf, n);
+    std::fclose(f);
+    return true;
+}
+
+/** FNV-1a hash */
+static unsigned long long hashData(unsigned long long h, const char *data, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
 Library::Error Library::load(const char exename[], const char path[])
 {
     if (std::strchr(path,',') != nullptr) {
@@ -66,16 +93,16 @@ Library::Error Library::load(const char exename[], const char path[])
     }
 
     std::string absolute_path;
+    std::string data;
     // open file..
-    tinyxml2::XMLDocument doc;
-    tinyxml2::XMLError error = doc.LoadFile(path);
-    if (error == tinyxml2::XML_ERROR_FILE_NOT_FOUND) {
+    bool found = readFile(path, &data);
+    if (!found) {
         // failed to open file.. is there no extension?
         std::string fullfilename(path);
         if (Path::getFilenameExtension(fullfilename).empty()) {
             fullfilename += ".cfg";
-            error = doc.LoadFile(fullfilename.c_str());
-            if (error != tinyxml2::XML_ERROR_FILE_NOT_FOUND)
+            found = readFile(fullfilename, &data);
+            if (found)
                 absolute_path = Path::getAbsoluteFilePath(fullfilename);
         }
 
@@ -89,30 +116,680 @@ Library::Error Library::load(const char exename[], const char path[])
             cfgfolders.push_back(exepath);
         }
 
-        while (error == tinyxml2::XML_ERROR_FILE_NOT_FOUND && !cfgfolders.empty()) {
+        while (!found && !cfgfolders.empty()) {
             const std::string cfgfolder(cfgfolders.front());
             cfgfolders.pop_front();
             const char *sep = (!cfgfolder.empty() && endsWith(cfgfolder,'/') ? "" : "/");
             const std::string filename(cfgfolder + sep + fullfilename);
-            error = doc.LoadFile(filename.c_str());
-            if (error != tinyxml2::XML_ERROR_FILE_NOT_FOUND)
+            found = readFile(filename, &data);
+            if (found)
                 absolute_path = Path::getAbsoluteFilePath(filename);
         }
     } else
         absolute_path = Path::getAbsoluteFilePath(path);
 
-    if (error == tinyxml2::XML_SUCCESS) {
-        if (_files.find(absolute_path) == _files.end()) {
-            Error err = load(doc);
-            if (err.errorcode == OK)
-                _files.insert(absolute_path);
-            return err;
-        }
+    if (!found)
+        return Error(FILE_NOT_FOUND);
 
+    if (_files.find(absolute_path) != _files.end())
         return Error(OK); // ignore duplicates
+
+    // The snapshot contains the data of all files loaded so far, so it can
+    // only be used if the same files were loaded before in the same order.
+    const std::string snapshotFile = getSnapshotFile(absolute_path);
+    const unsigned long long key = _snapshotKey ? hashData(_snapshotKey, data.data(), data.size()) : 0;
+    if (key && !snapshotFile.empty() && loadSnapshot(snapshotFile, key))
+        return Error(OK);
+
+    tinyxml2::XMLDocument doc;
+    if (doc.Parse(data.data(), data.size()) != tinyxml2::XML_SUCCESS)
+        return Error(BAD_XML);
+
+    // The data before the file is loaded is only saved if the snapshot can be written
+    const std::string tempfile = snapshotFile + ".tmp";
+    FILE *snapshot = (key && !snapshotFile.empty()) ? std::fopen(tempfile.c_str(), "wb") : nullptr;
+    const std::string before = snapshot ? saveData() : std::string();
+    Error err = load(doc);
+    if (err.errorcode == OK) {
+        _files.insert(absolute_path);
+        _snapshotKey = key;
+    }
+    if (snapshot) {
+        if (err.errorcode == OK)
+            saveSnapshot(snapshot, snapshotFile, before);
+        else {
+            std::fclose(snapshot);
+            std::remove(tempfile.c_str());
+        }
     }
+    return err;
+}
 
-    return Error(error == tinyxml2::XML_ERROR_FILE_NOT_FOUND ? FILE_NOT_FOUND : BAD_XML);
+std::string Library::getSnapshotFile(const std::string &cfgfile) const
+{
+    if (_snapshotDir.empty())
+        return std::string();
+    const std::string::size_type pos = cfgfile.find_last_of("/\\");
+    return _snapshotDir + '/' + (pos == std::string::npos ? cfgfile : cfgfile.substr(pos + 1)) + ".cache";
+}
+
+/**
+ * The snapshot file has a header (magic, format version, key, payload size,
+ * payload hash) followed by the data that was added or changed by loading
+ * the .cfg file: new map entries and entries with a different value, new set
+ * elements and new vector elements. Loading a .cfg file never removes
+ * anything, so reading the snapshot on top of the data loaded before gives
+ * the same result as loading the .cfg file.
+ *
+ * Strings are stored as length and bytes, containers as element count and
+ * elements. The argument checks of a function are stored as a string, so
+ * they can be skipped and read when they are first used. Bump
+ * FORMAT_VERSION when the loaded data changes.
+ */
+struct Library::Snapshot {
+    static const unsigned int FORMAT_VERSION = 2;
+
+    static void write(std::string &buf, unsigned long long value) {
+        for (int i = 0; i < 8; ++i)
+            buf += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+    static void write(std::string &buf, unsigned int value) {
+        for (int i = 0; i < 4; ++i)
+            buf += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+    static void write(std::string &buf, int value) {
+        write(buf, static_cast<unsigned int>(value));
+    }
+    static void write(std::string &buf, bool value) {
+        buf += value ? '\1' : '\0';
+    }
+    static void write(std::string &buf, char value) {
+        buf += value;
+    }
+    static void write(std::string &buf, const std::string &value) {
+        write(buf, static_cast<unsigned int>(value.size()));
+        buf += value;
+    }
+    template<class T>
+    static void write(std::string &buf, const std::vector<T> &value) {
+        write(buf, static_cast<unsigned int>(value.size()));
+        for (typename std::vector<T>::const_iterator it = value.begin(); it != value.end(); ++it)
+            write(buf, *it);
+    }
+    static void write(std::string &buf, const std::set<std::string> &value) {
+        write(buf, static_cast<unsigned int>(value.size()));
+        for (std::set<std::string>::const_iterator it = value.begin(); it != value.end(); ++it)
+            write(buf, *it);
+    }
+    template<class K, class T>
+    static void write(std::string &buf, const std::map<K, T> &value) {
+        write(buf, static_cast<unsigned int>(value.size()));
+        for (typename std::map<K, T>::const_iterator it = value.begin(); it != value.end(); ++it) {
+            write(buf, it->first);
+            write(buf, it->second);
+        }
+    }
+    static void write(std::string &buf, const AllocFunc &value) {
+        write(buf, value.groupId);
+        write(buf, value.arg);
+    }
+    static void write(std::string &buf, const WarnInfo &value) {
+        write(buf, value.message);
+        write(buf, static_cast<int>(value.standards.c));
+        write(buf, static_cast<int>(value.standards.cpp));
+        write(buf, value.standards.posix);
+        write(buf, static_cast<int>(value.severity));
+    }
+    static void write(std::string &buf, const Container::Function &value) {
+        write(buf, static_cast<int>(value.action));
+        write(buf, static_cast<int>(value.yield));
+    }
+    static void write(std::string &buf, const Container &value) {
+        write(buf, value.startPattern);
+        write(buf, value.endPattern);
+        write(buf, value.itEndPattern);
+        write(buf, value.functions);
+        write(buf, value.type_templateArgNo);
+        write(buf, value.size_templateArgNo);
+        write(buf, value.arrayLike_indexOp);
+        write(buf, value.stdStringLike);
+        write(buf, value.opLessAllowed);
+    }
+    static void write(std::string &buf, const ArgumentChecks::MinSize &value) {
+        write(buf, static_cast<int>(value.type));
+        write(buf, value.arg);
+        write(buf, value.arg2);
+    }
+    static void write(std::string &buf, const ArgumentChecks &value) {
+        write(buf, value.notbool);
+        write(buf, value.notnull);
+        write(buf, value.notuninit);
+        write(buf, value.formatstr);
+        write(buf, value.strz);
+        write(buf, value.optional);
+        write(buf, value.variadic);
+        write(buf, value.valid);
+        write(buf, value.iteratorInfo.container);
+        write(buf, value.iteratorInfo.it);
+        write(buf, value.iteratorInfo.first);
+        write(buf, value.iteratorInfo.last);
+        write(buf, value.minsizes);
+    }
+    static void write(std::string &buf, const Function &value) {
+        const LazyData &lazy = value.lazyArgumentChecks;
+        if (lazy.pending())
+            write(buf, std::string(lazy._data->data() + lazy._offset, lazy._size));
+        else
+            write(buf, serialize(value.argumentChecks));
+        write(buf, value.use);
+        write(buf, value.leakignore);
+        write(buf, value.isconst);
+        write(buf, value.ispure);
+        write(buf, value.useretval);
+        write(buf, value.ignore);
+        write(buf, value.formatstr);
+        write(buf, value.formatstr_scan);
+        write(buf, value.formatstr_secure);
+    }
+    static void write(std::string &buf, const ExportedFunctions &value) {
+        write(buf, value._prefixes);
+        write(buf, value._suffixes);
+    }
+    static void write(std::string &buf, const CodeBlock &value) {
+        write(buf, value._start);
+        write(buf, value._end);
+        write(buf, value._offset);
+        write(buf, value._blocks);
+    }
+    static void write(std::string &buf, const PodType &value) {
+        write(buf, value.size);
+        write(buf, value.sign);
+    }
+    static void write(std::string &buf, const PlatformType &value) {
+        write(buf, value._type);
+        write(buf, value._signed);
+        write(buf, value._unsigned);
+        write(buf, value._long);
+        write(buf, value._pointer);
+        write(buf, value._ptr_ptr);
+        write(buf, value._const_ptr);
+    }
+    static void write(std::string &buf, const Platform &value) {
+        write(buf, value._platform_types);
+    }
+
+    /** Reads from a buffer. Once a read fails, all following reads fail. */
+    class Reader {
+    public:
+        Reader(const char *data, std::size_t size) : _pos(data), _end(data + size) {}
+
+        /** Let the read functions refer to the buffer, which is in data, instead of reading their argument checks */
+        void setLazy(const std::shared_ptr<const std::string> &data) {
+            _lazy = data;
+        }
+
+        bool ok() const {
+            return _pos != nullptr;
+        }
+        bool atEnd() const {
+            return _pos == _end;
+        }
+
+        void read(unsigned long long &value) {
+            value = 0;
+            if (!require(8))
+                return;
+            for (int i = 0; i < 8; ++i)
+                value |= static_cast<unsigned long long>(static_cast<unsigned char>(_pos[i])) << (8 * i);
+            _pos += 8;
+        }
+        void read(unsigned int &value) {
+            value = 0;
+            if (!require(4))
+                return;
+            for (int i = 0; i < 4; ++i)
+                value |= static_cast<unsigned int>(static_cast<unsigned char>(_pos[i])) << (8 * i);
+            _pos += 4;
+        }
+        void read(int &value) {
+            unsigned int u;
+            read(u);
+            value = static_cast<int>(u);
+        }
+        void read(bool &value) {
+            value = false;
+            if (require(1))
+                value = (*_pos++ != '\0');
+        }
+        void read(char &value) {
+            value = '\0';
+            if (require(1))
+                value = *_pos++;
+        }
+        void read(std::string &value) {
+            unsigned int size;
+            read(size);
+            if (require(size)) {
+                value.assign(_pos, size);
+                _pos += size;
+            }
+        }
+        template<class E>
+        void readEnum(E &value) {
+            int i;
+            read(i);
+            value = static_cast<E>(i);
+        }
+        void read(std::vector<std::string> &value) {
+            unsigned int size;
+            read(size);
+            for (unsigned int i = 0; i < size && ok(); ++i) {
+                value.emplace_back();
+                read(value.back());
+            }
+        }
+        void read(std::vector<ArgumentChecks::MinSize> &value) {
+            unsigned int size;
+            read(size);
+            for (unsigned int i = 0; i < size && ok(); ++i) {
+                value.emplace_back(ArgumentChecks::MinSize::NONE, 0);
+                readEnum(value.back().type);
+                read(value.back().arg);
+                read(value.back().arg2);
+            }
+        }
+        void read(std::set<std::string> &value) {
+            unsigned int size;
+            read(size);
+            for (unsigned int i = 0; i < size && ok(); ++i) {
+                std::string s;
+                read(s);
+                value.insert(value.end(), s);
+            }
+        }
+        template<class K, class T>
+        void read(std::map<K, T> &value) {
+            unsigned int size;
+            read(size);
+            for (unsigned int i = 0; i < size && ok(); ++i) {
+                K k;
+                read(k);
+                T v;
+                read(v);
+                if (value.empty() || value.rbegin()->first < k)
+                    value.emplace_hint(value.end(), std::move(k), std::move(v));
+                else
+                    value[k] = std::move(v);
+            }
+        }
+        void read(AllocFunc &value) {
+            read(value.groupId);
+            read(value.arg);
+        }
+        void read(WarnInfo &value) {
+            read(value.message);
+            readEnum(value.standards.c);
+            readEnum(value.standards.cpp);
+            read(value.standards.posix);
+            readEnum(value.severity);
+        }
+        void read(Container::Function &value) {
+            readEnum(value.action);
+            readEnum(value.yield);
+        }
+        void read(Container &value) {
+            read(value.startPattern);
+            read(value.endPattern);
+            read(value.itEndPattern);
+            read(value.functions);
+            read(value.type_templateArgNo);
+            read(value.size_templateArgNo);
+            read(value.arrayLike_indexOp);
+            read(value.stdStringLike);
+            read(value.opLessAllowed);
+        }
+        void read(ArgumentChecks &value) {
+            read(value.notbool);
+            read(value.notnull);
+            read(value.notuninit);
+            read(value.formatstr);
+            read(value.strz);
+            read(value.optional);
+            read(value.variadic);
+            read(value.valid);
+            read(value.iteratorInfo.container);
+            read(value.iteratorInfo.it);
+            read(value.iteratorInfo.first);
+            read(value.iteratorInfo.last);
+            read(value.minsizes);
+        }
+        void read(Function &value) {
+            unsigned int size;
+            read(size);
+            if (require(size)) {
+                if (_lazy) {
+                    value.lazyArgumentChecks._data = _lazy;
+                    value.lazyArgumentChecks._offset = _pos - _lazy->data();
+                    value.lazyArgumentChecks._size = size;
+                    value.lazyArgumentChecks._pending.store(true, std::memory_order_relaxed);
+                } else {
+                    Reader reader(_pos, size);
+                    reader.read(value.argumentChecks);
+                    if (!reader.ok())
+                        _pos = nullptr;
+                }
+                if (_pos)
+                    _pos += size;
+            }
+            read(value.use);
+            read(value.leakignore);
+            read(value.isconst);
+            read(value.ispure);
+            read(value.useretval);
+            read(value.ignore);
+            read(value.formatstr);
+            read(value.formatstr_scan);
+            read(value.formatstr_secure);
+        }
+        void read(ExportedFunctions &value) {
+            read(value._prefixes);
+            read(value._suffixes);
+        }
+        void read(CodeBlock &value) {
+            read(value._start);
+            read(value._end);
+            read(value._offset);
+            read(value._blocks);
+        }
+        void read(PodType &value) {
+            read(value.size);
+            read(value.sign);
+        }
+        void read(PlatformType &value) {
+            read(value._type);
+            read(value._signed);
+            read(value._unsigned);
+            read(value._long);
+            read(value._pointer);
+            read(value._ptr_ptr);
+            read(value._const_ptr);
+        }
+        void read(Platform &value) {
+            read(value._platform_types);
+        }
+
+    private:
+        bool require(std::size_t size) {
+            if (!_pos || static_cast<std::size_t>(_end - _pos) < size) {
+                _pos = nullptr;
+                return false;
+            }
+            return true;
+        }
+
+        const char *_pos;
+        const char *_end;
+        std::shared_ptr<const std::string> _lazy;
+    };
+
+    static void readLazy(const LazyData &lazy, std::map<int, ArgumentChecks> &argumentChecks) {
+        // the payload hash was checked when the snapshot was loaded
+        Reader reader(lazy._data->data() + lazy._offset, lazy._size);
+        reader.read(argumentChecks);
+        lazy._pending.store(false, std::memory_order_release);
+    }
+
+    /** Apply fn to all loaded data of the library, in a fixed order */
+    template<class L, class F>
+    static void forEachMember(L &lib, F fn) {
+        fn(lib.allocid);
+        fn(lib._files);
+        fn(lib._alloc);
+        fn(lib._dealloc);
+        fn(lib._noreturn);
+        fn(lib._returnValue);
+        fn(lib._returnValueType);
+        fn(lib._returnValueContainer);
+        fn(lib._reporterrors);
+        fn(lib._processAfterCode);
+        fn(lib._markupExtensions);
+        fn(lib._keywords);
+        fn(lib._executableblocks);
+        fn(lib._exporters);
+        fn(lib._importers);
+        fn(lib._reflection);
+        fn(lib.podtypes);
+        fn(lib.platform_types);
+        fn(lib.platforms);
+        fn(lib.functionwarn);
+        fn(lib.containers);
+        fn(lib.functions);
+        fn(lib.returnuninitdata);
+        fn(lib.defines);
+    }
+
+    template<class T>
+    static std::string serialize(const T &value) {
+        std::string buf;
+        write(buf, value);
+        return buf;
+    }
+
+    static void writeDelta(std::string &buf, int before, int after) {
+        (void)before;
+        write(buf, after);
+    }
+    static void writeDelta(std::string &buf, const std::vector<std::string> &before, const std::vector<std::string> &after) {
+        write(buf, std::vector<std::string>(after.begin() + before.size(), after.end()));
+    }
+    static void writeDelta(std::string &buf, const std::set<std::string> &before, const std::set<std::string> &after) {
+        std::set<std::string> added;
+        for (std::set<std::string>::const_iterator it = after.begin(); it != after.end(); ++it) {
+            if (before.find(*it) == before.end())
+                added.insert(added.end(), *it);
+        }
+        write(buf, added);
+    }
+    template<class K, class T>
+    static void writeDelta(std::string &buf, const std::map<K, T> &before, const std::map<K, T> &after) {
+        std::map<K, T> changed;
+        for (typename std::map<K, T>::const_iterator it = after.begin(); it != after.end(); ++it) {
+            const typename std::map<K, T>::const_iterator old = before.find(it->first);
+            if (old == before.end() || serialize(old->second) != serialize(it->second))
+                changed.insert(changed.end(), *it);
+        }
+        write(buf, changed);
+    }
+
+    struct WriteMember {
+        explicit WriteMember(std::string &b) : buf(b) {}
+        template<class T>
+        void operator()(const T &member) const {
+            write(buf, member);
+        }
+        std::string &buf;
+    };
+
+    /** Writes what was changed compared to the serialized data that is read by the reader */
+    struct WriteMemberDelta {
+        WriteMemberDelta(Reader &r, std::string &b) : before(r), buf(b) {}
+        template<class T>
+        void operator()(const T &member) const {
+            T old;
+            before.read(old);
+            writeDelta(buf, old, member);
+        }
+        Reader &before;
+        std::string &buf;
+    };
+
+    struct ReadMember {
+        explicit ReadMember(Reader &r) : reader(r) {}
+        template<class T>
+        void operator()(T &member) const {
+            reader.read(member);
+        }
+        Reader &reader;
+    };
+
+    static const char *magic() {
+        return "CLIB";
+    }
+
+    /** The size of Library is used to notice added members in builds that forgot to bump FORMAT_VERSION */
+    static unsigned int version() {
+        return FORMAT_VERSION * 0x10000U + static_cast<unsigned int>(sizeof(Library));
+    }
+};
+
+bool Library::loadSnapshot(const std::string &filename, unsigned long long key)
+{
+    std::shared_ptr<std::string> buffer = std::make_shared<std::string>();
+    if (!readFile(filename, buffer.get()))
+        return false;
+    const std::string &data = *buffer;
+
+    // header
+    const std::size_t headerSize = 4 + 4 + 8 + 8 + 8;
+    if (data.size() < headerSize || data.compare(0, 4, Snapshot::magic()) != 0)
+        return false;
+    Snapshot::Reader header(data.data() + 4, headerSize - 4);
+    unsigned int version;
+    unsigned long long fileKey, payloadSize, payloadHash;
+    header.read(version);
+    header.read(fileKey);
+    header.read(payloadSize);
+    header.read(payloadHash);
+    if (!header.ok() || version != Snapshot::version() || fileKey != key || payloadSize != data.size() - headerSize)
+        return false;
+    const char * const payload = data.data() + headerSize;
+    if (payloadHash != hashData(14695981039346656037ULL, payload, payloadSize))
+        return false;
+
+    // The payload hash was checked, so the snapshot is read into the
+    // loaded data directly. If it fails anyway the .cfg file is loaded and
+    // overwrites the entries of the file.
+    Snapshot::Reader reader(payload, payloadSize);
+    reader.setLazy(buffer);
+    Snapshot::forEachMember(*this, Snapshot::ReadMember(reader));
+    indexDefines();
+    if (!reader.ok() || !reader.atEnd())
+        return false;
+
+    _snapshotKey = key;
+    return true;
+}
+
+/** Protects reading the lazy data of all libraries, the checks may do that concurrently */
+static std::mutex lazyDataMutex;
+
+const std::map<int, Library::ArgumentChecks> &Library::getArgumentChecks(const Function &func)
+{
+    if (func.lazyArgumentChecks.pending()) {
+        std::lock_guard<std::mutex> lock(lazyDataMutex);
+        if (func.lazyArgumentChecks.pending()) {
+            // the function is in the non-const functions map
+            Snapshot::readLazy(func.lazyArgumentChecks, const_cast<Function &>(func).argumentChecks);
+        }
+    }
+    return func.argumentChecks;
+}
+
+std::string Library::saveData() const
+{
+    std::string data;
+    Snapshot::forEachMember(*this, Snapshot::WriteMember(data));
+    return data;
+}
+
+void Library::saveSnapshot(FILE *f, const std::string &filename, const std::string &before) const
+{
+    std::string payload;
+    Snapshot::Reader reader(before.data(), before.size());
+    Snapshot::forEachMember(*this, Snapshot::WriteMemberDelta(reader, payload));
+
+    std::string data(Snapshot::magic());
+    Snapshot::write(data, Snapshot::version());
+    Snapshot::write(data, _snapshotKey);
+    Snapshot::write(data, static_cast<unsigned long long>(payload.size()));
+    Snapshot::write(data, hashData(14695981039346656037ULL, payload.data(), payload.size()));
+    data += payload;
+
+    // The temporary file is renamed so a concurrent cppcheck never reads a
+    // half written snapshot. Errors are ignored, the snapshot is only an
+    // optimisation.
+    const std::string tempfile = filename + ".tmp";
+    const bool written = (std::fwrite(data.data(), 1, data.size(), f) == data.size());
+    if (std::fclose(f) == 0 && written) {
+        std::remove(filename.c_str());
+        if (std::rename(tempfile.c_str(), filename.c_str()) == 0)
+            return;
+    }
+    std::remove(tempfile.c_str());
+}
+
+void Library::indexDefines()
+{
+    for (; _indexedDefines < defines.size(); ++_indexedDefines) {
+        const std::string &def = defines[_indexedDefines];
+        if (def.compare(0, 8, "#define ") != 0)
+            continue;
+        const std::string::size_type end = def.find_first_of(" (", 8);
+        _defineIndex[def.substr(8, end - 8)].push_back(_indexedDefines);
+    }
+}
+
+static bool isNameChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+std::vector<const std::string *> Library::getDefines(const std::set<std::string> &names) const
+{
+    std::vector<const std::string *> ret;
+    std::vector<bool> needed(defines.size(), false);
+    bool all = (_indexedDefines != defines.size()); // defines were added without loading a file
+
+    std::set<std::string> seen(names);
+    std::vector<std::string> todo(names.begin(), names.end());
+    while (!todo.empty() && !all) {
+        const std::unordered_map<std::string, std::vector<std::size_t> >::const_iterator it = _defineIndex.find(todo.back());
+        todo.pop_back();
+        if (it == _defineIndex.end())
+            continue;
+        for (std::size_t index : it->second) {
+            if (needed[index])
+                continue;
+            needed[index] = true;
+            const std::string &def = defines[index];
+            if (def.find("##") != std::string::npos) {
+                all = true;
+                break;
+            }
+            // the names that the define uses
+            std::string::size_type pos = 8 + it->first.size();
+            while (pos < def.size()) {
+                if (!isNameChar(def[pos])) {
+                    ++pos;
+                    continue;
+                }
+                const std::string::size_type start = pos;
+                while (pos < def.size() && isNameChar(def[pos]))
+                    ++pos;
+                if (!std::isdigit(static_cast<unsigned char>(def[start]))) {
+                    const std::string name = def.substr(start, pos - start);
+                    if (seen.insert(name).second)
+                        todo.push_back(name);
+                }
+            }
+        }
+    }
+
+    for (std::size_t index = 0; index < defines.size(); ++index) {
+        if (all || needed[index])
+            ret.push_back(&defines[index]);
+    }
+    return ret;
 }
 
 bool Library::loadxmldata(const char xmldata[], std::size_t len)
@@ -123,6 +800,8 @@ bool Library::loadxmldata(const char xmldata[], std::size_t len)
 
 Library::Error Library::load(const tinyxml2::XMLDocument &doc)
 {
+    _snapshotKey = 0;
+
     const tinyxml2::XMLElement * const rootnode = doc.FirstChildElement();
 
     if (rootnode == nullptr)
@@ -515,6 +1194,7 @@ Library::Error Library::load(const tinyxml2::XMLDocument &doc)
         else
             unknown_elements.insert(nodename);
     }
+    indexDefines();
     if (!unknown_elements.empty()) {
         std::string str;
         for (std::set<std::string>::const_iterator i = unknown_elements.begin(); i != unknown_elements.end();) {
@@ -533,6 +1213,7 @@ Library::Error Library::loadFunction(const tinyxml2::XMLElement * const node, co
         return Error(OK);
 
     Function& func = functions[name];
+    getArgumentChecks(func); // read it from the snapshot before it is changed
 
     for (const tinyxml2::XMLElement *functionnode = node->FirstChildElement(); functionnode; functionnode = functionnode->NextSiblingElement()) {
         const std::string functionnodename = functionnode->Name();
@@ -769,6 +1450,13 @@ std::string Library::getFunctionName(const Token *ftok, bool *error) const
 }
 
 std::string Library::getFunctionName(const Token *ftok) const
+{
+    if (const LibraryCall *call = getCall(ftok))
+        return call->name;
+    return resolveFunctionName(ftok);
+}
+
+std::string Library::resolveFunctionName(const Token *ftok) const
 {
     if (!Token::Match(ftok, "%name% (") && (ftok->strAt(-1) != "&" || ftok->previous()->astOperand2()))
         return "";
@@ -794,14 +1482,40 @@ std::string Library::getFunctionName(const Token *ftok) const
     return ret;
 }
 
+const LibraryCall *Library::getCall(const Token *ftok) const
+{
+    LibraryCall *call = ftok->libraryCall();
+    if (!call)
+        return nullptr;
+    int state = call->state.load(std::memory_order_acquire);
+    if (state == LibraryCall::UNRESOLVED && call->state.compare_exchange_strong(state, LibraryCall::RESOLVING, std::memory_order_acquire)) {
+        call->library = this;
+        call->name = resolveFunctionName(ftok);
+        call->notLibraryFunction = resolveNotLibraryFunction(ftok, call->name);
+        const std::map<std::string, Function>::const_iterator it = functions.find(call->name);
+        call->function = (it != functions.end()) ? &it->second : nullptr;
+        state = LibraryCall::RESOLVED;
+        call->state.store(state, std::memory_order_release);
+    }
+    // while another thread resolves the call it is not cached yet
+    return (state == LibraryCall::RESOLVED && call->library == this) ? call : nullptr;
+}
+
+const Library::Function *Library::getFunction(const Token *ftok) const
+{
+    if (const LibraryCall *call = getCall(ftok))
+        return call->function;
+    const std::map<std::string, Function>::const_iterator it = functions.find(getFunctionName(ftok));
+    return (it != functions.end()) ? &it->second : nullptr;
+}
+
 bool Library::isnullargbad(const Token *ftok, int argnr) const
 {
     const ArgumentChecks *arg = getarg(ftok, argnr);
     if (!arg) {
         // scan format string argument should not be null
-        const std::string funcname = getFunctionName(ftok);
-        const std::map<std::string, Function>::const_iterator it = functions.find(funcname);
-        if (it != functions.cend() && it->second.formatstr && it->second.formatstr_scan)
+        const Function *func = getFunction(ftok);
+        if (func && func->formatstr && func->formatstr_scan)
             return true;
     }
     return arg && arg->notnull;
@@ -812,9 +1526,8 @@ bool Library::isuninitargbad(const Token *ftok, int argnr) const
     const ArgumentChecks *arg = getarg(ftok, argnr);
     if (!arg) {
         // non-scan format string argument should not be uninitialized
-        const std::string funcname = getFunctionName(ftok);
-        const std::map<std::string, Function>::const_iterator it = functions.find(funcname);
-        if (it != functions.cend() && it->second.formatstr && !it->second.formatstr_scan)
+        const Function *func = getFunction(ftok);
+        if (func && func->formatstr && !func->formatstr_scan)
             return true;
     }
     return arg && arg->notuninit;
@@ -854,14 +1567,15 @@ const Library::ArgumentChecks * Library::getarg(const Token *ftok, int argnr) co
 {
     if (isNotLibraryFunction(ftok))
         return nullptr;
-    const std::map<std::string, Function>::const_iterator it1 = functions.find(getFunctionName(ftok));
-    if (it1 == functions.cend())
+    const Function *func = getFunction(ftok);
+    if (!func)
         return nullptr;
-    const std::map<int,ArgumentChecks>::const_iterator it2 = it1->second.argumentChecks.find(argnr);
-    if (it2 != it1->second.argumentChecks.cend())
+    const std::map<int,ArgumentChecks> &argumentChecks = getArgumentChecks(*func);
+    const std::map<int,ArgumentChecks>::const_iterator it2 = argumentChecks.find(argnr);
+    if (it2 != argumentChecks.cend())
         return &it2->second;
-    const std::map<int,ArgumentChecks>::const_iterator it3 = it1->second.argumentChecks.find(-1);
-    if (it3 != it1->second.argumentChecks.cend())
+    const std::map<int,ArgumentChecks>::const_iterator it3 = argumentChecks.find(-1);
+    if (it3 != argumentChecks.cend())
         return &it3->second;
     return nullptr;
 }
@@ -942,6 +1656,13 @@ bool Library::isContainerYield(const Token * const cond, Library::Container::Yie
 
 // returns true if ftok is not a library function
 bool Library::isNotLibraryFunction(const Token *ftok) const
+{
+    if (const LibraryCall *call = getCall(ftok))
+        return call->notLibraryFunction;
+    return resolveNotLibraryFunction(ftok, resolveFunctionName(ftok));
+}
+
+bool Library::resolveNotLibraryFunction(const Token *ftok, const std::string &functionName) const
 {
     if (ftok->function() && ftok->function()->nestedIn && ftok->function()->nestedIn->type != Scope::eGlobal)
         return true;
@@ -950,7 +1671,7 @@ bool Library::isNotLibraryFunction(const Token *ftok) const
     if (ftok->varId())
         return true;
 
-    return !matchArguments(ftok, getFunctionName(ftok));
+    return !matchArguments(ftok, functionName);
 }
 
 bool Library::matchArguments(const Token *ftok, const std::string &functionName) const
@@ -961,7 +1682,8 @@ bool Library::matchArguments(const Token *ftok, const std::string &functionName)
         return (callargs == 0);
     int args = 0;
     int firstOptionalArg = -1;
-    for (std::map<int, ArgumentChecks>::const_iterator it2 = it->second.argumentChecks.cbegin(); it2 != it->second.argumentChecks.cend(); ++it2) {
+    const std::map<int, ArgumentChecks> &argumentChecks = getArgumentChecks(it->second);
+    for (std::map<int, ArgumentChecks>::const_iterator it2 = argumentChecks.cbegin(); it2 != argumentChecks.cend(); ++it2) {
         if (it2->first > args)
             args = it2->first;
         if (it2->second.optional && (firstOptionalArg == -1 || firstOptionalArg > it2->first))
@@ -988,15 +1710,21 @@ bool Library::formatstr_function(const Token* ftok) const
     if (isNotLibraryFunction(ftok))
         return false;
 
-    const std::map<std::string, Function>::const_iterator it = functions.find(getFunctionName(ftok));
-    if (it != functions.cend())
-        return it->second.formatstr;
-    return false;
+    const Function *func = getFunction(ftok);
+    return func && func->formatstr;
+}
+
+const Library::Function &Library::getFormatstrFunction(const Token *ftok) const
+{
+    const Function *func = getFunction(ftok);
+    if (!func)
+        throw std::out_of_range("not a library function: " + getFunctionName(ftok));
+    return *func;
 }
 
 int Library::formatstr_argno(const Token* ftok) const
 {
-    const std::map<int, Library::ArgumentChecks>& argumentChecksFunc = functions.at(getFunctionName(ftok)).argumentChecks;
+    const std::map<int, Library::ArgumentChecks>& argumentChecksFunc = getArgumentChecks(getFormatstrFunction(ftok));
     for (std::map<int, Library::ArgumentChecks>::const_iterator i = argumentChecksFunc.cbegin(); i != argumentChecksFunc.cend(); ++i) {
         if (i->second.formatstr) {
             return i->first - 1;
@@ -1007,22 +1735,20 @@ int Library::formatstr_argno(const Token* ftok) const
 
 bool Library::formatstr_scan(const Token* ftok) const
 {
-    return functions.at(getFunctionName(ftok)).formatstr_scan;
+    return getFormatstrFunction(ftok).formatstr_scan;
 }
 
 bool Library::formatstr_secure(const Token* ftok) const
 {
-    return functions.at(getFunctionName(ftok)).formatstr_secure;
+    return getFormatstrFunction(ftok).formatstr_secure;
 }
 
 bool Library::isUseRetVal(const Token* ftok) const
 {
     if (isNotLibraryFunction(ftok))
         return false;
-    const std::map<std::string, Function>::const_iterator it = functions.find(getFunctionName(ftok));
-    if (it != functions.cend())
-        return it->second.useretval;
-    return false;
+    const Function *func = getFunction(ftok);
+    return func && func->useretval;
 }
 
 const std::string& Library::returnValue(const Token *ftok) const
@@ -1054,7 +1780,8 @@ bool Library::hasminsize(const std::string &functionName) const
     const std::map<std::string, Function>::const_iterator it1 = functions.find(functionName);
     if (it1 == functions.cend())
         return false;
-    for (std::map<int, ArgumentChecks>::const_iterator it2 = it1->second.argumentChecks.cbegin(); it2 != it1->second.argumentChecks.cend(); ++it2) {
+    const std::map<int, ArgumentChecks> &argumentChecks = getArgumentChecks(it1->second);
+    for (std::map<int, ArgumentChecks>::const_iterator it2 = argumentChecks.cbegin(); it2 != argumentChecks.cend(); ++it2) {
         if (!it2->second.minsizes.empty())
             return true;
     }
@@ -1095,8 +1822,8 @@ bool Library::isFunctionConst(const Token *ftok) const
         return true;
     if (isNotLibraryFunction(ftok))
         return false;
-    const std::map<std::string, Function>::const_iterator it = functions.find(getFunctionName(ftok));
-    return (it != functions.end() && it->second.isconst);
+    const Function *func = getFunction(ftok);
+    return func && func->isconst;
 }
 bool Library::isnoreturn(const Token *ftok) const
 {
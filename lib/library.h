@@ -26,14 +26,19 @@
 #include "mathlib.h"
 #include "standards.h"
 
+#include <atomic>
 #include <cstddef>
+#include <cstdio>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 class Token;
+struct LibraryCall;
 
 namespace tinyxml2 {
     class XMLDocument;
@@ -49,6 +54,10 @@ namespace tinyxml2 {
 class CPPCHECKLIB Library {
     friend class TestSymbolDatabase; // For testing only
 
+    /** Binary serialization of the loaded data, see library.cpp */
+    struct Snapshot;
+    friend struct Snapshot;
+
 public:
     Library();
 
@@ -70,6 +79,17 @@ public:
     /** this is primarily meant for unit tests. it only returns true/false */
     bool loadxmldata(const char xmldata[], std::size_t len);
 
+    /**
+     * Set the directory where binary snapshots of the loaded library are
+     * written and read. Without a directory no snapshots are used.
+     */
+    void setSnapshotDir(const std::string &dir) {
+        _snapshotDir = dir;
+    }
+
+    /** Get the snapshot file that is used when the given .cfg file is loaded, empty if there is no snapshot dir */
+    std::string getSnapshotFile(const std::string &cfgfile) const;
+
     struct AllocFunc {
         int groupId;
         int arg;
@@ -111,17 +131,20 @@ public:
 
     /** set allocation id for function */
     void setalloc(const std::string &functionname, int id, int arg) {
+        _snapshotKey = 0;
         _alloc[functionname].groupId = id;
         _alloc[functionname].arg = arg;
     }
 
     void setdealloc(const std::string &functionname, int id, int arg) {
+        _snapshotKey = 0;
         _dealloc[functionname].groupId = id;
         _dealloc[functionname].arg = arg;
     }
 
     /** add noreturn function setting */
     void setnoreturn(const std::string& funcname, bool noreturn) {
+        _snapshotKey = 0;
         _noreturn[funcname] = noreturn;
     }
 
@@ -262,8 +285,44 @@ public:
     };
 
 
+    /**
+     * Part of a binary snapshot that is only read when it is first used.
+     * Copies share the snapshot data.
+     */
+    class LazyData {
+    public:
+        LazyData() : _offset(0), _size(0), _pending(false) {}
+        LazyData(const LazyData &other) : _data(other._data), _offset(other._offset), _size(other._size), _pending(other.pending()) {}
+        LazyData &operator=(const LazyData &other) {
+            _data = other._data;
+            _offset = other._offset;
+            _size = other._size;
+            _pending.store(other.pending(), std::memory_order_relaxed);
+            return *this;
+        }
+
+        /** Is the data not read yet? */
+        bool pending() const {
+            return _pending.load(std::memory_order_acquire);
+        }
+
+    private:
+        friend struct Snapshot;
+        std::shared_ptr<const std::string> _data;
+        std::size_t _offset;
+        std::size_t _size;
+        mutable std::atomic<bool> _pending;
+    };
+
     struct Function {
-        std::map<int, ArgumentChecks> argumentChecks; // argument nr => argument data
+        /**
+         * argument nr => argument data. Functions that are loaded from a
+         * snapshot read it when it is first used, see getArgumentChecks().
+         * Functions that are loaded from the XML have it at once, the
+         * argument elements are validated while the file is loaded.
+         */
+        std::map<int, ArgumentChecks> argumentChecks;
+        LazyData lazyArgumentChecks;
         bool use;
         bool leakignore;
         bool isconst;
@@ -277,6 +336,10 @@ public:
     };
 
     std::map<std::string, Function> functions;
+
+    /** Get the argument checks of the function, they are read from the snapshot if they were not read yet */
+    static const std::map<int, ArgumentChecks> &getArgumentChecks(const Function &func);
+
     bool isUse(const std::string& functionName) const;
     bool isLeakIgnore(const std::string& functionName) const;
     bool isFunctionConst(const std::string& functionName, bool pure) const;
@@ -370,6 +433,19 @@ public:
     std::set<std::string> returnuninitdata;
     std::vector<std::string> defines; // to provide some library defines
 
+    /** Is there a library define with the given name? */
+    bool isDefine(const std::string &name) const {
+        return _defineIndex.find(name) != _defineIndex.end();
+    }
+
+    /**
+     * Get the defines that are needed to preprocess code that uses the
+     * given names: the defines with these names and the defines that they
+     * use, in load order. All defines are returned if a needed define
+     * pastes tokens together, because the pasted name is not known here.
+     */
+    std::vector<const std::string *> getDefines(const std::set<std::string> &names) const;
+
     struct PodType {
         unsigned int   size;
         char           sign;
@@ -440,7 +516,24 @@ private:
     // load a <function> xml node
     Error loadFunction(const tinyxml2::XMLElement * const node, const std::string &name, std::set<std::string> &unknown_elements);
 
+    /** Read the snapshot in the given file into the loaded data, if it was saved with the given key */
+    bool loadSnapshot(const std::string &filename, unsigned long long key);
+
+    /** Serialize all loaded data */
+    std::string saveData() const;
+
+    /**
+     * Write what was loaded after saveData() returned the given data to the
+     * snapshot file. It is written to the opened temporary file f, which is
+     * closed and renamed to filename.
+     */
+    void saveSnapshot(FILE *f, const std::string &filename, const std::string &before) const;
+
+    /** Add the defines that were loaded since the last call to the index, see getDefines() */
+    void indexDefines();
+
     class ExportedFunctions {
+        friend struct Snapshot;
     public:
         void addPrefix(const std::string& prefix) {
             _prefixes.insert(prefix);
@@ -460,6 +553,7 @@ private:
         std::set<std::string> _suffixes;
     };
     class CodeBlock {
+        friend struct Snapshot;
     public:
         CodeBlock() : _offset(0) {}
 
@@ -495,6 +589,12 @@ private:
         std::set<std::string> _blocks;
     };
     int allocid;
+    std::string _snapshotDir;
+    /**
+     * Hash of the contents of all .cfg files loaded so far, in load order.
+     * 0 if the data was changed some other way; then no snapshot is used.
+     */
+    unsigned long long _snapshotKey;
     std::set<std::string> _files;
     std::map<std::string, AllocFunc> _alloc; // allocation functions
     std::map<std::string, AllocFunc> _dealloc; // deallocation functions
@@ -513,17 +613,46 @@ private:
     std::map<std::string, struct PodType> podtypes; // pod types
     std::map<std::string, PlatformType> platform_types; // platform independent typedefs
     std::map<std::string, Platform> platforms; // platform dependent typedefs
+    std::unordered_map<std::string, std::vector<std::size_t> > _defineIndex; // define name => indexes in defines
+    std::size_t _indexedDefines;
 
     const ArgumentChecks * getarg(const Token *ftok, int argnr) const;
 
     std::string getFunctionName(const Token *ftok, bool *error) const;
 
+    /** the resolved call of ftok, if it was resolved by this library */
+    const LibraryCall *getCall(const Token *ftok) const;
+
+    std::string resolveFunctionName(const Token *ftok) const;
+    bool resolveNotLibraryFunction(const Token *ftok, const std::string &functionName) const;
+
+    /** the function of the call, nullptr if there is no such library function */
+    const Function *getFunction(const Token *ftok) const;
+
+    /** the function of a formatstr_function() call */
+    const Function &getFormatstrFunction(const Token *ftok) const;
+
     static const AllocFunc* getAllocDealloc(const std::map<std::string, AllocFunc> &data, const std::string &name) {
         const std::map<std::string, AllocFunc>::const_iterator it = data.find(name);
         return (it == data.end()) ? nullptr : &it->second;
     }
 };
 
+/**
+ * What the library says about one function call. It is resolved by the
+ * first query, see TokenList::createLibraryCalls()
+ */
+struct LibraryCall {
+    enum State { UNRESOLVED, RESOLVING, RESOLVED };
+    LibraryCall() : state(UNRESOLVED), library(nullptr), notLibraryFunction(false), function(nullptr) {}
+
+    std::atomic<int> state;
+    const Library *library;             // the library that resolved the call
+    std::string name;                   // getFunctionName()
+    bool notLibraryFunction;            // isNotLibraryFunction()
+    const Library::Function *function;  // nullptr if name is not a library function
+};
+
 /// @}
 //---------------------------------------------------------------------------
 #endif // libraryH
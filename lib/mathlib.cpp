@@ -21,6 +21,7 @@
 #include "errorlogger.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cmath>
 #include <cstdlib>
@@ -290,6 +291,90 @@ MathLib::value MathLib::value::shiftRight(const MathLib::value &v) const
 }
 
 
+static MathLib::number::Suffix getIntSuffix(const std::string &str)
+{
+    const std::string suffix = MathLib::getSuffix(str);
+    if (suffix == "ULL")
+        return MathLib::number::ULL;
+    if (suffix == "LL")
+        return MathLib::number::LL;
+    if (suffix == "UL")
+        return MathLib::number::UL;
+    if (suffix == "L")
+        return MathLib::number::L;
+    if (suffix == "U")
+        return MathLib::number::U;
+    return MathLib::number::NONE;
+}
+
+bool MathLib::number::parse(const std::string &str, MathLib::number *result)
+{
+    if (MathLib::isFloat(str)) {
+        result->floatValue = true;
+        result->intValue = MathLib::toLongNumber(str);
+        result->doubleValue = MathLib::toDoubleNumber(str);
+        result->suffix = NONE;
+        return true;
+    }
+    if (!MathLib::isInt(str))
+        return false;
+    result->floatValue = false;
+    result->intValue = MathLib::toLongNumber(str);
+    result->doubleValue = 0.0;
+    result->suffix = getIntSuffix(str);
+    return true;
+}
+
+MathLib::number MathLib::number::calculate(const MathLib::number &first, const MathLib::number &second, char action)
+{
+    const bigint a = first.intValue;
+    const bigint b = second.intValue;
+    number ret;
+    ret.suffix = std::max(first.suffix, second.suffix);
+    switch (action) {
+    case '+':
+        ret.intValue = a + b;
+        break;
+    case '-':
+        ret.intValue = a - b;
+        break;
+    case '*':
+        ret.intValue = a * b;
+        break;
+    case '/':
+        if (b == 0)
+            throw InternalError(nullptr, "Internal Error: Division by zero");
+        if (a == std::numeric_limits<bigint>::min() && std::abs(b)<=1)
+            throw InternalError(nullptr, "Internal Error: Division overflow");
+        ret.intValue = a / b;
+        break;
+    case '%':
+        if (b == 0)
+            throw InternalError(nullptr, "Internal Error: Division by zero");
+        ret.intValue = a % b;
+        break;
+    case '&':
+        ret.intValue = a & b;
+        break;
+    case '|':
+        ret.intValue = a | b;
+        break;
+    case '^':
+        ret.intValue = a ^ b;
+        break;
+    default:
+        throw InternalError(nullptr, std::string("Unexpected action '") + action + "' in MathLib::calculate(). Please report this to Cppcheck developers.");
+    }
+    return ret;
+}
+
+std::string MathLib::number::str() const
+{
+    static const char * const suffixes[] = { "", "U", "L", "UL", "LL", "ULL" };
+    return MathLib::toString(intValue) + suffixes[suffix];
+}
+
+
 MathLib::biguint MathLib::toULongNumber(const std::string & str)
 {
     // hexadecimal numbers:
@@ -483,6 +568,22 @@ std::string MathLib::normalizeCharacterLiteral(const std::string& iLiteral)
 
 MathLib::bigint MathLib::toLongNumber(const std::string & str)
 {
+    // decimal numbers that can't overflow, this is the common case
+    {
+        const std::string::size_type start = (str[0] == '-') ? 1U : 0U;
+        std::string::size_type pos = start;
+        bigint ret = 0;
+        while (pos < str.size() && pos - start < 18U && std::isdigit((unsigned char)str[pos])) {
+            ret = ret * 10 + (str[pos] - '0');
+            ++pos;
+        }
+        const std::string::size_type digits = pos - start;
+        while (pos < str.size() && (str[pos] == 'u' || str[pos] == 'U' || str[pos] == 'l' || str[pos] == 'L'))
+            ++pos;
+        if (pos == str.size() && digits > 0U && (digits == 1U || str[start] != '0'))
+            return (start == 1U) ? -ret : ret;
+    }
+
     // hexadecimal numbers:
     if (isIntHex(str)) {
         if (str[0] == '-') {
@@ -571,6 +672,11 @@ double MathLib::toDoubleNumber(const std::string &str)
     return ret;
 }
 
+template<> std::string MathLib::toString(MathLib::bigint value)
+{
+    return std::to_string(value);
+}
+
 template<> std::string MathLib::toString(double value)
 {
     std::ostringstream result;
@@ -1082,13 +1188,22 @@ static std::string intsuffix(const std::string & first, const std::string & seco
     return suffix1.empty() ? suffix2 : suffix1;
 }
 
+/** Calculation with integer literal operands */
+static std::string calculateInt(const std::string &first, const std::string &second, char action)
+{
+    MathLib::number n1, n2;
+    MathLib::number::parse(first, &n1);
+    MathLib::number::parse(second, &n2);
+    return MathLib::number::calculate(n1, n2, action).str();
+}
+
 std::string MathLib::add(const std::string & first, const std::string & second)
 {
 #ifdef TEST_MATHLIB_VALUE
     return (value(first) + value(second)).str();
 #else
     if (MathLib::isInt(first) && MathLib::isInt(second)) {
-        return toString(toLongNumber(first) + toLongNumber(second)) + intsuffix(first, second);
+        return calculateInt(first, second, '+');
     }
 
     double d1 = toDoubleNumber(first);
@@ -1110,7 +1225,7 @@ std::string MathLib::subtract(const std::string &first, const std::string &secon
     return (value(first) - value(second)).str();
 #else
     if (MathLib::isInt(first) && MathLib::isInt(second)) {
-        return toString(toLongNumber(first) - toLongNumber(second)) + intsuffix(first, second);
+        return calculateInt(first, second, '-');
     }
 
     if (first == second)
@@ -1152,13 +1267,7 @@ std::string MathLib::divide(const std::string &first, const std::string &second)
     return (value(first) / value(second)).str();
 #else
     if (MathLib::isInt(first) && MathLib::isInt(second)) {
-        const bigint a = toLongNumber(first);
-        const bigint b = toLongNumber(second);
-        if (b == 0)
-            throw InternalError(nullptr, "Internal Error: Division by zero");
-        if (a == std::numeric_limits<bigint>::min() && std::abs(b)<=1)
-            throw InternalError(nullptr, "Internal Error: Division overflow");
-        return toString(toLongNumber(first) / b) + intsuffix(first, second);
+        return calculateInt(first, second, '/');
     } else if (isNullValue(second)) {
         if (isNullValue(first))
             return "nan.0";
@@ -1174,7 +1283,7 @@ std::string MathLib::multiply(const std::string &first, const std::string &secon
     return (value(first) * value(second)).str();
 #else
     if (MathLib::isInt(first) && MathLib::isInt(second)) {
-        return toString(toLongNumber(first) * toLongNumber(second)) + intsuffix(first, second);
+        return calculateInt(first, second, '*');
     }
     return toString(toDoubleNumber(first) * toDoubleNumber(second));
 #endif
@@ -1186,10 +1295,7 @@ std::string MathLib::mod(const std::string &first, const std::string &second)
     return (value(first) % value(second)).str();
 #else
     if (MathLib::isInt(first) && MathLib::isInt(second)) {
-        const bigint b = toLongNumber(second);
-        if (b == 0)
-            throw InternalError(nullptr, "Internal Error: Division by zero");
-        return toString(toLongNumber(first) % b) + intsuffix(first, second);
+        return calculateInt(first, second, '%');
     }
     return toString(std::fmod(toDoubleNumber(first),toDoubleNumber(second)));
 #endif
@@ -70,6 +70,51 @@ public:
     typedef unsigned long long biguint;
     static const int bigint_bits;
 
+    /**
+     * @brief Parsed numeric literal. A number token is parsed into this once,
+     * see Token::number(). The integer calculations give the same results as
+     * the functions that take std::string operands.
+     */
+    class number {
+    public:
+        /** Integer suffix, in the order of the suffix that a calculation result gets */
+        enum Suffix { NONE, U, L, UL, LL, ULL };
+
+        number() : intValue(0), doubleValue(0.0), suffix(NONE), floatValue(false) {}
+
+        /**
+         * Parse a numeric literal
+         * @param str the literal
+         * @param result the parsed number
+         * @return false if str is no valid integer or float literal
+         */
+        static bool parse(const std::string &str, number *result);
+
+        /** Integer calculation, throws InternalError like MathLib::calculate() */
+        static number calculate(const number &first, const number &second, char action);
+
+        /** The integer as a literal with its suffix */
+        std::string str() const;
+
+        bool isInt() const {
+            return !floatValue;
+        }
+        bool isFloat() const {
+            return floatValue;
+        }
+
+        /** value like MathLib::toLongNumber() */
+        bigint intValue;
+
+        /** value like MathLib::toDoubleNumber(), only set for floats */
+        double doubleValue;
+
+        Suffix suffix;
+
+    private:
+        bool floatValue;
+    };
+
     static bigint toLongNumber(const std::string & str);
     static biguint toULongNumber(const std::string & str);
 
@@ -154,6 +199,7 @@ MathLib::value operator<<(const MathLib::value &v1, const MathLib::value &v2);
 MathLib::value operator>>(const MathLib::value &v1, const MathLib::value &v2);
 
 template<> CPPCHECKLIB std::string MathLib::toString(double value); // Declare specialization to avoid linker problems
+template<> CPPCHECKLIB std::string MathLib::toString(MathLib::bigint value);
 
 /// @}
 //---------------------------------------------------------------------------
@@ -27,6 +27,7 @@
 #include "suppressions.h"
 
 #include <algorithm>
+#include <cctype>
 #include <cstdint>
 #include <cstring>
 #include <utility>
@@ -165,6 +166,31 @@ void Preprocessor::setDirectives(const simplecpp::TokenList &tokens)
     }
 }
 
+std::list<std::pair<std::string, std::string> > Preprocessor::getIncludes(const simplecpp::TokenList &tokens) const
+{
+    std::list<std::pair<std::string, std::string> > ret;
+
+    std::vector<const simplecpp::TokenList *> list;
+    list.reserve(1U + tokenlists.size());
+    list.push_back(&tokens);
+    for (std::map<std::string, simplecpp::TokenList *>::const_iterator it = tokenlists.begin(); it != tokenlists.end(); ++it) {
+        list.push_back(it->second);
+    }
+
+    for (const simplecpp::TokenList *tokenList : list) {
+        for (const simplecpp::Token *tok = tokenList->cfront(); tok; tok = tok->next) {
+            if ((tok->op != '#') || (tok->previous && tok->previous->location.line == tok->location.line))
+                continue;
+            const simplecpp::Token *header = tok->next ? tok->next->next : nullptr;
+            if (!header || tok->next->str() != "include" || header->location.line != tok->location.line)
+                continue;
+            if (header->str()[0] == '\"' || header->str()[0] == '<')
+                ret.emplace_back(tok->location.file(), header->str());
+        }
+    }
+    return ret;
+}
+
 static bool sameline(const simplecpp::Token *tok1, const simplecpp::Token *tok2)
 {
     return tok1 && tok2 && tok1->location.sameline(tok2->location);
@@ -520,7 +546,7 @@ static void splitcfg(const std::string &cfg, std::list<std::string> &defines, co
     }
 }
 
-static simplecpp::DUI createDUI(const Settings &_settings, const std::string &cfg, const std::string &filename)
+static simplecpp::DUI createDUI(const Settings &_settings, const std::string &cfg, const std::string &filename, const std::vector<const std::string *> &libraryDefines)
 {
     simplecpp::DUI dui;
 
@@ -528,10 +554,10 @@ static simplecpp::DUI createDUI(const Settings &_settings, const std::string &cf
     if (!cfg.empty())
         splitcfg(cfg, dui.defines, emptyString);
 
-    for (std::vector<std::string>::const_iterator it = _settings.library.defines.begin(); it != _settings.library.defines.end(); ++it) {
-        if (it->compare(0,8,"#define ")!=0)
+    for (std::vector<const std::string *>::const_iterator it = libraryDefines.begin(); it != libraryDefines.end(); ++it) {
+        if ((*it)->compare(0,8,"#define ")!=0)
             continue;
-        std::string s = it->substr(8);
+        std::string s = (*it)->substr(8);
         const std::string::size_type pos = s.find_first_of(" (");
         if (pos == std::string::npos) {
             dui.defines.push_back(s);
@@ -573,9 +599,68 @@ static bool hasErrors(const simplecpp::OutputList &outputList)
 }
 
 
+/**
+ * Add the names of library defines that the code uses. Returns false if
+ * the used names are not known because the code pastes tokens together
+ * or includes a header with a macro, then all library defines are needed.
+ */
+static bool addLibraryDefineNames(const Library &library, const simplecpp::TokenList &tokens, std::set<std::string> &names)
+{
+    for (const simplecpp::Token *tok = tokens.cfront(); tok; tok = tok->next) {
+        if (tok->name) {
+            if (library.isDefine(tok->str()))
+                names.insert(tok->str());
+        } else if (tok->op == '#' && tok->next) {
+            if (tok->next->op == '#' && sameline(tok, tok->next))
+                return false;
+            if (tok->next->str() == "include" && tok->next->next && tok->next->next->name && sameline(tok, tok->next->next))
+                return false;
+        }
+    }
+    return true;
+}
+
+/** Add the names of library defines that are used in -D or configuration defines */
+static void addLibraryDefineNames(const Library &library, const std::string &defines, std::set<std::string> &names)
+{
+    for (std::string::size_type pos = 0; pos < defines.size();) {
+        if (!std::isalpha(static_cast<unsigned char>(defines[pos])) && defines[pos] != '_') {
+            ++pos;
+            continue;
+        }
+        const std::string::size_type start = pos;
+        while (pos < defines.size() && (std::isalnum(static_cast<unsigned char>(defines[pos])) || defines[pos] == '_'))
+            ++pos;
+        const std::string name = defines.substr(start, pos - start);
+        if (library.isDefine(name))
+            names.insert(name);
+    }
+}
+
+std::vector<const std::string *> Preprocessor::getLibraryDefines(const simplecpp::TokenList &tokens1, const std::string &cfg) const
+{
+    const Library &library = _settings.library;
+    std::set<std::string> names;
+    bool known = addLibraryDefineNames(library, tokens1, names);
+    for (std::map<std::string, simplecpp::TokenList *>::const_iterator it = tokenlists.begin(); known && it != tokenlists.end(); ++it) {
+        if (it->second)
+            known = addLibraryDefineNames(library, *it->second, names);
+    }
+    if (!known) {
+        std::vector<const std::string *> ret;
+        for (std::vector<std::string>::const_iterator it = library.defines.begin(); it != library.defines.end(); ++it)
+            ret.push_back(&*it);
+        return ret;
+    }
+    addLibraryDefineNames(library, _settings.userDefines, names);
+    addLibraryDefineNames(library, cfg, names);
+    return library.getDefines(names);
+}
+
 void Preprocessor::loadFiles(const simplecpp::TokenList &rawtokens, std::vector<std::string> &files)
 {
-    const simplecpp::DUI dui = createDUI(_settings, emptyString, files[0]);
+    // loading the files does not use any defines
+    const simplecpp::DUI dui = createDUI(_settings, emptyString, files[0], std::vector<const std::string *>());
 
     tokenlists = simplecpp::load(rawtokens, files, dui, nullptr);
 }
@@ -610,7 +695,7 @@ void Preprocessor::setPlatformInfo(simplecpp::TokenList *tokens) const
 
 simplecpp::TokenList Preprocessor::preprocess(const simplecpp::TokenList &tokens1, const std::string &cfg, std::vector<std::string> &files, bool throwError)
 {
-    const simplecpp::DUI dui = createDUI(_settings, cfg, files[0]);
+    const simplecpp::DUI dui = createDUI(_settings, cfg, files[0], getLibraryDefines(tokens1, cfg));
 
     simplecpp::OutputList outputList;
     std::list<simplecpp::MacroUsage> macroUsage;
@@ -29,6 +29,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 class ErrorLogger;
@@ -91,6 +92,12 @@ public:
 
     void setDirectives(const simplecpp::TokenList &tokens);
 
+    /**
+     * Get the include directives of the file and the loaded headers
+     * @return the including file and the header name with its quotes or angle brackets
+     */
+    std::list<std::pair<std::string, std::string> > getIncludes(const simplecpp::TokenList &tokens) const;
+
     /** list of all directives met while preprocessing file */
     const std::list<Directive> &getDirectives() const {
         return directives;
@@ -203,6 +210,9 @@ public:
     void reportOutput(const simplecpp::OutputList &outputList, bool showerror);
 
 private:
+    /** Get the library defines that are needed to preprocess the code with the given configuration */
+    std::vector<const std::string *> getLibraryDefines(const simplecpp::TokenList &tokens1, const std::string &cfg) const;
+
     void missingInclude(const std::string &filename, unsigned int linenr, const std::string &header, HeaderTypes headerType);
     void error(const std::string &filename, unsigned int linenr, const std::string &msg);
 
@@ -40,6 +40,7 @@ Settings::Settings()
       xml(false), xml_version(2),
       jobs(1),
       loadAverage(0),
+      checkThreads(1),
       exitCode(0),
       showtime(SHOWTIME_NONE),
       preprocessOnly(false),
@@ -31,10 +31,12 @@
 #include "timer.h"
 
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
+class FunctionSummaries;
 namespace ValueFlow {
     class Value;
 }
@@ -152,6 +154,10 @@ public:
     /** @brief Load average value */
     unsigned int loadAverage;
 
+    /** @brief How many threads run the checks of one translation unit
+        at the same time. Default is 1. (--check-threads=N) */
+    unsigned int checkThreads;
+
     /** @brief If errors are found, this value is returned from main().
         Default value is 0. */
     int exitCode;
@@ -247,6 +253,9 @@ public:
     /** Library (--library) */
     Library library;
 
+    /** Summaries of the functions of other TUs, loaded from the build dir */
+    std::shared_ptr<const FunctionSummaries> functionSummaries;
+
     /** Rule */
     class CPPCHECKLIB Rule {
     public:
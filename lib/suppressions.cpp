@@ -32,6 +32,13 @@
 
 class ErrorLogger;
 
+/** matchglob() does not distinguish '/' and '\\' */
+static std::string normalizeSeparators(std::string fileName)
+{
+    std::replace(fileName.begin(), fileName.end(), '\\', '/');
+    return fileName;
+}
+
 static bool isValidGlobPattern(const std::string &pattern)
 {
     for (std::string::const_iterator i = pattern.begin(); i != pattern.end(); ++i) {
@@ -169,8 +176,19 @@ std::string Suppressions::addSuppression(const Suppressions::Suppression &suppre
     if (!isValidGlobPattern(suppression.fileName))
         return "Failed to add suppression. Invalid glob pattern '" + suppression.fileName + "'.";
 
+    const std::size_t index = _suppressions.size();
     _suppressions.push_back(suppression);
 
+    if (suppression.errorId != "*")
+        _errorIdIndex[suppression.errorId].push_back(index);
+    else if (suppression.isLocal())
+        _fileNameIndex[normalizeSeparators(suppression.fileName)].push_back(index);
+    else
+        _wildcardIndex.push_back(index);
+
+    if (suppression.isLocal())
+        _localIndex[suppression.fileName].push_back(index);
+
     return "";
 }
 
@@ -264,32 +282,51 @@ std::string Suppressions::Suppression::getText() const
     return ret;
 }
 
-bool Suppressions::isSuppressed(const Suppressions::ErrorMessage &errmsg)
+bool Suppressions::match(const Suppressions::ErrorMessage &errmsg, bool localOnly)
 {
-    const bool unmatchedSuppression(errmsg.errorId == "unmatchedSuppression");
-    for (std::list<Suppression>::iterator it = _suppressions.begin(); it != _suppressions.end(); ++it) {
-        Suppression &s = *it;
-        if (unmatchedSuppression && s.errorId != errmsg.errorId)
+    // Candidate suppressions, the first one that matches is used
+    const std::vector<std::size_t> *candidates[3] = {nullptr, nullptr, nullptr};
+
+    const std::map<std::string, std::vector<std::size_t> >::const_iterator byErrorId = _errorIdIndex.find(errmsg.errorId);
+    if (byErrorId != _errorIdIndex.end())
+        candidates[0] = &byErrorId->second;
+
+    // unmatchedSuppression can only be suppressed explicitly
+    if (errmsg.errorId != "unmatchedSuppression") {
+        const std::map<std::string, std::vector<std::size_t> >::const_iterator byFileName = _fileNameIndex.find(normalizeSeparators(errmsg.getFileName()));
+        if (byFileName != _fileNameIndex.end())
+            candidates[1] = &byFileName->second;
+        if (!localOnly)
+            candidates[2] = &_wildcardIndex;
+    }
+
+    std::size_t pos[3] = {0, 0, 0};
+    for (;;) {
+        int next = -1;
+        for (int i = 0; i < 3; ++i) {
+            if (candidates[i] && pos[i] < candidates[i]->size() &&
+                (next < 0 || (*candidates[i])[pos[i]] < (*candidates[next])[pos[next]]))
+                next = i;
+        }
+        if (next < 0)
+            return false;
+
+        Suppression &s = _suppressions[(*candidates[next])[pos[next]++]];
+        if (localOnly && !s.isLocal())
             continue;
         if (s.isMatch(errmsg))
             return true;
     }
-    return false;
+}
+
+bool Suppressions::isSuppressed(const Suppressions::ErrorMessage &errmsg)
+{
+    return match(errmsg, false);
 }
 
 bool Suppressions::isSuppressedLocal(const Suppressions::ErrorMessage &errmsg)
 {
-    const bool unmatchedSuppression(errmsg.errorId == "unmatchedSuppression");
-    for (std::list<Suppression>::iterator it = _suppressions.begin(); it != _suppressions.end(); ++it) {
-        Suppression &s = *it;
-        if (!s.isLocal())
-            continue;
-        if (unmatchedSuppression && s.errorId != errmsg.errorId)
-            continue;
-        if (s.isMatch(errmsg))
-            return true;
-    }
-    return false;
+    return match(errmsg, true);
 }
 
 void Suppressions::dump(std::ostream & out)
@@ -314,14 +351,15 @@ void Suppressions::dump(std::ostream & out)
 std::list<Suppressions::Suppression> Suppressions::getUnmatchedLocalSuppressions(const std::string &file, const bool unusedFunctionChecking) const
 {
     std::list<Suppression> result;
-    for (std::list<Suppression>::const_iterator it = _suppressions.begin(); it != _suppressions.end(); ++it) {
-        const Suppression &s = *it;
+    const std::map<std::string, std::vector<std::size_t> >::const_iterator local = _localIndex.find(file);
+    if (file.empty() || local == _localIndex.end())
+        return result;
+    for (std::vector<std::size_t>::const_iterator it = local->second.begin(); it != local->second.end(); ++it) {
+        const Suppression &s = _suppressions[*it];
         if (s.matched)
             continue;
         if (!unusedFunctionChecking && s.errorId == "unusedFunction")
             continue;
-        if (file.empty() || !s.isLocal() || s.fileName != file)
-            continue;
         result.push_back(s);
     }
     return result;
@@ -330,7 +368,7 @@ std::list<Suppressions::Suppression> Suppressions::getUnmatchedLocalSuppressions
 std::list<Suppressions::Suppression> Suppressions::getUnmatchedGlobalSuppressions(const bool unusedFunctionChecking) const
 {
     std::list<Suppression> result;
-    for (std::list<Suppression>::const_iterator it = _suppressions.begin(); it != _suppressions.end(); ++it) {
+    for (std::vector<Suppression>::const_iterator it = _suppressions.begin(); it != _suppressions.end(); ++it) {
         const Suppression &s = *it;
         if (s.matched)
             continue;
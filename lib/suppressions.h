@@ -22,10 +22,13 @@
 
 #include "config.h"
 
+#include <cstddef>
 #include <istream>
 #include <list>
+#include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 /// @addtogroup Core
 /// @{
@@ -166,8 +169,31 @@ public:
 
     static bool matchglob(const std::string &pattern, const std::string &name);
 private:
+    /**
+     * @brief Find the first suppression that matches the error message and mark it as matched.
+     * @param errmsg error message
+     * @param localOnly only use local suppressions
+     * @return true if a suppression matched
+     */
+    bool match(const ErrorMessage &errmsg, bool localOnly);
+
     /** @brief List of error which the user doesn't want to see. */
-    std::list<Suppression> _suppressions;
+    std::vector<Suppression> _suppressions;
+
+    /**
+     * @brief Suppressions with an exact errorId.
+     * Each suppression is in one of _errorIdIndex, _fileNameIndex and
+     * _wildcardIndex so only suppressions that can match are tried. The
+     * indexes into _suppressions are sorted.
+     */
+    std::map<std::string, std::vector<std::size_t> > _errorIdIndex;
+    /** @brief Suppressions with errorId '*' and an exact file name, '\\' is replaced with '/' in the key */
+    std::map<std::string, std::vector<std::size_t> > _fileNameIndex;
+    /** @brief Other suppressions */
+    std::vector<std::size_t> _wildcardIndex;
+
+    /** @brief Local suppressions for each file */
+    std::map<std::string, std::vector<std::size_t> > _localIndex;
 };
 
 /// @}
@@ -33,6 +33,7 @@
 #include <climits>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 //---------------------------------------------------------------------------
 
 SymbolDatabase::SymbolDatabase(const Tokenizer *tokenizer, const Settings *settings, ErrorLogger *errorLogger)
@@ -5230,8 +5231,9 @@ void SymbolDatabase::setValueTypeInTokenList()
         tok->setValueType(nullptr);
 
     for (Token *tok = tokens; tok; tok = tok->next()) {
-        if (tok->isNumber()) {
-            if (MathLib::isFloat(tok->str())) {
+        MathLib::number number;
+        if (tok->number(&number)) {
+            if (number.isFloat()) {
                 ValueType::Type type = ValueType::Type::DOUBLE;
                 const char suffix = tok->str()[tok->str().size() - 1];
                 if (suffix == 'f' || suffix == 'F')
@@ -5239,11 +5241,11 @@ void SymbolDatabase::setValueTypeInTokenList()
                 else if (suffix == 'L' || suffix == 'l')
                     type = ValueType::Type::LONGDOUBLE;
                 setValueType(tok, ValueType(ValueType::Sign::UNKNOWN_SIGN, type, 0U));
-            } else if (MathLib::isInt(tok->str())) {
+            } else {
                 const bool unsignedSuffix = (tok->str().find_last_of("uU") != std::string::npos);
                 ValueType::Sign sign = unsignedSuffix ? ValueType::Sign::UNSIGNED : ValueType::Sign::SIGNED;
                 ValueType::Type type;
-                const MathLib::bigint value = MathLib::toLongNumber(tok->str());
+                const MathLib::bigint value = number.intValue;
                 if (_settings->platformType == cppcheck::Platform::Unspecified)
                     type = ValueType::Type::INT;
                 else if (_settings->isIntValue(unsignedSuffix ? (value >> 1) : value))
@@ -5647,3 +5649,342 @@ std::string ValueType::str() const
     }
     return ret.empty() ? ret : ret.substr(1);
 }
+
+ControlFlowGraph::ControlFlowGraph(const Scope *scope)
+    : _scope(scope), _unknownFlow(false)
+{
+    newBlock();
+    newBlock();
+    const std::size_t start = newBlock();
+    addEdge(Entry, start);
+    if (!scope || !scope->bodyStart)
+        return;
+    addEdge(compound(scope->bodyStart->next(), scope->bodyEnd, start), Exit);
+
+    for (std::size_t i = 0; i < _gotos.size(); ++i) {
+        const std::map<std::string, std::size_t>::const_iterator label = _labels.find(_gotos[i].second);
+        if (label != _labels.end())
+            addEdge(_gotos[i].first, label->second);
+        else
+            _unknownFlow = true;
+    }
+}
+
+std::size_t ControlFlowGraph::newBlock(const Token *start, const Token *end)
+{
+    _blocks.push_back(Block());
+    _blocks.back().start = start;
+    _blocks.back().end = end;
+    return _blocks.size() - 1U;
+}
+
+void ControlFlowGraph::addEdge(std::size_t from, std::size_t to)
+{
+    std::vector<std::size_t> &successors = _blocks[from].successors;
+    if (std::find(successors.begin(), successors.end(), to) != successors.end())
+        return;
+    successors.push_back(to);
+    _blocks[to].predecessors.push_back(from);
+}
+
+std::size_t ControlFlowGraph::append(std::size_t block, const Token *start, const Token *end)
+{
+    Block &b = _blocks[block];
+    if (!b.start) {
+        b.start = start;
+        b.end = end;
+        return block;
+    }
+
+    // Extend the block if only braces are skipped
+    const Token *tok = b.end;
+    while (tok != start && Token::Match(tok, "{|}"))
+        tok = tok->next();
+    if (tok == start) {
+        b.end = end;
+        return block;
+    }
+
+    const std::size_t next = newBlock(start, end);
+    addEdge(block, next);
+    return next;
+}
+
+std::size_t ControlFlowGraph::compound(const Token *start, const Token *end, std::size_t block)
+{
+    const Token *tok = start;
+    while (tok && tok != end)
+        block = statement(tok, block);
+    return block;
+}
+
+std::size_t ControlFlowGraph::statement(const Token *&tok, std::size_t block)
+{
+    if (!tok) {
+        _unknownFlow = true;
+        return block;
+    }
+
+    if (tok->str() == ";") {
+        tok = tok->next();
+        return block;
+    }
+
+    if (tok->str() == "{") {
+        const Token *end = tok->link();
+        block = compound(tok->next(), end, block);
+        tok = end->next();
+        return block;
+    }
+
+    if (Token::Match(tok, "if|while|switch|for (") && tok->next()->link()) {
+        const Token *endPar = tok->next()->link();
+        const std::string type = tok->str();
+        tok = endPar->next();
+        if (!tok) {
+            _unknownFlow = true;
+            return block;
+        }
+
+        if (type == "if") {
+            const std::size_t condition = newBlock(endPar->link()->next(), endPar);
+            addEdge(block, condition);
+            const std::size_t thenStart = newBlock();
+            addEdge(condition, thenStart);
+            const std::size_t thenEnd = statement(tok, thenStart);
+            const std::size_t join = newBlock();
+            addEdge(thenEnd, join);
+            if (tok && tok->str() == "else") {
+                tok = tok->next();
+                const std::size_t elseStart = newBlock();
+                addEdge(condition, elseStart);
+                addEdge(statement(tok, elseStart), join);
+            } else {
+                addEdge(condition, join);
+            }
+            return join;
+        }
+
+        if (type == "while") {
+            const std::size_t condition = newBlock(endPar->link()->next(), endPar);
+            addEdge(block, condition);
+            const std::size_t body = newBlock();
+            const std::size_t after = newBlock();
+            addEdge(condition, body);
+            addEdge(condition, after);
+            const JumpTargets targets = { after, condition, 0, false };
+            _jumpTargets.push_back(targets);
+            addEdge(statement(tok, body), condition);
+            _jumpTargets.pop_back();
+            return after;
+        }
+
+        if (type == "switch") {
+            const std::size_t condition = newBlock(endPar->link()->next(), endPar);
+            addEdge(block, condition);
+            const std::size_t after = newBlock();
+            const std::size_t continueTarget = _jumpTargets.empty() ? after : _jumpTargets.back().continueTarget;
+            const JumpTargets targets = { after, continueTarget, condition, false };
+            _jumpTargets.push_back(targets);
+            // code before the first case label is not reachable
+            addEdge(statement(tok, newBlock()), after);
+            if (!_jumpTargets.back().hasDefault)
+                addEdge(condition, after);
+            _jumpTargets.pop_back();
+            return after;
+        }
+
+        // for loop
+        const Token *semicolon1 = nullptr;
+        const Token *semicolon2 = nullptr;
+        for (const Token *tok2 = endPar->link()->next(); tok2 != endPar; tok2 = tok2->next()) {
+            if (tok2->link() && Token::Match(tok2, "(|[|{"))
+                tok2 = tok2->link();
+            else if (tok2->str() == ";") {
+                if (!semicolon1)
+                    semicolon1 = tok2;
+                else if (!semicolon2)
+                    semicolon2 = tok2;
+            }
+        }
+
+        std::size_t condition, continueTarget;
+        if (semicolon1 && semicolon2) {
+            if (semicolon1 != endPar->link()->next())
+                block = append(block, endPar->link()->next(), semicolon1);
+            condition = newBlock();
+            if (semicolon2 != semicolon1->next()) {
+                _blocks[condition].start = semicolon1->next();
+                _blocks[condition].end = semicolon2;
+            }
+            continueTarget = (semicolon2->next() != endPar) ? newBlock(semicolon2->next(), endPar) : condition;
+            if (continueTarget != condition)
+                addEdge(continueTarget, condition);
+        } else {
+            // range based for loop
+            condition = newBlock(endPar->link()->next(), endPar);
+            continueTarget = condition;
+        }
+        addEdge(block, condition);
+        const std::size_t body = newBlock();
+        const std::size_t after = newBlock();
+        addEdge(condition, body);
+        if (_blocks[condition].start)
+            addEdge(condition, after);
+        const JumpTargets targets = { after, continueTarget, 0, false };
+        _jumpTargets.push_back(targets);
+        addEdge(statement(tok, body), continueTarget);
+        _jumpTargets.pop_back();
+        return after;
+    }
+
+    if (tok->str() == "do") {
+        tok = tok->next();
+        const std::size_t body = newBlock();
+        addEdge(block, body);
+        const std::size_t condition = newBlock();
+        const std::size_t after = newBlock();
+        const JumpTargets targets = { after, condition, 0, false };
+        _jumpTargets.push_back(targets);
+        const std::size_t bodyEnd = tok ? statement(tok, body) : body;
+        _jumpTargets.pop_back();
+        addEdge(bodyEnd, condition);
+        if (!Token::simpleMatch(tok, "while (") || !tok->next()->link()) {
+            _unknownFlow = true;
+            return after;
+        }
+        _blocks[condition].start = tok->tokAt(2);
+        _blocks[condition].end = tok->next()->link();
+        addEdge(condition, body);
+        addEdge(condition, after);
+        tok = tok->next()->link()->next();
+        if (tok && tok->str() == ";")
+            tok = tok->next();
+        return after;
+    }
+
+    if (Token::Match(tok, "case|default")) {
+        const Token *colon = tok;
+        while (colon && colon->str() != ":") {
+            if (colon->link() && Token::Match(colon, "(|["))
+                colon = colon->link();
+            colon = colon->next();
+        }
+        std::size_t label = newBlock();
+        addEdge(block, label);
+        if (_jumpTargets.empty() || _jumpTargets.back().switchCondition == 0) {
+            _unknownFlow = true;
+        } else {
+            addEdge(_jumpTargets.back().switchCondition, label);
+            if (tok->str() == "default")
+                _jumpTargets.back().hasDefault = true;
+        }
+        tok = colon ? colon->next() : nullptr;
+        return label;
+    }
+
+    if (Token::Match(tok, "%name% :") && !Token::Match(tok, "public|protected|private")) {
+        const std::size_t label = newBlock();
+        addEdge(block, label);
+        _labels[tok->str()] = label;
+        tok = tok->tokAt(2);
+        return label;
+    }
+
+    if (Token::Match(tok, "break|continue ;")) {
+        if (_jumpTargets.empty())
+            _unknownFlow = true;
+        else
+            addEdge(block, (tok->str() == "break") ? _jumpTargets.back().breakTarget : _jumpTargets.back().continueTarget);
+        tok = tok->tokAt(2);
+        return newBlock();
+    }
+
+    if (Token::Match(tok, "goto %name% ;")) {
+        _gotos.push_back(std::make_pair(block, tok->strAt(1)));
+        tok = tok->tokAt(3);
+        return newBlock();
+    }
+
+    if (Token::simpleMatch(tok, "try {")) {
+        const std::size_t firstBlock = _blocks.size();
+        const std::size_t tryStart = newBlock();
+        addEdge(block, tryStart);
+        tok = tok->next();
+        const std::size_t tryEnd = statement(tok, tryStart);
+        const std::size_t lastBlock = _blocks.size();
+        const std::size_t after = newBlock();
+        addEdge(tryEnd, after);
+        while (Token::simpleMatch(tok, "catch (") && Token::simpleMatch(tok->linkAt(1), ") {")) {
+            // An exception can be thrown anywhere in the try block, also
+            // before the first statement of a block is executed. The state
+            // at the start of a try block is the state after the block
+            // before the try or after another try block.
+            const std::size_t handler = newBlock();
+            addEdge(block, handler);
+            for (std::size_t i = firstBlock; i < lastBlock; ++i)
+                addEdge(i, handler);
+            tok = tok->linkAt(1)->next();
+            addEdge(statement(tok, handler), after);
+        }
+        return after;
+    }
+
+    // simple statement
+    const Token *end = tok;
+    while (end && end->str() != ";") {
+        if (end->link() && Token::Match(end, "(|[|{"))
+            end = end->link();
+        else if (end->str() == "}")
+            break;
+        end = end->next();
+    }
+    if (!end || end->str() != ";") {
+        _unknownFlow = true;
+        const Token *start = tok;
+        if (start == end) {
+            tok = tok->next();
+            return block;
+        }
+        tok = end;
+        return append(block, start, end);
+    }
+
+    const bool jump = Token::Match(tok, "return|throw");
+    block = append(block, tok, end->next());
+    tok = end->next();
+    if (!jump)
+        return block;
+    addEdge(block, Exit);
+    return newBlock();
+}
+
+std::string ControlFlowGraph::str() const
+{
+    std::ostringstream ostr;
+    for (std::size_t i = 0; i < _blocks.size(); ++i) {
+        const Block &b = _blocks[i];
+        ostr << i << ":";
+        for (const Token *tok = b.start; tok && tok != b.end; tok = tok->next())
+            ostr << " " << tok->str();
+        if (!b.successors.empty()) {
+            ostr << " ->";
+            for (std::size_t j = 0; j < b.successors.size(); ++j)
+                ostr << " " << b.successors[j];
+        }
+        ostr << "\n";
+    }
+    return ostr.str();
+}
+
+const ControlFlowGraph *SymbolDatabase::getControlFlowGraph(const Scope *scope) const
+{
+    if (!scope || !scope->isExecutable() || !scope->bodyStart)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(_controlFlowGraphsMutex);
+    std::map<const Scope *, ControlFlowGraph>::iterator it = _controlFlowGraphs.find(scope);
+    if (it == _controlFlowGraphs.end())
+        it = _controlFlowGraphs.insert(std::make_pair(scope, ControlFlowGraph(scope))).first;
+    return &it->second;
+}
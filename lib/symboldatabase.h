@@ -29,6 +29,7 @@
 #include <cstddef>
 #include <list>
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
 #include <utility>
@@ -1108,6 +1109,76 @@ public:
 };
 
 
+/**
+ * @brief Basic block control flow graph of an executable scope.
+ * A block is a range of tokens that is executed in sequence. The conditions
+ * of if/while/for/switch are blocks of their own, only such a block can have
+ * several successors. Blocks that are not reachable (code after return etc)
+ * have no predecessors.
+ */
+class CPPCHECKLIB ControlFlowGraph {
+public:
+    struct Block {
+        Block() : start(nullptr), end(nullptr) {}
+
+        /** first token in block, nullptr if the block is empty */
+        const Token *start;
+
+        /** token after the last token in block. The range can contain braces that shall be ignored. */
+        const Token *end;
+
+        std::vector<std::size_t> successors;
+        std::vector<std::size_t> predecessors;
+    };
+
+    /** indexes of the empty entry and exit blocks */
+    enum { Entry = 0, Exit = 1 };
+
+    explicit ControlFlowGraph(const Scope *scope);
+
+    const Scope *scope() const {
+        return _scope;
+    }
+
+    const std::vector<Block> &blocks() const {
+        return _blocks;
+    }
+
+    /**
+     * Is there flow that is not in the graph? For instance goto to an unknown label
+     * or case labels outside switch.
+     */
+    bool hasUnknownFlow() const {
+        return _unknownFlow;
+    }
+
+    /** blocks and edges, for debugging and testing */
+    std::string str() const;
+
+private:
+    /** targets of break and continue */
+    struct JumpTargets {
+        std::size_t breakTarget;
+        std::size_t continueTarget;
+        std::size_t switchCondition;
+        bool hasDefault;
+    };
+
+    std::size_t newBlock(const Token *start = nullptr, const Token *end = nullptr);
+    void addEdge(std::size_t from, std::size_t to);
+    std::size_t append(std::size_t block, const Token *start, const Token *end);
+    std::size_t compound(const Token *start, const Token *end, std::size_t block);
+    std::size_t statement(const Token *&tok, std::size_t block);
+
+    const Scope *_scope;
+    std::vector<Block> _blocks;
+    std::vector<JumpTargets> _jumpTargets;
+    std::map<std::string, std::size_t> _labels;
+    std::vector<std::pair<std::size_t, std::string> > _gotos;
+    bool _unknownFlow;
+};
+
+
 class CPPCHECKLIB SymbolDatabase {
     friend class TestSymbolDatabase;
 public:
@@ -1193,6 +1264,13 @@ public:
      */
     unsigned int sizeOfType(const Token *type) const;
 
+    /**
+     * @brief Get control flow graph of a executable scope. The graph is
+     * created the first time it is requested, later calls return the same graph.
+     * @return the graph, or nullptr if the scope is not executable
+     */
+    const ControlFlowGraph *getControlFlowGraph(const Scope *scope) const;
+
 private:
     friend class Scope;
     friend class Function;
@@ -1253,6 +1331,10 @@ private:
 
     /** "negative cache" list of tokens that we find are not enumeration values */
     mutable std::set<std::string> tokensThatAreNotEnumeratorValues;
+
+    /** control flow graphs created by getControlFlowGraph(). Checks can run in parallel so access is locked */
+    mutable std::map<const Scope *, ControlFlowGraph> _controlFlowGraphs;
+    mutable std::mutex _controlFlowGraphsMutex;
 };
 
 
@@ -1216,13 +1216,19 @@ bool TemplateSimplifier::simplifyNumericCalculations(Token *tok)
             tok->str(result ? "1" : "0");
         }
 
-        else if (Token::Match(tok->previous(), "- %num% - %num%"))
-            tok->str(MathLib::add(num1, num2));
-        else if (Token::Match(tok->previous(), "- %num% + %num%"))
-            tok->str(MathLib::subtract(num1, num2));
         else {
+            char action = op->str()[0];
+            if (Token::Match(tok->previous(), "- %num% - %num%"))
+                action = '+';
+            else if (Token::Match(tok->previous(), "- %num% + %num%"))
+                action = '-';
             try {
-                tok->str(MathLib::calculate(num1, num2, op->str()[0]));
+                // calculate integers without parsing and formatting the operands
+                MathLib::number n1, n2;
+                if (tok->number(&n1) && n1.isInt() && tok->tokAt(2)->number(&n2) && n2.isInt())
+                    tok->str(MathLib::number::calculate(n1, n2, action).str());
+                else
+                    tok->str(MathLib::calculate(num1, num2, action));
             } catch (InternalError &e) {
                 e.token = tok;
                 throw;
@@ -1378,13 +1384,14 @@ bool TemplateSimplifier::simplifyCalculations(Token *_tokens)
                 ret = true;
             }
 
+            MathLib::number n1, n2;
             if (Token::Match(tok, "%num% %comp% %num%") &&
-                MathLib::isInt(tok->str()) &&
-                MathLib::isInt(tok->strAt(2))) {
+                tok->number(&n1) && n1.isInt() &&
+                tok->tokAt(2)->number(&n2) && n2.isInt()) {
                 if (Token::Match(tok->previous(), "(|&&|%oror%") && Token::Match(tok->tokAt(3), ")|&&|%oror%|?")) {
-                    const MathLib::bigint op1(MathLib::toLongNumber(tok->str()));
+                    const MathLib::bigint op1(n1.intValue);
                     const std::string &cmp(tok->next()->str());
-                    const MathLib::bigint op2(MathLib::toLongNumber(tok->strAt(2)));
+                    const MathLib::bigint op2(n2.intValue);
 
                     std::string result;
 
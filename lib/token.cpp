@@ -46,10 +46,13 @@ Token::Token(TokensFrontBack *tokensFrontBack) :
     _fileIndex(0),
     _linenr(0),
     _col(0),
-    _progressValue(0),
     _tokType(eNone),
     _flags(0),
     _bits(0),
+    _progressValue(0),
+    _exprHash(0),
+    _libraryCall(0),
+    _number(0),
     _astOperand1(nullptr),
     _astOperand2(nullptr),
     _astParent(nullptr),
@@ -92,8 +95,10 @@ void Token::update_property_info()
                 tokType(eVariable);
             else if (_tokType != eVariable && _tokType != eFunction && _tokType != eType && _tokType != eKeyword)
                 tokType(eName);
-        } else if (std::isdigit((unsigned char)_str[0]) || (_str.length() > 1 && _str[0] == '-' && std::isdigit((unsigned char)_str[1])))
+        } else if (std::isdigit((unsigned char)_str[0]) || (_str.length() > 1 && _str[0] == '-' && std::isdigit((unsigned char)_str[1]))) {
             tokType(eNumber);
+            update_property_number();
+        }
         else if (_str.length() > 1 && _str[0] == '"' && endsWith(_str,'"'))
             tokType(eString);
         else if (_str.length() > 1 && _str[0] == '\'' && endsWith(_str,'\''))
@@ -131,10 +136,35 @@ void Token::update_property_info()
     } else {
         tokType(eNone);
     }
+    if (_tokType != eNumber)
+        _number = 0;
 
     update_property_isStandardType();
 }
 
+void Token::update_property_number()
+{
+    MathLib::number value;
+    if (!tokensFrontBack || !MathLib::number::parse(_str, &value))
+        _number = 0;
+    else if (_number)
+        tokensFrontBack->numbers[_number - 1] = value;
+    else {
+        tokensFrontBack->numbers.push_back(value);
+        _number = static_cast<unsigned int>(tokensFrontBack->numbers.size());
+    }
+}
+
+bool Token::number(MathLib::number *result) const
+{
+    if (_number) {
+        *result = tokensFrontBack->numbers[_number - 1];
+        return true;
+    }
+    // tokens that are not in a token list are parsed each time
+    return !tokensFrontBack && _tokType == eNumber && MathLib::number::parse(_str, result);
+}
+
 static const std::set<std::string> stdTypes = { "bool"
                                                 , "_Bool"
                                                 , "char"
@@ -261,6 +291,8 @@ void Token::swapWithNext()
         std::swap(_function, _next->_function);
         std::swap(_originalName, _next->_originalName);
         std::swap(_values, _next->_values);
+        std::swap(_libraryCall, _next->_libraryCall);
+        std::swap(_number, _next->_number);
         std::swap(valuetype, _next->valuetype);
         std::swap(_progressValue, _next->_progressValue);
     }
@@ -288,10 +320,19 @@ void Token::takeData(Token *fromToken)
     delete valuetype;
     valuetype = fromToken->valuetype;
     fromToken->valuetype = nullptr;
+    _libraryCall = fromToken->_libraryCall;
+    fromToken->_libraryCall = 0;
+    _number = fromToken->_number;
+    fromToken->_number = 0;
     if (_link)
         _link->link(this);
 }
 
+LibraryCall *Token::libraryCall() const
+{
+    return _libraryCall ? &tokensFrontBack->libraryCalls[_libraryCall - 1] : nullptr;
+}
+
 void Token::deleteThis()
 {
     if (_next) { // Copy next to this and delete next
@@ -1653,7 +1694,7 @@ void Token::assignProgressValues(Token *tok)
         ++total_count;
     unsigned int count = 0;
     for (Token *tok2 = tok; tok2; tok2 = tok2->next())
-        tok2->_progressValue = count++ * 100 / total_count;
+        tok2->_progressValue = static_cast<unsigned char>(count++ * 100 / total_count);
 }
 
 void Token::setValueType(ValueType *vt)
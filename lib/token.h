@@ -33,6 +33,7 @@
 
 class Enumerator;
 class Function;
+struct LibraryCall;
 class Scope;
 class Settings;
 class Type;
@@ -45,6 +46,8 @@ class Variable;
 struct TokensFrontBack {
     Token *front;
     Token *back;
+    LibraryCall *libraryCalls; // see TokenList::createLibraryCalls()
+    std::vector<MathLib::number> numbers; // see Token::number()
 };
 
 /// @addtogroup Core
@@ -279,6 +282,13 @@ public:
     bool isNumber() const {
         return _tokType == eNumber;
     }
+    /**
+     * Get the parsed value of a number token. The token text is parsed
+     * once when it is set.
+     * @param result the parsed number
+     * @return false if this is no valid integer or float literal
+     */
+    bool number(MathLib::number *result) const;
     bool isEnumerator() const {
         return _tokType == eEnumerator;
     }
@@ -923,12 +933,6 @@ private:
     unsigned int _linenr;
     unsigned int _col;
 
-    /**
-     * A value from 0-100 that provides a rough idea about where in the token
-     * list this token is located.
-     */
-    unsigned int _progressValue;
-
     Token::Type _tokType;
 
     enum {
@@ -985,9 +989,27 @@ private:
     /** Update internal property cache about isStandardType() */
     void update_property_isStandardType();
 
+    /** Parse the number in TokensFrontBack::numbers */
+    void update_property_number();
+
     /** Bitfield bit count. */
     unsigned char _bits;
 
+    /**
+     * A value from 0-100 that provides a rough idea about where in the token
+     * list this token is located.
+     */
+    unsigned char _progressValue;
+
+    /** Structural hash of the AST expression */
+    unsigned int _exprHash;
+
+    /** Index + 1 of the function call in TokensFrontBack::libraryCalls, 0 if this is no call */
+    unsigned int _libraryCall;
+
+    /** Index + 1 of the parsed number in TokensFrontBack::numbers, 0 if this is no valid number */
+    unsigned int _number;
+
     // AST..
     Token *_astOperand1;
     Token *_astOperand2;
@@ -1023,6 +1045,18 @@ public:
         return ret;
     }
 
+    /**
+     * Structural hash of the expression that has this token as root.
+     * Expressions that isSameExpression() considers same have the same
+     * hash. 0 if it has not been calculated.
+     */
+    unsigned int exprHash() const {
+        return _exprHash;
+    }
+    void exprHash(unsigned int hash) {
+        _exprHash = hash;
+    }
+
     /**
      * Is current token a calculation? Only true for operands.
      * For '*' and '&' tokens it is looked up if this is a
@@ -1034,6 +1068,7 @@ public:
 
     void clearAst() {
         _astOperand1 = _astOperand2 = _astParent = nullptr;
+        _exprHash = 0;
     }
 
     void clearValueFlow() {
@@ -1041,6 +1076,15 @@ public:
         _values = nullptr;
     }
 
+    /**
+     * Library information of the function call, nullptr if it is not
+     * available. See TokenList::createLibraryCalls()
+     */
+    LibraryCall *libraryCall() const;
+    void libraryCall(unsigned int index) {
+        _libraryCall = index;
+    }
+
     std::string astString(const char *sep = "") const {
         std::string ret;
         if (_astOperand1)
@@ -1759,6 +1759,8 @@ bool Tokenizer::simplifyTokens1(const std::string &configuration)
     }
 
     _symbolDatabase->setValueTypeInTokenList();
+    list.createExprHashes();
+    list.createLibraryCalls();
     ValueFlow::setValues(&list, _symbolDatabase, _errorLogger, _settings);
 
     printDebugOutput(1);
@@ -3895,7 +3897,8 @@ bool Tokenizer::simplifyTokenList2()
     // clear the _functionList so it can't contain dead pointers
     deleteSymbolDatabase();
 
-    // Clear AST,ValueFlow. These will be created again at the end of this function.
+    // Clear AST,ValueFlow,library calls. These will be created again at the end of this function.
+    list.clearLibraryCalls();
     for (Token *tok = list.front(); tok; tok = tok->next()) {
         tok->clearAst();
         tok->clearValueFlow();
@@ -4024,6 +4027,8 @@ bool Tokenizer::simplifyTokenList2()
     // Create symbol database and then remove const keywords
     createSymbolDatabase();
     _symbolDatabase->setValueTypeInTokenList();
+    list.createExprHashes();
+    list.createLibraryCalls();
 
     ValueFlow::setValues(&list, _symbolDatabase, _errorLogger, _settings);
 
@@ -28,6 +28,7 @@
 #include <simplecpp.h>
 #include <cctype>
 #include <cstring>
+#include <functional>
 #include <set>
 #include <stack>
 
@@ -65,9 +66,11 @@ const std::string& TokenList::getSourceFilePath() const
 // Deallocate lists..
 void TokenList::deallocateTokens()
 {
+    clearLibraryCalls();
     deleteTokens(_tokensFrontBack.front);
     _tokensFrontBack.front = nullptr;
     _tokensFrontBack.back = nullptr;
+    _tokensFrontBack.numbers.clear();
     _files.clear();
 }
 
@@ -1202,6 +1205,68 @@ void TokenList::validateAst() const
     }
 }
 
+static unsigned int createExprHash(const Token *tok, bool cpp)
+{
+    if (!tok)
+        return 0x9e3779b9U;
+    if (tok->exprHash())
+        return tok->exprHash();
+
+    unsigned int hash;
+    if (cpp && tok->str() == "." && tok->astOperand1() && tok->astOperand1()->str() == "this") {
+        // 'this->x' is the same expression as 'x'
+        hash = createExprHash(tok->astOperand2(), cpp);
+    } else {
+        // 'a<b' is the same expression as 'b>a'
+        std::string str(tok->str());
+        if (str == ">" || str == ">=")
+            str[0] = '<';
+        hash = static_cast<unsigned int>(std::hash<std::string>()(str)) * 31U + tok->varId();
+
+        const unsigned int hash1 = createExprHash(tok->astOperand1(), cpp);
+        const unsigned int hash2 = createExprHash(tok->astOperand2(), cpp);
+        if (tok->astOperand1() && tok->astOperand2() && Token::Match(tok, "%or%|%oror%|+|*|&|&&|^|==|!=|<|<=|>|>="))
+            hash = (hash * 31U + (hash1 + hash2)) * 31U + (hash1 ^ hash2);
+        else
+            hash = (hash * 31U + hash1) * 31U + hash2;
+    }
+
+    if (hash == 0)
+        hash = 1;
+    const_cast<Token *>(tok)->exprHash(hash);
+    return hash;
+}
+
+void TokenList::createExprHashes()
+{
+    for (Token *tok = _tokensFrontBack.front; tok; tok = tok->next())
+        tok->exprHash(0);
+    for (Token *tok = _tokensFrontBack.front; tok; tok = tok->next())
+        createExprHash(tok, isCPP());
+}
+
+void TokenList::createLibraryCalls()
+{
+    clearLibraryCalls();
+    unsigned int count = 0;
+    for (Token *tok = _tokensFrontBack.front; tok; tok = tok->next()) {
+        if (Token::Match(tok, "%name% (") && !tok->isControlFlowKeyword())
+            tok->libraryCall(++count);
+    }
+    if (count > 0)
+        _tokensFrontBack.libraryCalls = new LibraryCall[count];
+}
+
+void TokenList::clearLibraryCalls()
+{
+    if (!_tokensFrontBack.libraryCalls)
+        return;
+    for (Token *tok = _tokensFrontBack.front; tok; tok = tok->next())
+        tok->libraryCall(0U);
+    delete[] _tokensFrontBack.libraryCalls;
+    _tokensFrontBack.libraryCalls = nullptr;
+}
+
 const std::string& TokenList::file(const Token *tok) const
 {
     return _files.at(tok->fileIndex());
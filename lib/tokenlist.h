@@ -159,6 +159,23 @@ public:
      */
     void validateAst() const;
 
+    /**
+     * Calculate Token::exprHash() for all tokens. Must be called again
+     * when the AST, the varids or the token strings are changed.
+     */
+    void createExprHashes();
+
+    /**
+     * Give all function calls a Token::libraryCall() where the Library
+     * remembers what it resolved for the call, so that later queries for
+     * the same call don't build the function name and look it up again.
+     * Must be called when the AST and symbol database are complete, and
+     * clearLibraryCalls() must be called before the tokens are changed
+     * again. The queries may run concurrently, this may not.
+     */
+    void createLibraryCalls();
+    void clearLibraryCalls();
+
     /**
      * Verify that the given token is an element of the tokenlist.
      * That method is implemented for debugging purposes.
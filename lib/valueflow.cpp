@@ -79,6 +79,7 @@
 
 #include "astutils.h"
 #include "errorlogger.h"
+#include "functionsummaries.h"
 #include "library.h"
 #include "mathlib.h"
 #include "platform.h"
@@ -727,15 +728,17 @@ static unsigned int getSizeOfType(const Token *typeTok, const Settings *settings
 // Handle various constants..
 static Token * valueFlowSetConstantValue(const Token *tok, const Settings *settings, bool cpp)
 {
-    if ((tok->isNumber() && MathLib::isInt(tok->str())) || (tok->tokType() == Token::eChar)) {
-        ValueFlow::Value value(MathLib::toLongNumber(tok->str()));
+    MathLib::number number;
+    const bool isNumber = tok->number(&number);
+    if ((isNumber && number.isInt()) || (tok->tokType() == Token::eChar)) {
+        ValueFlow::Value value(isNumber ? number.intValue : MathLib::toLongNumber(tok->str()));
         if (!tok->isTemplateArg())
             value.setKnown();
         setTokenValue(const_cast<Token *>(tok), value, settings);
-    } else if (tok->isNumber() && MathLib::isFloat(tok->str())) {
+    } else if (isNumber && number.isFloat()) {
         ValueFlow::Value value;
         value.valueType = ValueFlow::Value::FLOAT;
-        value.floatValue = MathLib::toDoubleNumber(tok->str());
+        value.floatValue = number.doubleValue;
         if (!tok->isTemplateArg())
             value.setKnown();
         setTokenValue(const_cast<Token *>(tok), value, settings);
@@ -3317,6 +3320,20 @@ static void valueFlowFunctionReturn(TokenList *tokenlist, ErrorLogger *errorLogg
         if (tok->str() != "(" || !tok->astOperand1() || !tok->astOperand1()->function())
             continue;
 
+        const Function * const function = tok->astOperand1()->function();
+
+        // Function that is defined in another TU..
+        if (!function->hasBody()) {
+            const Settings * const settings = tokenlist->getSettings();
+            const FunctionSummaries::Summary *summary = settings->functionSummaries ? settings->functionSummaries->find(function) : nullptr;
+            if (summary && summary->knownReturnValue) {
+                ValueFlow::Value v(summary->returnValue);
+                v.setKnown();
+                setTokenValue(tok, v, settings);
+            }
+            continue;
+        }
+
         // Arguments..
         std::vector<MathLib::bigint> parvalues;
         if (tok->astOperand2()) {
@@ -3336,7 +3353,6 @@ static void valueFlowFunctionReturn(TokenList *tokenlist, ErrorLogger *errorLogg
         }
 
         // Get scope and args of function
-        const Function * const function = tok->astOperand1()->function();
         const Scope * const functionScope = function->functionScope;
         if (!functionScope || !Token::simpleMatch(functionScope->bodyStart, "{ return")) {
             if (functionScope && tokenlist->getSettings()->debugwarnings && Token::findsimplematch(functionScope->bodyStart, "return", functionScope->bodyEnd))
@@ -0,0 +1,298 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2018 Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "analyzerinfo.h"
+#include "errorlogger.h"
+#include "functionsummaries.h"
+#include "testsuite.h"
+
+#include <tinyxml2.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <utime.h>
+#endif
+
+
+class TestAnalyzerInformation : public TestFixture {
+public:
+    TestAnalyzerInformation() : TestFixture("TestAnalyzerInformation") {
+    }
+
+private:
+
+    void run() override {
+        TEST_CASE(storeAppend);
+        TEST_CASE(storeTornRecord);
+        TEST_CASE(storeCorruptRecord);
+        TEST_CASE(storeCompact);
+#ifndef _WIN32
+        TEST_CASE(skipStaleFile);
+        TEST_CASE(skipStaleDirectory);
+        TEST_CASE(skipOtherIncludePaths);
+        TEST_CASE(staleFunctionSummaries);
+#endif
+    }
+
+    static std::string readFile(const std::string &filename) {
+        std::ifstream fin(filename, std::ios::in | std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+    }
+
+    static void writeFile(const std::string &filename, const std::string &data) {
+        std::ofstream fout(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+        fout << data;
+    }
+
+    static std::string read(const AnalyzerInfoStore &store, const std::string &sourcefile, unsigned long long *checksum = nullptr) {
+        unsigned long long c = 0;
+        std::string data;
+        if (!store.read(sourcefile, "", &c, &data))
+            return "not found";
+        if (checksum)
+            *checksum = c;
+        return data;
+    }
+
+    void storeAppend() const {
+        const std::string storeFile = AnalyzerInfoStore::getStoreFile(".");
+        std::remove(storeFile.c_str());
+        {
+            AnalyzerInfoStore store(".");
+            store.append("a.c", "", 1, "a1");
+            store.append("b.c", "", 2, "b1");
+            store.append("a.c", "", 3, "a2");
+            ASSERT_EQUALS("a2", read(store, "a.c"));
+        }
+
+        // The latest record of each TU is read from the file
+        AnalyzerInfoStore store(".");
+        unsigned long long checksum = 0;
+        ASSERT_EQUALS("a2", read(store, "a.c", &checksum));
+        ASSERT_EQUALS(3ULL, checksum);
+        ASSERT_EQUALS("b1", read(store, "b.c", &checksum));
+        ASSERT_EQUALS(2ULL, checksum);
+        ASSERT_EQUALS("not found", read(store, "c.c"));
+        std::vector<std::string> data;
+        store.readAll(&data);
+        ASSERT_EQUALS(2U, data.size());
+
+        std::remove(storeFile.c_str());
+    }
+
+    void storeTornRecord() const {
+        // A job that is killed while it writes a record leaves a part of it
+        const std::string storeFile = AnalyzerInfoStore::getStoreFile(".");
+        std::remove(storeFile.c_str());
+        {
+            AnalyzerInfoStore store(".");
+            store.append("a.c", "", 1, "a1");
+            store.append("b.c", "", 2, "b1");
+        }
+        const std::string data = readFile(storeFile);
+        writeFile(storeFile, data.substr(0, data.size() - 1U));
+
+        {
+            AnalyzerInfoStore store(".");
+            ASSERT_EQUALS("a1", read(store, "a.c"));
+            ASSERT_EQUALS("not found", read(store, "b.c"));
+            store.append("c.c", "", 3, "c1");
+        }
+
+        // A record that is appended after the torn record is not lost
+        AnalyzerInfoStore store(".");
+        ASSERT_EQUALS("a1", read(store, "a.c"));
+        ASSERT_EQUALS("c1", read(store, "c.c"));
+
+        std::remove(storeFile.c_str());
+    }
+
+    void storeCorruptRecord() const {
+        const std::string storeFile = AnalyzerInfoStore::getStoreFile(".");
+        std::remove(storeFile.c_str());
+        {
+            AnalyzerInfoStore store(".");
+            store.append("a.c", "", 1, "a1");
+        }
+        writeFile(storeFile, readFile(storeFile) + "XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX");
+
+        {
+            AnalyzerInfoStore store(".");
+            ASSERT_EQUALS("a1", read(store, "a.c"));
+            store.append("b.c", "", 2, "b1");
+        }
+
+        AnalyzerInfoStore store(".");
+        ASSERT_EQUALS("a1", read(store, "a.c"));
+        ASSERT_EQUALS("b1", read(store, "b.c"));
+
+        std::remove(storeFile.c_str());
+    }
+
+    void storeCompact() const {
+        const std::string storeFile = AnalyzerInfoStore::getStoreFile(".");
+        std::remove(storeFile.c_str());
+        {
+            AnalyzerInfoStore store(".");
+            store.append("a.c", "", 1, std::string(100, 'a'));
+            store.append("b.c", "", 2, std::string(100, 'b'));
+
+            // Nothing is replaced, the file is not rewritten
+            const std::string::size_type size = readFile(storeFile).size();
+            store.compact();
+            ASSERT_EQUALS(size, readFile(storeFile).size());
+
+            for (int i = 0; i < 3; ++i)
+                store.append("a.c", "", 3, std::string(100, 'c'));
+            store.compact();
+            ASSERT_EQUALS(size, readFile(storeFile).size());
+            ASSERT_EQUALS(std::string(100, 'c'), read(store, "a.c"));
+            store.append("c.c", "", 4, "c1");
+        }
+
+        AnalyzerInfoStore store(".");
+        unsigned long long checksum = 0;
+        ASSERT_EQUALS(std::string(100, 'c'), read(store, "a.c", &checksum));
+        ASSERT_EQUALS(3ULL, checksum);
+        ASSERT_EQUALS(std::string(100, 'b'), read(store, "b.c"));
+        ASSERT_EQUALS("c1", read(store, "c.c"));
+
+        std::remove(storeFile.c_str());
+    }
+
+#ifndef _WIN32
+    /** Set the modification time of a file or directory to a time long ago */
+    static void setOldTime(const std::string &path) {
+        struct utimbuf times;
+        times.actime = times.modtime = 1000000000;
+        utime(path.c_str(), &times);
+    }
+
+    /** Write the analyzer info of a TU that depends on its source file and the directory of it */
+    static void analyze(const std::string &buildDir, const std::string &sourcefile, const std::list<std::string> &includePaths, const std::string &summaries = std::string()) {
+        AnalyzerInformation analyzerInformation;
+        std::list<ErrorLogger::ErrorMessage> errors;
+        analyzerInformation.analyzeFile(buildDir, sourcefile, "", 0, nullptr, &errors);
+        analyzerInformation.setDependencies("test", std::vector<std::string>(1, sourcefile), std::list<std::pair<std::string, std::string> >(), includePaths);
+        const std::list<ErrorLogger::ErrorMessage::FileLocation> callstack(1, ErrorLogger::ErrorMessage::FileLocation(sourcefile, 1));
+        analyzerInformation.reportErr(ErrorLogger::ErrorMessage(callstack, sourcefile, Severity::error, "msg", "id", false), false);
+        analyzerInformation.setFunctionSummaries(summaries);
+        analyzerInformation.close();
+    }
+
+    static bool skip(const std::string &buildDir, const std::string &sourcefile, const std::list<std::string> &includePaths = std::list<std::string>()) {
+        std::list<ErrorLogger::ErrorMessage> errors;
+        const bool ret = AnalyzerInformation::skipUnchangedFile(buildDir, sourcefile, "", "test", includePaths, nullptr, &errors);
+        return ret && errors.size() == 1U && errors.front()._id == "id";
+    }
+
+    /** Create a directory with a source file, both are older than the analysis */
+    static void createSource(const std::string &dir, const std::string &sourcefile) {
+        mkdir(dir.c_str(), 0777);
+        mkdir((dir + "/build").c_str(), 0777);
+        writeFile(sourcefile, "int x;\n");
+        setOldTime(sourcefile);
+        setOldTime(dir);
+    }
+
+    static void removeSource(const std::string &dir, const std::string &sourcefile) {
+        std::remove(sourcefile.c_str());
+        std::remove(AnalyzerInfoStore::getStoreFile(dir + "/build").c_str());
+        std::remove((dir + "/build").c_str());
+        std::remove(dir.c_str());
+    }
+
+    void skipStaleFile() const {
+        const std::string dir("testskipstalefile");
+        const std::string sourcefile(dir + "/a.c");
+        createSource(dir, sourcefile);
+        analyze(dir + "/build", sourcefile, std::list<std::string>());
+        ASSERT_EQUALS(true, skip(dir + "/build", sourcefile));
+
+        // A file with a new time and the same size is checked by its content
+        writeFile(sourcefile, "int x;\n");
+        ASSERT_EQUALS(true, skip(dir + "/build", sourcefile));
+        writeFile(sourcefile, "int y;\n");
+        ASSERT_EQUALS(false, skip(dir + "/build", sourcefile));
+
+        writeFile(sourcefile, "int xy;\n");
+        setOldTime(sourcefile);
+        ASSERT_EQUALS(false, skip(dir + "/build", sourcefile));
+
+        removeSource(dir, sourcefile);
+    }
+
+    void skipStaleDirectory() const {
+        // A new file in a directory where headers are looked up might be
+        // included instead of the old header
+        const std::string dir("testskipstaledir");
+        const std::string sourcefile(dir + "/a.c");
+        createSource(dir, sourcefile);
+        analyze(dir + "/build", sourcefile, std::list<std::string>());
+        ASSERT_EQUALS(true, skip(dir + "/build", sourcefile));
+
+        const std::string header(dir + "/a.h");
+        writeFile(header, "");
+        ASSERT_EQUALS(false, skip(dir + "/build", sourcefile));
+
+        std::remove(header.c_str());
+        removeSource(dir, sourcefile);
+    }
+
+    void skipOtherIncludePaths() const {
+        const std::string dir("testskipincludepaths");
+        const std::string sourcefile(dir + "/a.c");
+        createSource(dir, sourcefile);
+        analyze(dir + "/build", sourcefile, std::list<std::string>(1, dir));
+        ASSERT_EQUALS(true, skip(dir + "/build", sourcefile, std::list<std::string>(1, dir)));
+        ASSERT_EQUALS(false, skip(dir + "/build", sourcefile));
+
+        removeSource(dir, sourcefile);
+    }
+
+    void staleFunctionSummaries() const {
+        // The summaries of a TU are not used if the TU is modified
+        const std::string dir("teststalesummaries");
+        const std::string sourcefile(dir + "/a.c");
+        createSource(dir, sourcefile);
+        analyze(dir + "/build", sourcefile, std::list<std::string>(),
+                "  <summaries>\n"
+                "    <function name=\"f\" args=\"0\" returnValue=\"1\"/>\n"
+                "  </summaries>\n");
+
+        tinyxml2::XMLDocument doc;
+        doc.Parse("<summaries><call name=\"f\" args=\"0\" returnValue=\"1\"/></summaries>");
+        ASSERT_EQUALS(true, AnalyzerInformation::loadFunctionSummaries(dir + "/build")->isUnchanged(doc.FirstChildElement()));
+
+        writeFile(sourcefile, "int xy;\n");
+        ASSERT_EQUALS(false, AnalyzerInformation::loadFunctionSummaries(dir + "/build")->isUnchanged(doc.FirstChildElement()));
+
+        removeSource(dir, sourcefile);
+    }
+#endif
+};
+
+REGISTER_TEST(TestAnalyzerInformation)
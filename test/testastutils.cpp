@@ -34,6 +34,7 @@ private:
 
     void run() override {
         TEST_CASE(isReturnScope);
+        TEST_CASE(isSameExpression);
         TEST_CASE(isVariableChanged);
         TEST_CASE(isVariableChangedByFunctionCall);
     }
@@ -57,6 +58,28 @@ private:
         ASSERT_EQUALS(true, isReturnScope("void f() { if (a) { {throw new string(x);}; } }", -2)); // #7144
     }
 
+    bool isSameExpression(const char code[], const char tokStr1[], const char tokStr2[]) {
+        Settings settings;
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr(code);
+        tokenizer.tokenize(istr, "test.cpp");
+        const Token * const tok1 = Token::findsimplematch(tokenizer.tokens(), tokStr1);
+        const Token * const tok2 = Token::findsimplematch(tok1->next(), tokStr2);
+        const bool same = ::isSameExpression(true, false, tok1, tok2, settings.library, false);
+        ASSERT(tok1->exprHash() != 0 && (!same || tok1->exprHash() == tok2->exprHash()));
+        return same;
+    }
+
+    void isSameExpression() {
+        ASSERT_EQUALS(true, isSameExpression("void f(int a, int b) { x = a + b; y = a + b; }", "+", "+"));
+        ASSERT_EQUALS(true, isSameExpression("void f(int a, int b) { x = a + b; y = b + a; }", "+", "+"));
+        ASSERT_EQUALS(false, isSameExpression("void f(int a, int b) { x = a - b; y = b - a; }", "-", "-"));
+        ASSERT_EQUALS(true, isSameExpression("void f(int a, int b) { x = a < b; y = b > a; }", "<", ">"));
+        ASSERT_EQUALS(false, isSameExpression("void f(int a, int b) { x = a < b; y = a > b; }", "<", ">"));
+        ASSERT_EQUALS(false, isSameExpression("void f(int a, int b) { x = a * 2; y = b * 2; }", "*", "*"));
+        ASSERT_EQUALS(true, isSameExpression("struct S { int i; void f() { x = this->i + 1; y = i + 1; } };", "+", "+"));
+    }
+
     bool isVariableChanged(const char code[], const char startPattern[], const char endPattern[]) {
         Settings settings;
         Tokenizer tokenizer(&settings, this);
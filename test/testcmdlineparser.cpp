@@ -25,6 +25,8 @@
 #include "testsuite.h"
 #include "timer.h"
 
+#include <cstdio>
+#include <fstream>
 #include <list>
 #include <set>
 #include <sstream>
@@ -101,6 +103,8 @@ private:
         TEST_CASE(maxConfigsMissingCount);
         TEST_CASE(maxConfigsInvalid);
         TEST_CASE(maxConfigsTooSmall);
+        TEST_CASE(checkThreads);
+        TEST_CASE(checkThreadsInvalid);
         TEST_CASE(reportProgressTest); // "Test" suffix to avoid hiding the parent's reportProgress
         TEST_CASE(stdposix);
         TEST_CASE(stdc99);
@@ -141,6 +145,7 @@ private:
 
         TEST_CASE(checkconfig);
         TEST_CASE(unknownParam);
+        TEST_CASE(libraryBeforeBuildDir);
 
         TEST_CASE(undefs_noarg);
         TEST_CASE(undefs_noarg2);
@@ -679,6 +684,23 @@ private:
         ASSERT_EQUALS(false, defParser.parseFromArgs(3, argv));
     }
 
+    void checkThreads() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--check-threads=4", "file.cpp"};
+        settings.checkThreads = 1;
+        ASSERT(defParser.parseFromArgs(3, argv));
+        ASSERT_EQUALS(4, settings.checkThreads);
+    }
+
+    void checkThreadsInvalid() {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--check-threads=0", "file.cpp"};
+        // Fails since at least one thread is needed
+        ASSERT_EQUALS(false, defParser.parseFromArgs(3, argv));
+        const char *argv2[] = {"cppcheck", "--check-threads=e", "file.cpp"};
+        ASSERT_EQUALS(false, defParser.parseFromArgs(3, argv2));
+    }
+
     void reportProgressTest() {
         REDIRECT;
         const char *argv[] = {"cppcheck", "--report-progress", "file.cpp"};
@@ -1003,6 +1025,25 @@ private:
         ASSERT(!defParser.parseFromArgs(3, argv));
     }
 
+    void libraryBeforeBuildDir() {
+        // The snapshot of the library is written into the build dir that is given after it
+        REDIRECT;
+        {
+            std::ofstream fout("testcmdlineparser.cfg");
+            fout << "<?xml version=\"1.0\"?>\n<def><function name=\"foo\"><pure/></function></def>";
+        }
+        const char *argv[] = {"cppcheck", "--library=testcmdlineparser.cfg", "--cppcheck-build-dir=.", "file.cpp"};
+        Settings settings2;
+        CmdLineParser parser(&settings2);
+        ASSERT(parser.parseFromArgs(4, argv));
+        ASSERT(settings2.library.isFunctionConst("foo", true));
+        const std::string snapshotFile(settings2.library.getSnapshotFile("testcmdlineparser.cfg"));
+        ASSERT_EQUALS("./testcmdlineparser.cfg.cache", snapshotFile);
+        ASSERT(std::ifstream(snapshotFile).is_open());
+        std::remove(snapshotFile.c_str());
+        std::remove("testcmdlineparser.cfg");
+    }
+
     void undefs() {
         REDIRECT;
         const char *argv[] = {"cppcheck", "-U_WIN32", "file.cpp"};
@@ -16,15 +16,31 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "analyzerinfo.h"
 #include "check.h"
 #include "cppcheck.h"
 #include "errorlogger.h"
+#include "functionsummaries.h"
+#include "importproject.h"
+#include "settings.h"
 #include "testsuite.h"
+#include "tokenize.h"
 
+#include <tinyxml2.h>
 #include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
 #include <list>
+#include <memory>
+#include <sstream>
 #include <string>
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <utime.h>
+#endif
+
 
 class TestCppcheck : public TestFixture {
 public:
@@ -36,12 +52,14 @@ private:
     class ErrorLogger2 : public ErrorLogger {
     public:
         std::list<std::string> id;
+        std::string errout;
 
         void reportOut(const std::string & /*outmsg*/) {
         }
 
         void reportErr(const ErrorLogger::ErrorMessage &msg) {
             id.push_back(msg._id);
+            errout += msg.toString(false) + '\n';
         }
     };
 
@@ -49,6 +67,17 @@ private:
         TEST_CASE(instancesSorted);
         TEST_CASE(classInfoFormat);
         TEST_CASE(getErrorMessages);
+        TEST_CASE(tokenCensus);
+        TEST_CASE(checkThreads);
+        TEST_CASE(uniqueErrors);
+#ifdef HAVE_RULES
+        TEST_CASE(rules);
+        TEST_CASE(ruleBadPattern);
+#endif
+#ifndef _WIN32
+        TEST_CASE(skipUnchangedFile);
+        TEST_CASE(projectContext);
+#endif
     }
 
     void instancesSorted() const {
@@ -105,6 +134,254 @@ private:
         ASSERT(foundPurgedConfiguration);
         ASSERT(foundTooManyConfigs);
     }
+
+    bool census(const Settings &settings, const char code[], const char name[], bool *allocation = nullptr) {
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr(code);
+        tokenizer.tokenize(istr, "test.cpp");
+        const Check::TokenCensus tokenCensus(&tokenizer, &settings);
+        if (allocation)
+            *allocation = tokenCensus.hasAllocation();
+        return tokenCensus.hasName(name);
+    }
+
+    void tokenCensus() {
+        Settings settings;
+        LOAD_LIB_2(settings.library, "std.cfg");
+
+        bool allocation = true;
+        ASSERT_EQUALS(true, census(settings, "void f() { BOOST_FOREACH(int x, v) {} }", "BOOST_FOREACH", &allocation));
+        ASSERT_EQUALS(false, allocation);
+        ASSERT_EQUALS(false, census(settings, "void f() { assert(x); }", "BOOST_FOREACH"));
+
+        census(settings, "void f() { char *p = malloc(10); }", "p", &allocation);
+        ASSERT_EQUALS(true, allocation);
+        census(settings, "void f(char *p) { free(p); }", "p", &allocation);
+        ASSERT_EQUALS(true, allocation);
+        census(settings, "void f() { int *p = new int; }", "p", &allocation);
+        ASSERT_EQUALS(true, allocation);
+        census(settings, "void f() { FILE *f = std::fopen(\"a\", \"r\"); }", "f", &allocation);
+        ASSERT_EQUALS(true, allocation);
+        census(settings, "void f() { int x = strlen(s); }", "x", &allocation);
+        ASSERT_EQUALS(false, allocation);
+
+        // function of another TU that returns allocated memory
+        tinyxml2::XMLDocument doc;
+        doc.Parse("<summaries><function name=\"make\" args=\"0\" alloc=\"1\"/></summaries>");
+        std::shared_ptr<FunctionSummaries> functionSummaries = std::make_shared<FunctionSummaries>();
+        functionSummaries->load(doc.FirstChildElement());
+        census(settings, "char *make(); void f() { char *p = make(); }", "p", &allocation);
+        ASSERT_EQUALS(false, allocation);
+        settings.functionSummaries = functionSummaries;
+        census(settings, "char *make(); void f() { char *p = make(); }", "p", &allocation);
+        ASSERT_EQUALS(true, allocation);
+    }
+
+    std::list<std::string> checkIds(unsigned int checkThreads) const {
+        const char code[] = "void f(int x) {\n"
+                            "    char *p = malloc(10);\n"
+                            "    int a[10];\n"
+                            "    a[10] = 0;\n"
+                            "    if (x == 1 && x == 2) {}\n"
+                            "    int *q = 0;\n"
+                            "    *q = 0;\n"
+                            "    int y;\n"
+                            "    x = y;\n"
+                            "}\n";
+        ErrorLogger2 errorLogger;
+        CppCheck cppCheck(errorLogger, true);
+        cppCheck.settings().addEnabled("warning");
+        cppCheck.settings().addEnabled("style");
+        cppCheck.settings().checkThreads = checkThreads;
+        cppCheck.check("test.c", code);
+        return errorLogger.id;
+    }
+
+    void checkThreads() const {
+        const std::list<std::string> serial = checkIds(1);
+        ASSERT(serial.size() > 3U);
+        ASSERT(serial == checkIds(4));
+    }
+
+    void uniqueErrors() const {
+        // the error is found in both configurations
+        const char code[] = "void f() {\n"
+                            "#ifdef A\n"
+                            "    int x;\n"
+                            "#endif\n"
+                            "    int a[10];\n"
+                            "    a[10] = 0;\n"
+                            "}\n";
+        {
+            ErrorLogger2 errorLogger;
+            CppCheck cppCheck(errorLogger, true);
+            cppCheck.check("test.c", code);
+            ASSERT_EQUALS(1U, errorLogger.id.size());
+        }
+        {
+            ErrorLogger2 errorLogger;
+            CppCheck cppCheck(errorLogger, true);
+            cppCheck.settings().nomsg.addSuppressionLine("arrayIndexOutOfBounds");
+            cppCheck.check("test.c", code);
+            ASSERT_EQUALS(0U, errorLogger.id.size());
+        }
+    }
+
+#ifdef HAVE_RULES
+    static Settings::Rule rule(const char id[], const char pattern[]) {
+        Settings::Rule r;
+        r.tokenlist = "normal";
+        r.pattern = pattern;
+        r.id = id;
+        r.summary = std::string(id) + " is used";
+        return r;
+    }
+
+    void rules() const {
+        const char code[] = "void f(char *s) {\n"
+                            "    char *p = alloca(10);\n"
+                            "    strcpy(p, s);\n"
+                            "}\n";
+        ErrorLogger2 errorLogger;
+        CppCheck cppCheck(errorLogger, true);
+        cppCheck.settings().rules.push_back(rule("alloca", "alloca \\("));
+        cppCheck.settings().rules.push_back(rule("strcpy", "strcpy \\("));
+        cppCheck.check("test.c", code);
+        ASSERT_EQUALS("[test.c:2]: (style) alloca is used\n"
+                      "[test.c:3]: (style) strcpy is used\n", errorLogger.errout);
+
+        // The rules are compiled again when the settings are changed
+        errorLogger.errout.clear();
+        cppCheck.settings().rules.clear();
+        cppCheck.settings().rules.push_back(rule("strcpy", "strcpy \\("));
+        cppCheck.check("test.c", code);
+        ASSERT_EQUALS("[test.c:3]: (style) strcpy is used\n", errorLogger.errout);
+    }
+
+    void ruleBadPattern() const {
+        // The error is reported and the other rules are used
+        ErrorLogger2 errorLogger;
+        CppCheck cppCheck(errorLogger, true);
+        cppCheck.settings().rules.push_back(rule("bad", "["));
+        cppCheck.settings().rules.push_back(rule("alloca", "alloca \\("));
+        cppCheck.check("test.c", "void f() { char *p = alloca(10); }");
+        ASSERT_EQUALS(2U, errorLogger.id.size());
+        ASSERT_EQUALS("pcre_compile", errorLogger.id.front());
+        ASSERT_EQUALS("alloca", errorLogger.id.back());
+    }
+#endif
+
+#ifndef _WIN32
+    static void writeFile(const std::string &filename, const char data[]) {
+        std::ofstream fout(filename);
+        fout << data;
+    }
+
+    /** Set the modification time of a file or directory to a time long ago */
+    static void setOldTime(const std::string &path) {
+        struct utimbuf times;
+        times.actime = times.modtime = 1000000000;
+        utime(path.c_str(), &times);
+    }
+
+    static std::list<std::string> checkBuildDir(const std::string &buildDir, const std::string &filename, const char content[] = nullptr) {
+        ErrorLogger2 errorLogger;
+        CppCheck cppCheck(errorLogger, true);
+        cppCheck.settings().buildDir = buildDir;
+        if (content)
+            cppCheck.check(filename, content);
+        else
+            cppCheck.check(filename);
+        return errorLogger.id;
+    }
+
+    void skipUnchangedFile() const {
+        // The directory of the files must be older than the analysis,
+        // a directory that is modified in the same second is changed.
+        const std::string dir("testskipunchanged");
+        const std::string buildDir(dir + "/build");
+        const std::string source(dir + "/a.c");
+        const std::string header1(dir + "/a.h");
+        const std::string header2(dir + "/b.h");
+        mkdir(dir.c_str(), 0777);
+        mkdir(buildDir.c_str(), 0777);
+        writeFile(source, "#include \"a.h\"\n");
+        writeFile(header1, "void f() { int a[10]; a[10] = 0; }\n");
+        writeFile(header2, "void f() { }\n");
+        setOldTime(source);
+        setOldTime(header1);
+        setOldTime(dir);
+
+        ASSERT_EQUALS(1U, checkBuildDir(buildDir, source).size());
+        ASSERT_EQUALS(1U, checkBuildDir(buildDir, source).size());
+
+        // A changed header is noticed
+        writeFile(header1, "void f() { int a[10]; a[9] = 0; }\n");
+        ASSERT_EQUALS(0U, checkBuildDir(buildDir, source).size());
+        writeFile(header1, "void f() { int a[10]; a[10] = 0; }\n");
+        setOldTime(header1);
+        ASSERT_EQUALS(1U, checkBuildDir(buildDir, source).size());
+
+        // An unchanged file is not read. It is unchanged if its size and
+        // time are the same, so this change is not seen.
+        writeFile(source, "#include \"b.h\"\n");
+        setOldTime(source);
+        ASSERT_EQUALS(1U, checkBuildDir(buildDir, source).size());
+
+        // Content that is given in memory is checked
+        ASSERT_EQUALS(0U, checkBuildDir(buildDir, source, "#include \"b.h\"\n").size());
+
+        std::remove(source.c_str());
+        std::remove(header1.c_str());
+        std::remove(header2.c_str());
+        std::remove(AnalyzerInfoStore::getStoreFile(buildDir).c_str());
+        std::remove(buildDir.c_str());
+        std::remove(dir.c_str());
+    }
+
+    static std::list<std::string> checkProject(const std::string &buildDir, const std::list<ImportProject::FileSettings> &fileSettings) {
+        ErrorLogger2 errorLogger;
+        CppCheck cppCheck(errorLogger, true);
+        cppCheck.settings().buildDir = buildDir;
+        for (std::list<ImportProject::FileSettings>::const_iterator fs = fileSettings.begin(); fs != fileSettings.end(); ++fs)
+            cppCheck.check(*fs);
+        return errorLogger.id;
+    }
+
+    void projectContext() const {
+        // Project files with the same settings are checked by the same
+        // CppCheck instance. The errors of a file that is not read must not
+        // hide the same errors in the next file.
+        const std::string dir("testprojectcontext");
+        const std::string buildDir(dir + "/build");
+        const std::string header(dir + "/h.h");
+        mkdir(dir.c_str(), 0777);
+        mkdir(buildDir.c_str(), 0777);
+        writeFile(header, "void f() { int a[10]; a[10] = 0; }\n");
+        setOldTime(header);
+        std::list<ImportProject::FileSettings> fileSettings;
+        for (const char *name : { "/a.c", "/b.c" }) {
+            ImportProject::FileSettings fs;
+            fs.filename = dir + name;
+            writeFile(fs.filename, "#include \"h.h\"\n");
+            setOldTime(fs.filename);
+            fileSettings.push_back(fs);
+        }
+        setOldTime(dir);
+
+        ASSERT_EQUALS(2U, checkProject(buildDir, fileSettings).size());
+        writeFile(fileSettings.back().filename, "#include \"h.h\"\nint x;\n");
+        ASSERT_EQUALS(2U, checkProject(buildDir, fileSettings).size());
+        ASSERT_EQUALS(2U, checkProject(buildDir, fileSettings).size());
+
+        for (std::list<ImportProject::FileSettings>::const_iterator fs = fileSettings.begin(); fs != fileSettings.end(); ++fs)
+            std::remove(fs->filename.c_str());
+        std::remove(header.c_str());
+        std::remove(AnalyzerInfoStore::getStoreFile(buildDir).c_str());
+        std::remove(buildDir.c_str());
+        std::remove(dir.c_str());
+    }
+#endif
 };
 
 REGISTER_TEST(TestCppcheck)
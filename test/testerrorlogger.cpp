@@ -57,6 +57,7 @@ private:
         TEST_CASE(SerializeInconclusiveMessage);
         TEST_CASE(DeserializeInvalidInput);
         TEST_CASE(SerializeSanitize);
+        TEST_CASE(SerializeBinary);
 
         TEST_CASE(suppressUnmatchedSuppressions);
     }
@@ -288,6 +289,35 @@ private:
         ASSERT_EQUALS("Illegal character in \"foo\\001bar\"", msg2.verboseMessage());
     }
 
+    void SerializeBinary() const {
+        std::list<ErrorLogger::ErrorMessage::FileLocation> locs;
+        locs.emplace_back("foo.cpp", "first", 5);
+        locs.emplace_back("bar.cpp", "second", 8);
+        locs.back().col = 3;
+        ErrorMessage msg(locs, emptyString, Severity::warning, "$symbol:var\nShort \001message\nVerbose message", "errorId", CWE(123), true);
+
+        std::string data;
+        msg.serializeBinary(data);
+
+        ErrorMessage msg2;
+        ASSERT_EQUALS(true, msg2.deserializeBinary(data.data(), data.size()));
+        ASSERT_EQUALS("errorId", msg2._id);
+        ASSERT_EQUALS(Severity::warning, msg2._severity);
+        ASSERT_EQUALS(123, msg2._cwe.id);
+        ASSERT_EQUALS(true, msg2._inconclusive);
+        ASSERT_EQUALS("Short \\001message", msg2.shortMessage());
+        ASSERT_EQUALS("Verbose message", msg2.verboseMessage());
+        ASSERT_EQUALS("var\n", msg2.symbolNames());
+        ASSERT_EQUALS(2, msg2._callStack.size());
+        ASSERT_EQUALS("bar.cpp", msg2._callStack.back().getfile());
+        ASSERT_EQUALS("second", msg2._callStack.back().getinfo());
+        ASSERT_EQUALS(8, msg2._callStack.back().line);
+        ASSERT_EQUALS(3, msg2._callStack.back().col);
+
+        // truncated data
+        ASSERT_EQUALS(false, msg2.deserializeBinary(data.data(), data.size() - 1));
+    }
+
     void suppressUnmatchedSuppressions() {
         std::list<Suppressions::Suppression> suppressions;
 
@@ -4,6 +4,7 @@ INCLUDEPATH += ../externals/tinyxml
 
 
 SOURCES += $${BASEPATH}/test64bit.cpp \
+           $${BASEPATH}/testanalyzerinformation.cpp \
            $${BASEPATH}/testassert.cpp \
            $${BASEPATH}/testastutils.cpp \
            $${BASEPATH}/testautovariables.cpp \
@@ -20,6 +21,7 @@ SOURCES += $${BASEPATH}/test64bit.cpp \
            $${BASEPATH}/testexceptionsafety.cpp \
            $${BASEPATH}/testfilelister.cpp \
            $${BASEPATH}/testfunctions.cpp \
+           $${BASEPATH}/testfunctionsummaries.cpp \
            $${BASEPATH}/testgarbage.cpp \
            $${BASEPATH}/testimportproject.cpp \
            $${BASEPATH}/testincompletestatement.cpp \
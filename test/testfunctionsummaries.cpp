@@ -0,0 +1,175 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2018 Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "functionsummaries.h"
+#include "settings.h"
+#include "testsuite.h"
+#include "tokenize.h"
+
+#include <tinyxml2.h>
+#include <memory>
+#include <sstream>
+#include <string>
+
+
+class TestFunctionSummaries : public TestFixture {
+public:
+    TestFunctionSummaries() : TestFixture("TestFunctionSummaries") {
+    }
+
+private:
+    Settings settings;
+
+    void run() override {
+        LOAD_LIB_2(settings.library, "std.cfg");
+
+        TEST_CASE(returnValue);
+        TEST_CASE(returnAlloc);
+        TEST_CASE(argumentUsage);
+        TEST_CASE(notSummarized);
+        TEST_CASE(calls);
+        TEST_CASE(conflict);
+        TEST_CASE(isUnchanged);
+    }
+
+    std::string toXml(const char code[]) {
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr(code);
+        tokenizer.tokenize(istr, "test.cpp");
+        return FunctionSummaries::toXml(&tokenizer, &settings);
+    }
+
+    void load(const char xml1[], const char xml2[] = nullptr) {
+        std::shared_ptr<FunctionSummaries> functionSummaries = std::make_shared<FunctionSummaries>();
+        tinyxml2::XMLDocument doc1;
+        doc1.Parse(xml1);
+        functionSummaries->load(doc1.FirstChildElement());
+        if (xml2) {
+            tinyxml2::XMLDocument doc2;
+            doc2.Parse(xml2);
+            functionSummaries->load(doc2.FirstChildElement());
+        }
+        settings.functionSummaries = functionSummaries;
+    }
+
+    bool isUnchanged(const char xml[]) const {
+        tinyxml2::XMLDocument doc;
+        doc.Parse(xml);
+        return settings.functionSummaries->isUnchanged(doc.FirstChildElement());
+    }
+
+    void returnValue() {
+        ASSERT_EQUALS("  <summaries>\n"
+                      "    <function name=\"f\" args=\"0\" returnValue=\"42\"/>\n"
+                      "    <function name=\"g\" args=\"1\" returnValue=\"1\"/>\n"
+                      "    <function name=\"h\" args=\"1\"/>\n"
+                      "    <function name=\"i\" args=\"1\"/>\n"
+                      "    <function name=\"j\" args=\"0\"/>\n"
+                      "  </summaries>\n",
+                      toXml("int f() { return 42; }\n"
+                            "int g(int x) { if (x) return 1; return 1; }\n"
+                            "int h(int x) { if (x) return 1; return 2; }\n"
+                            "int i(int x) { return x; }\n"
+                            "void j() { }"));
+    }
+
+    void returnAlloc() {
+        ASSERT_EQUALS("  <summaries>\n"
+                      "    <function name=\"f\" args=\"0\" alloc=\"1\"/>\n"
+                      "    <function name=\"g\" args=\"0\" alloc=\"1\"/>\n"
+                      "  </summaries>\n",
+                      toXml("char *f() { return malloc(10); }\n"
+                            "char *g() { char *p = f(); return p; }"));
+    }
+
+    void argumentUsage() {
+        ASSERT_EQUALS("  <summaries>\n"
+                      "    <function name=\"f\" args=\"2\" notnull=\"1,2\" notuninit=\"1\"/>\n"
+                      "    <function name=\"g\" args=\"1\" notnull=\"1\"/>\n"
+                      "    <function name=\"h\" args=\"1\"/>\n"
+                      "    <function name=\"i\" args=\"1\"/>\n"
+                      "    <function name=\"j\" args=\"1\"/>\n"
+                      "    <function name=\"k\" args=\"1\"/>\n"
+                      "    <function name=\"l\" args=\"1\" notnull=\"1\" notuninit=\"1\"/>\n"
+                      "  </summaries>\n",
+                      toXml("void f(int *p, int *q) { *q = *p; }\n"
+                            "void g(int *p) { p[0] = 1; }\n"
+                            "void h(int *p) { if (p) *p = 1; }\n"
+                            "void i(int *p) { p = 0; *p = 1; }\n"
+                            "void j(int *p) { exit(1); *p = 1; }\n"
+                            "void k(int x) { x = 1; }\n"
+                            "int l(int *p) { int y = *p; return y; }"));
+
+        // the summaries are compared when a TU is analyzed again
+        load("<summaries><function name=\"f\" args=\"1\" notnull=\"1\"/></summaries>");
+        ASSERT_EQUALS(true, isUnchanged("<summaries><call name=\"f\" args=\"1\" notnull=\"1\"/></summaries>"));
+        ASSERT_EQUALS(false, isUnchanged("<summaries><call name=\"f\" args=\"1\"/></summaries>"));
+        settings.functionSummaries.reset();
+    }
+
+    void notSummarized() {
+        // static functions, members and overloads with the same number of arguments
+        ASSERT_EQUALS("  <summaries>\n"
+                      "    <function name=\"i\" args=\"0\" returnValue=\"3\"/>\n"
+                      "  </summaries>\n",
+                      toXml("static int f() { return 1; }\n"
+                            "struct A { int g() { return 1; } };\n"
+                            "int h(int) { return 1; }\n"
+                            "int h(char) { return 2; }\n"
+                            "int i() { return 3; }"));
+    }
+
+    void calls() {
+        load("<summaries><function name=\"f\" args=\"0\" returnValue=\"1\"/></summaries>");
+        ASSERT_EQUALS("  <summaries>\n"
+                      "    <function name=\"h\" args=\"0\"/>\n"
+                      "    <call name=\"f\" args=\"0\" returnValue=\"1\"/>\n"
+                      "    <call name=\"g\" args=\"1\"/>\n"
+                      "  </summaries>\n",
+                      toXml("int f();\n"
+                            "int g(int);\n"
+                            "void h() { f(); g(1); f(); }"));
+        settings.functionSummaries.reset();
+    }
+
+    void conflict() {
+        // a function is defined differently in two TUs
+        load("<summaries><function name=\"f\" args=\"0\" returnValue=\"1\"/><function name=\"g\" args=\"0\" returnValue=\"3\"/></summaries>",
+             "<summaries><function name=\"f\" args=\"0\" returnValue=\"2\"/><function name=\"g\" args=\"0\" returnValue=\"3\"/></summaries>");
+        ASSERT_EQUALS("  <summaries>\n"
+                      "    <call name=\"f\" args=\"0\"/>\n"
+                      "    <call name=\"g\" args=\"0\" returnValue=\"3\"/>\n"
+                      "  </summaries>\n",
+                      toXml("int f();\n"
+                            "int g();\n"
+                            "int x = f() + g();"));
+        settings.functionSummaries.reset();
+    }
+
+    void isUnchanged() {
+        load("<summaries><function name=\"f\" args=\"0\" returnValue=\"1\"/></summaries>");
+        ASSERT_EQUALS(true, isUnchanged("<summaries><call name=\"f\" args=\"0\" returnValue=\"1\"/></summaries>"));
+        ASSERT_EQUALS(false, isUnchanged("<summaries><call name=\"f\" args=\"0\"/></summaries>"));
+        ASSERT_EQUALS(false, isUnchanged("<summaries><call name=\"f\" args=\"0\" returnValue=\"2\"/></summaries>"));
+        ASSERT_EQUALS(true, isUnchanged("<summaries><call name=\"g\" args=\"0\"/></summaries>"));
+        ASSERT_EQUALS(false, isUnchanged("<summaries><call name=\"g\" args=\"0\" alloc=\"1\"/></summaries>"));
+        settings.functionSummaries.reset();
+    }
+};
+
+REGISTER_TEST(TestFunctionSummaries)
@@ -43,7 +43,11 @@ private:
         TEST_CASE(setIncludePaths1);
         TEST_CASE(setIncludePaths2);
         TEST_CASE(setIncludePaths3); // macro names are case insensitive
+        TEST_CASE(contextKey);
         TEST_CASE(importCompileCommands);
+        TEST_CASE(importCompileCommandsArguments);
+        TEST_CASE(importCompileCommandsValues);
+        TEST_CASE(importCompileCommandsInvalid);
     }
 
     void setDefines() const {
@@ -91,6 +95,33 @@ private:
         ASSERT_EQUALS("c:/abc/other/", fs.includePaths.front());
     }
 
+    void contextKey() const {
+        ImportProject::FileSettings fs1;
+        fs1.filename = "a.c";
+        fs1.setDefines("A;B=2");
+        fs1.includePaths.push_back("inc/");
+
+        ImportProject::FileSettings fs2 = fs1;
+        fs2.filename = "b.c";
+        fs2.cfg = "Debug";
+        ASSERT_EQUALS(fs1.contextKey(), fs2.contextKey());
+
+        fs2.includePaths.push_back("inc2/");
+        ASSERT(fs1.contextKey() != fs2.contextKey());
+
+        fs2 = fs1;
+        fs2.msc = true;
+        ASSERT(fs1.contextKey() != fs2.contextKey());
+
+        fs2 = fs1;
+        fs2.undefs.insert("A");
+        ASSERT(fs1.contextKey() != fs2.contextKey());
+
+        fs2 = fs1;
+        fs2.platformType = cppcheck::Platform::Win64;
+        ASSERT(fs1.contextKey() != fs2.contextKey());
+    }
+
     void importCompileCommands() const {
 
         const char json[] = "[ { \"directory\": \"/tmp\","
@@ -102,6 +133,53 @@ private:
         ASSERT_EQUALS(1, importer.fileSettings.size());
         ASSERT_EQUALS("TEST1=1;TEST2=2;TEST3=\"\\\"3\\\"\"", importer.fileSettings.begin()->defines);
     }
+
+    void importCompileCommandsArguments() const {
+        const char json[] = "[ { \"directory\": \"/tmp/\",\n"
+                            "    \"arguments\": [ \"gcc\", \"-I\", \"inc\", \"-DA\", \"-c\", \"src.c\" ],\n"
+                            "    \"file\": \"/tmp/src.c\" },\n"
+                            "  { \"directory\": \"/tmp/\",\n"
+                            "    \"arguments\": [ \"gcc\", \"-I\", \"inc\", \"-DA\", \"-c\", \"src2.c\" ],\n"
+                            "    \"file\": \"/tmp/src2.c\" } ]";
+        std::istringstream istr(json);
+        TestImporter importer;
+        importer.importCompileCommands(istr);
+        ASSERT_EQUALS(2, importer.fileSettings.size());
+        ASSERT_EQUALS("/tmp/src2.c", importer.fileSettings.back().filename);
+        ASSERT_EQUALS("A=1", importer.fileSettings.back().defines);
+        ASSERT_EQUALS(1, importer.fileSettings.back().includePaths.size());
+        ASSERT_EQUALS("/tmp/inc/", importer.fileSettings.back().includePaths.front());
+    }
+
+    void importCompileCommandsValues() const {
+        // values that are not strings are skipped, entries without file or command are ignored
+        const char json[] = "[{\"directory\":\"/tmp\",\"command\":\"gcc -DX -c a.c\",\"file\":\"a.c\","
+                            "\"number\":12,\"flag\":true,\"nested\":{\"x\":[1,\"]\"]}},"
+                            "{\"directory\":\"/tmp\",\"file\":\"b.c\"}]";
+        std::istringstream istr(json);
+        TestImporter importer;
+        importer.importCompileCommands(istr);
+        ASSERT_EQUALS(1, importer.fileSettings.size());
+        ASSERT_EQUALS("a.c", importer.fileSettings.front().filename);
+        ASSERT_EQUALS("X=1", importer.fileSettings.front().defines);
+    }
+
+    void importCompileCommandsInvalid() const {
+        // an entry that is not well-formed does not end the import
+        const char json[] = "[{\"directory\":\"/tmp\",\"arguments\":[\"gcc\",1,\"-DA\",\"-c\",\"a.c\"],\"file\":\"a.c\"},"
+                            "{\"directory\":\"/tmp\",\"command\" \"gcc -c b.c\",\"file\":\"b.c\"},"
+                            "{\"directory\":\"/tmp\",\"arguments\":[\"gcc\",\"-c\",\"c.c\"},"
+                            "7,"
+                            "{\"directory\":\"/tmp\",\"command\":\"gcc -DD -c d.c\",\"file\":\"d.c\"}]";
+        std::istringstream istr(json);
+        TestImporter importer;
+        importer.importCompileCommands(istr);
+        ASSERT_EQUALS(2, importer.fileSettings.size());
+        ASSERT_EQUALS("a.c", importer.fileSettings.front().filename);
+        ASSERT_EQUALS("A=1", importer.fileSettings.front().defines);
+        ASSERT_EQUALS("d.c", importer.fileSettings.back().filename);
+        ASSERT_EQUALS("D=1", importer.fileSettings.back().defines);
+    }
 };
 
 REGISTER_TEST(TestImportProject)
@@ -26,6 +26,8 @@
 #include "tokenlist.h"
 
 #include <tinyxml2.h>
+#include <cstdio>
+#include <fstream>
 #include <map>
 #include <set>
 #include <string>
@@ -45,6 +47,7 @@ private:
         TEST_CASE(function_match_scope);
         TEST_CASE(function_match_args);
         TEST_CASE(function_match_args_default);
+        TEST_CASE(function_calls); // queries for calls that are resolved once
         TEST_CASE(function_match_var);
         TEST_CASE(function_arg);
         TEST_CASE(function_arg_any);
@@ -59,10 +62,12 @@ private:
         TEST_CASE(memory2); // define extra "free" allocation functions
         TEST_CASE(memory3);
         TEST_CASE(resource);
+        TEST_CASE(defines);
         TEST_CASE(podtype);
         TEST_CASE(container);
         TEST_CASE(version);
         TEST_CASE(loadLibErrors);
+        TEST_CASE(snapshot);
     }
 
     static Library::Error readLibrary(Library& library, const char* xmldata) {
@@ -144,6 +149,53 @@ private:
         ASSERT(library.isNotLibraryFunction(tokenList.front()));
     }
 
+    void function_calls() const {
+        const char xmldata[] = "<?xml version=\"1.0\"?>\n"
+                               "<def>\n"
+                               "  <function name=\"foo\">\n"
+                               "    <noreturn>false</noreturn>\n"
+                               "    <arg nr=\"1\"><not-null/></arg>\n"
+                               "  </function>\n"
+                               "</def>";
+
+        TokenList tokenList(nullptr);
+        std::istringstream istr("foo(0); bar(0); foo();");
+        tokenList.createTokens(istr);
+        Token::createMutualLinks(tokenList.front()->next(), tokenList.front()->tokAt(3));
+        Token::createMutualLinks(tokenList.front()->tokAt(6), tokenList.front()->tokAt(8));
+        Token::createMutualLinks(tokenList.back()->tokAt(-2), tokenList.back()->previous());
+        tokenList.createAst();
+        tokenList.createLibraryCalls();
+
+        const Token *foo = tokenList.front();
+        const Token *bar = foo->tokAt(5);
+        const Token *foo2 = tokenList.back()->tokAt(-3);
+        ASSERT(foo->libraryCall() != nullptr);
+        ASSERT(tokenList.front()->next()->libraryCall() == nullptr);
+
+        Library library;
+        ASSERT_EQUALS(true, Library::OK == (readLibrary(library, xmldata)).errorcode);
+        for (int i = 0; i < 2; ++i) { // resolve and use resolved call
+            ASSERT_EQUALS("foo", library.getFunctionName(foo));
+            ASSERT(!library.isNotLibraryFunction(foo));
+            ASSERT(library.isnullargbad(foo, 1));
+            ASSERT(library.isnotnoreturn(foo));
+            ASSERT_EQUALS("bar", library.getFunctionName(bar));
+            ASSERT(!library.isnullargbad(bar, 1));
+            ASSERT(library.isNotLibraryFunction(foo2)); // <- too few arguments
+            ASSERT(!library.isnullargbad(foo2, 1));
+        }
+
+        // another library does not use the calls resolved by the first one
+        Library library2;
+        ASSERT(library2.isNotLibraryFunction(foo));
+        ASSERT(!library2.isnullargbad(foo, 1));
+
+        tokenList.clearLibraryCalls();
+        ASSERT(foo->libraryCall() == nullptr);
+        ASSERT(library.isnullargbad(foo, 1));
+    }
+
     void function_match_args_default() const {
         const char xmldata[] = "<?xml version=\"1.0\"?>\n"
                                "<def>\n"
@@ -564,6 +616,38 @@ private:
         ASSERT_EQUALS(library.allocId("CreateX"), library.deallocId("DeleteX"));
     }
 
+    static std::string definesString(const std::vector<const std::string *> &defines) {
+        std::string ret;
+        for (std::size_t i = 0; i < defines.size(); ++i)
+            ret += (i ? "," : "") + defines[i]->substr(8, defines[i]->find_first_of(" (", 8) - 8);
+        return ret;
+    }
+
+    void defines() const {
+        const char xmldata[] = "<?xml version=\"1.0\"?>\n"
+                               "<def>\n"
+                               "  <define name=\"A\" value=\"B(1)\"/>\n"
+                               "  <define name=\"B(x)\" value=\"(x + C)\"/>\n"
+                               "  <define name=\"C\" value=\"0x1D\"/>\n"
+                               "  <define name=\"D\" value=\"2\"/>\n"
+                               "  <define name=\"E(x)\" value=\"D##x\"/>\n"
+                               "</def>";
+
+        Library library;
+        ASSERT_EQUALS(true, Library::OK == (readLibrary(library, xmldata)).errorcode);
+        ASSERT(library.isDefine("B"));
+        ASSERT(!library.isDefine("x"));
+
+        std::set<std::string> names;
+        ASSERT_EQUALS("", definesString(library.getDefines(names)));
+        names.insert("C");
+        ASSERT_EQUALS("C", definesString(library.getDefines(names)));
+        names.insert("A");
+        ASSERT_EQUALS("A,B,C", definesString(library.getDefines(names)));
+        names.insert("E"); // the names that token pasting makes are not known
+        ASSERT_EQUALS("A,B,C,D,E", definesString(library.getDefines(names)));
+    }
+
     void podtype() const {
         {
             const char xmldata[] = "<?xml version=\"1.0\"?>\n"
@@ -773,6 +857,99 @@ private:
             ASSERT_EQUALS(Library::UNSUPPORTED_FORMAT, readLibrary(library, xmldata).errorcode);
         }
     }
+
+    static void writeFile(const std::string &filename, const char data[]) {
+        std::ofstream fout(filename);
+        fout << data;
+    }
+
+    void snapshot() const {
+        const char xmldata1[] = "<?xml version=\"1.0\"?>\n"
+                                "<def>\n"
+                                "  <memory>\n"
+                                "    <alloc init=\"false\">myalloc</alloc>\n"
+                                "    <dealloc>myfree</dealloc>\n"
+                                "  </memory>\n"
+                                "  <function name=\"foo\">\n"
+                                "    <arg nr=\"1\"><not-null/></arg>\n"
+                                "  </function>\n"
+                                "  <define name=\"X\" value=\"1\"/>\n"
+                                "</def>";
+        const char xmldata2[] = "<?xml version=\"1.0\"?>\n"
+                                "<def>\n"
+                                "  <function name=\"foo\">\n"
+                                "    <leak-ignore/>\n"
+                                "  </function>\n"
+                                "  <function name=\"bar\">\n"
+                                "    <pure/>\n"
+                                "  </function>\n"
+                                "  <container id=\"C\" startPattern=\"C <\">\n"
+                                "    <size><function name=\"size\" yields=\"size\"/></size>\n"
+                                "  </container>\n"
+                                "</def>";
+        const char xmldata3[] = "<?xml version=\"1.0\"?>\n"
+                                "<def>\n"
+                                "  <function name=\"bar\">\n"
+                                "    <const/>\n"
+                                "  </function>\n"
+                                "</def>";
+        const std::string file1("testlibrary_snapshot1.cfg");
+        const std::string file2("testlibrary_snapshot2.cfg");
+        writeFile(file1, xmldata1);
+        writeFile(file2, xmldata2);
+
+        // Without a snapshot dir no snapshot is written and the argument checks are read from the XML
+        {
+            Library library;
+            ASSERT_EQUALS(Library::OK, library.load(nullptr, file1.c_str()).errorcode);
+            ASSERT_EQUALS("", library.getSnapshotFile(file1));
+            ASSERT_EQUALS(false, std::ifstream(file1 + ".cache").is_open());
+            ASSERT_EQUALS(false, library.functions["foo"].lazyArgumentChecks.pending());
+            ASSERT_EQUALS(true, library.functions["foo"].argumentChecks.at(1).notnull);
+        }
+
+        // The first load writes the snapshots, the second reads them
+        for (int i = 0; i < 2; ++i) {
+            Library library;
+            library.setSnapshotDir(".");
+            ASSERT_EQUALS(Library::OK, library.load(nullptr, file1.c_str()).errorcode);
+            ASSERT_EQUALS(Library::OK, library.load(nullptr, file2.c_str()).errorcode);
+            ASSERT(std::ifstream(library.getSnapshotFile(file1)).is_open());
+            ASSERT(std::ifstream(library.getSnapshotFile(file2)).is_open());
+
+            ASSERT_EQUALS(2U, library.functions.size());
+            // the argument checks in the snapshot are read when they are used
+            ASSERT_EQUALS(i == 1, library.functions["foo"].lazyArgumentChecks.pending());
+            ASSERT_EQUALS(true, Library::getArgumentChecks(library.functions["foo"]).at(1).notnull);
+            ASSERT_EQUALS(false, library.functions["foo"].lazyArgumentChecks.pending());
+            ASSERT_EQUALS(true, library.functions["foo"].leakignore);
+            ASSERT_EQUALS(true, library.functions["bar"].ispure);
+            ASSERT_EQUALS(false, library.functions["bar"].isconst);
+            ASSERT(library.allocId("myalloc") > 0);
+            ASSERT_EQUALS(library.allocId("myalloc"), library.deallocId("myfree"));
+            ASSERT_EQUALS(1U, library.returnuninitdata.size());
+            ASSERT_EQUALS(1U, library.defines.size());
+            ASSERT_EQUALS(1U, library.containers.size());
+            ASSERT_EQUALS(Library::Container::SIZE, library.containers["C"].getYield("size"));
+        }
+
+        // A changed .cfg file is loaded again
+        writeFile(file2, xmldata3);
+        {
+            Library library;
+            library.setSnapshotDir(".");
+            ASSERT_EQUALS(Library::OK, library.load(nullptr, file1.c_str()).errorcode);
+            ASSERT_EQUALS(Library::OK, library.load(nullptr, file2.c_str()).errorcode);
+            ASSERT_EQUALS(false, library.functions["foo"].leakignore);
+            ASSERT_EQUALS(true, library.functions["bar"].isconst);
+            ASSERT(library.containers.empty());
+
+            std::remove(library.getSnapshotFile(file1).c_str());
+            std::remove(library.getSnapshotFile(file2).c_str());
+        }
+        std::remove(file1.c_str());
+        std::remove(file2.c_str());
+    }
 };
 
 REGISTER_TEST(TestLibrary)
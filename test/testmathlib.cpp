@@ -51,6 +51,7 @@ private:
         TEST_CASE(calculate);
         TEST_CASE(calculate1);
         TEST_CASE(typesuffix);
+        TEST_CASE(number);
         TEST_CASE(toLongNumber);
         TEST_CASE(toDoubleNumber);
         TEST_CASE(naninf);
@@ -234,6 +235,40 @@ private:
         ASSERT_EQUALS("2ULL",  MathLib::add("1ULL", "1LLU"));
     }
 
+    static std::string calculateNumber(const char first[], const char second[], char action) {
+        MathLib::number n1, n2;
+        if (!MathLib::number::parse(first, &n1) || !MathLib::number::parse(second, &n2))
+            return "invalid";
+        return MathLib::number::calculate(n1, n2, action).str();
+    }
+
+    void number() const {
+        MathLib::number n;
+        ASSERT_EQUALS(true, MathLib::number::parse("12345", &n));
+        ASSERT_EQUALS(true, n.isInt());
+        ASSERT_EQUALS(12345, n.intValue);
+        ASSERT_EQUALS(true, MathLib::number::parse("0x10ul", &n));
+        ASSERT_EQUALS(16, n.intValue);
+        ASSERT_EQUALS(MathLib::number::UL, n.suffix);
+        ASSERT_EQUALS(true, MathLib::number::parse("1.5f", &n));
+        ASSERT_EQUALS(true, n.isFloat());
+        ASSERT_EQUALS_DOUBLE(1.5, n.doubleValue, 0.001);
+        ASSERT_EQUALS(1, n.intValue);
+        ASSERT_EQUALS(false, MathLib::number::parse("1_km", &n));
+        ASSERT_EQUALS(false, MathLib::number::parse("abc", &n));
+
+        // same results as the std::string functions had
+        ASSERT_EQUALS("2L", calculateNumber("1U", "1L", '+'));
+        ASSERT_EQUALS("2ULL", calculateNumber("1ui64", "1", '+'));
+        ASSERT_EQUALS("-1U", calculateNumber("1U", "2", '-'));
+        ASSERT_EQUALS("-765LL", calculateNumber("0xff", "-3LL", '*'));
+        ASSERT_EQUALS("-3UL", calculateNumber("-7", "2UL", '/'));
+        ASSERT_EQUALS("-1", calculateNumber("-7", "2", '%'));
+        ASSERT_THROW(calculateNumber("1", "0", '/'), InternalError);
+        ASSERT_THROW(calculateNumber("1", "0", '%'), InternalError);
+        ASSERT_THROW(calculateNumber("-9223372036854775808", "-1", '/'), InternalError);
+    }
+
     void toLongNumber() const {
         // from hex
         ASSERT_EQUALS(0,      MathLib::toLongNumber("0x0"));
@@ -275,6 +310,12 @@ private:
         ASSERT_EQUALS(-1,  MathLib::toLongNumber("-10.E-1"));
         ASSERT_EQUALS(100, MathLib::toLongNumber("+10.0E+1"));
         ASSERT_EQUALS(-1,  MathLib::toLongNumber("-10.0E-1"));
+        ASSERT_EQUALS(-10, MathLib::toLongNumber("-10"));
+        ASSERT_EQUALS(10,  MathLib::toLongNumber("10uL"));
+        ASSERT_EQUALS(8,   MathLib::toLongNumber("010"));
+        ASSERT_EQUALS(123456789012345678LL,  MathLib::toLongNumber("123456789012345678"));
+        ASSERT_EQUALS(1234567890123456789LL, MathLib::toLongNumber("1234567890123456789"));
+        ASSERT_EQUALS(-9223372036854775807LL, MathLib::toLongNumber("-9223372036854775807"));
 
         // from char
         ASSERT_EQUALS((int)('A'),    MathLib::toLongNumber("'A'"));
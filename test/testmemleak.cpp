@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "checkmemoryleak.h"
+#include "functionsummaries.h"
 #include "preprocessor.h"
 #include "settings.h"
 #include "simplecpp.h"
@@ -26,7 +27,9 @@
 #include "tokenize.h"
 #include "tokenlist.h"
 
+#include <tinyxml2.h>
 #include <list>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -174,6 +177,7 @@ private:
         TEST_CASE(simple7);
         TEST_CASE(simple9);     // Bug 2435468 - member function "free"
         TEST_CASE(simple11);
+        TEST_CASE(simple12);    // every path frees the memory
         TEST_CASE(nonstd_free);
         TEST_CASE(new_nothrow);
 
@@ -261,6 +265,8 @@ private:
         TEST_CASE(allocfunc12); // #3660: allocating and returning non-local pointer => not allocfunc
         TEST_CASE(allocfunc13); // Ticket #4494 and #4540 - class function
         TEST_CASE(allocfunc14); // Use pointer before returning it
+        TEST_CASE(allocfunc15); // Same function called several times
+        TEST_CASE(allocfunc16); // Function that is defined in another TU
 
         TEST_CASE(inlineFunction); // #3989 - inline function
 
@@ -981,6 +987,54 @@ private:
         ASSERT_EQUALS("", errout.str());
     }
 
+    void simple12() {
+        check("void f(int a) {\n"
+              "    char *p = malloc(10);\n"
+              "    if (!p)\n"
+              "        return;\n"
+              "    if (a) {\n"
+              "        free(p);\n"
+              "        return;\n"
+              "    } else {\n"
+              "        g(p);\n"
+              "    }\n"
+              "    free(p);\n"
+              "}");
+        ASSERT_EQUALS("", errout.str());
+
+        check("void f(int a) {\n"
+              "    char *p = malloc(10);\n"
+              "    if (a)\n"
+              "        free(p);\n"
+              "}");
+        ASSERT_EQUALS("[test.cpp:5]: (error) Memory leak: p\n", errout.str());
+
+        check("void f(int a) {\n"
+              "    char *p = malloc(10);\n"
+              "    free(p);\n"
+              "    free(p);\n"
+              "}");
+        ASSERT_EQUALS("[test.cpp:4]: (error) Deallocating a deallocated pointer: p\n", errout.str());
+
+        check("void f(int a) {\n"
+              "    char *p = malloc(10);\n"
+              "    while (a--)\n"
+              "        g(p);\n"
+              "    if (!a)\n"
+              "        exit(1);\n"
+              "    free(p);\n"
+              "}");
+        ASSERT_EQUALS("", errout.str());
+
+        check("void f(int a) {\n"
+              "    char *p = malloc(10);\n"
+              "    if (a)\n"
+              "        free(p);\n"
+              "    return;\n"
+              "}");
+        ASSERT_EQUALS("[test.cpp:5]: (error) Memory leak: p\n", errout.str());
+    }
+
     void nonstd_free() {
         check("void f() {\n"
               "    void* mem = malloc(100, foo);" // Non-standard malloc() implementation
@@ -2754,6 +2808,56 @@ private:
         ASSERT_EQUALS("", errout.str());
     }
 
+    void allocfunc15() { // same function called several times
+        check("static char *a() {\n"
+              "    return malloc(10);\n"
+              "}\n"
+              "static void b() {\n"
+              "    char *p = a();\n"
+              "    free(p);\n"
+              "}\n"
+              "static void c() {\n"
+              "    char *q = a();\n"
+              "}\n"
+              "static void d() {\n"
+              "    char *r = a();\n"
+              "}");
+        ASSERT_EQUALS("[test.cpp:10]: (error) Memory leak: q\n"
+                      "[test.cpp:13]: (error) Memory leak: r\n", errout.str());
+
+        check("static char *a(int x) {\n"
+              "    if (x)\n"
+              "        return a(x - 1);\n"
+              "    return malloc(10);\n"
+              "}\n"
+              "static void b() {\n"
+              "    char *p = a(1);\n"
+              "}\n"
+              "static void c() {\n"
+              "    char *q = a(2);\n"
+              "}");
+        TODO_ASSERT_EQUALS("[test.cpp:8]: (error) Memory leak: p\n"
+                           "[test.cpp:11]: (error) Memory leak: q\n", "", errout.str());
+    }
+
+    void allocfunc16() { // function that is defined in another TU
+        const char code[] = "char *a();\n"
+                            "static void b() {\n"
+                            "    char *p = a();\n"
+                            "}";
+        check(code);
+        ASSERT_EQUALS("", errout.str());
+
+        tinyxml2::XMLDocument doc;
+        doc.Parse("<summaries><function name=\"a\" args=\"0\" alloc=\"1\"/></summaries>");
+        std::shared_ptr<FunctionSummaries> functionSummaries = std::make_shared<FunctionSummaries>();
+        functionSummaries->load(doc.FirstChildElement());
+        Settings settings(settings1);
+        settings.functionSummaries = functionSummaries;
+        check(code, false, false, false, &settings);
+        ASSERT_EQUALS("[test.cpp:4]: (error) Memory leak: p\n", errout.str());
+    }
+
     void inlineFunction() { // #3989 - inline function
         check("int test() {\n"
               "  char *c;\n"
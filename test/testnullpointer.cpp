@@ -17,6 +17,7 @@
  */
 
 #include "checknullpointer.h"
+#include "functionsummaries.h"
 #include "library.h"
 #include "settings.h"
 #include "testsuite.h"
@@ -27,6 +28,7 @@
 #include <tinyxml2.h>
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -103,6 +105,7 @@ private:
         TEST_CASE(functioncall);
         TEST_CASE(functioncalllibrary); // use Library to parse function call
         TEST_CASE(functioncallDefaultArguments);
+        TEST_CASE(functioncallSummary); // function of another TU
         TEST_CASE(nullpointer_internal_error); // #5080
         TEST_CASE(ticket6505);
         TEST_CASE(subtract);
@@ -219,6 +222,29 @@ private:
               "}");
         ASSERT_EQUALS("", errout.str());
 
+        // the loop can end because the pointer is null and the code after it doesn't leave the loop
+        check("void foo(int x)\n"
+              "{\n"
+              "    for (const Token *tok = tokens; tok; tok = tok->next())\n"
+              "    {\n"
+              "        while (tok && tok->str() != \";\")\n"
+              "            tok = tok->next();\n"
+              "        if (x) break;\n"
+              "    }\n"
+              "}");
+        ASSERT_EQUALS("[test.cpp:5] -> [test.cpp:3]: (warning) Either the condition 'while' is redundant or there is possible null pointer dereference: tok.\n", errout.str());
+
+        check("void foo()\n"
+              "{\n"
+              "    for (const Token *tok = tokens; tok; tok = tok->next())\n"
+              "    {\n"
+              "        while (tok && tok->str() != \";\")\n"
+              "            tok = tok->next();\n"
+              "        tok = last;\n"
+              "    }\n"
+              "}");
+        ASSERT_EQUALS("", errout.str());
+
         check("void foo()\n"
               "{\n"
               "    for (const Token *tok = tokens; tok; tok = tok ? tok->next() : NULL)\n"
@@ -2375,6 +2401,36 @@ private:
         }
     }
 
+    void functioncallSummary() {
+        tinyxml2::XMLDocument doc;
+        doc.Parse("<summaries><function name=\"f\" args=\"2\" notnull=\"2\"/></summaries>");
+        std::shared_ptr<FunctionSummaries> functionSummaries = std::make_shared<FunctionSummaries>();
+        functionSummaries->load(doc.FirstChildElement());
+        settings.functionSummaries = functionSummaries;
+
+        check("void f(int *p, int *q);\n"
+              "void g() {\n"
+              "    f(0, 0);\n"
+              "}");
+        ASSERT_EQUALS("[test.cpp:3]: (error) Null pointer dereference\n", errout.str());
+
+        check("void f(int *p, int *q);\n"
+              "void g(int *q) {\n"
+              "    f(q, q);\n"
+              "    if (!q) {}\n"
+              "}");
+        ASSERT_EQUALS("[test.cpp:4] -> [test.cpp:3]: (warning) Either the condition '!q' is redundant or there is possible null pointer dereference: q.\n", errout.str());
+
+        // the summary is not used for a function that is defined in the TU
+        check("void f(int *p, int *q) { }\n"
+              "void g() {\n"
+              "    f(0, 0);\n"
+              "}");
+        ASSERT_EQUALS("", errout.str());
+
+        settings.functionSummaries.reset();
+    }
+
     void functioncallDefaultArguments() {
 
         check("void f(int *p = 0) {\n"
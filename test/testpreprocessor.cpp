@@ -26,7 +26,9 @@
 #include "testsuite.h"
 
 #include <simplecpp.h>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <list>
 #include <map>
 #include <set>
@@ -246,6 +248,9 @@ private:
         TEST_CASE(testDirectiveIncludeComments);
 
         TEST_CASE(testSameLine);  // #7912
+
+        TEST_CASE(includeCache);
+        TEST_CASE(getIncludes);
     }
 
     void preprocess(const char* code, std::map<std::string, std::string>& actual, const char filename[] = "file.c") {
@@ -2371,6 +2376,50 @@ private:
         ASSERT_EQUALS(exp, preprocessor.getcode(code, "", "test.cpp"));
     }
 
+
+    void includeCache() {
+        // The file system lookups of headers are cached, a header that is
+        // created or removed must be noticed
+        const std::string header("testincludecache.h");
+        std::remove(header.c_str());
+
+        std::vector<std::string> files;
+        std::istringstream istr("#include \"" + header + "\"\n");
+        const simplecpp::TokenList tokens(istr, files, "test.c");
+        simplecpp::DUI dui;
+        dui.includePaths.push_back("missingdir");
+
+        std::map<std::string, simplecpp::TokenList*> filedata = simplecpp::load(tokens, files, dui);
+        ASSERT_EQUALS(0U, filedata.size());
+
+        {
+            std::ofstream fout(header);
+            fout << "int x;\n";
+        }
+        filedata = simplecpp::load(tokens, files, dui);
+        ASSERT_EQUALS(1U, filedata.size());
+        ASSERT(filedata.find(header) != filedata.end());
+        simplecpp::cleanup(filedata);
+
+        std::remove(header.c_str());
+        filedata = simplecpp::load(tokens, files, dui);
+        ASSERT_EQUALS(0U, filedata.size());
+    }
+
+    void getIncludes() {
+        const char code[] = "#include \"sub/a.h\"\n"
+                            "#include <b.h>\n"
+                            "#include MACRO\n"
+                            "#define X 1\n";
+        std::istringstream istr(code);
+        std::vector<std::string> files;
+        const simplecpp::TokenList tokens(istr, files, "src/test.c");
+        const std::list<std::pair<std::string, std::string> > includes = preprocessor0.getIncludes(tokens);
+        ASSERT_EQUALS(2U, includes.size());
+        ASSERT_EQUALS("src/test.c", includes.front().first);
+        ASSERT_EQUALS("\"sub/a.h\"", includes.front().second);
+        ASSERT_EQUALS("<b.h>", includes.back().second);
+    }
 };
 
 REGISTER_TEST(TestPreprocessor)
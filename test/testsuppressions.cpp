@@ -46,6 +46,7 @@ private:
         TEST_CASE(suppressionsSettings);
         TEST_CASE(suppressionsMultiFile);
         TEST_CASE(suppressionsPathSeparator);
+        TEST_CASE(suppressionsIndex);
 
         TEST_CASE(inlinesuppress);
         TEST_CASE(inlinesuppress_symbolname);
@@ -400,6 +401,30 @@ private:
         ASSERT_EQUALS(true, s2.isSuppressed(errorMessage("abc", "include/1.h", 142)));
     }
 
+    void suppressionsIndex() const {
+        Suppressions suppressions;
+        std::istringstream s("*:src\\a.cpp\n"
+                             "id1:src/a.cpp\n"
+                             "id1\n"
+                             "*:src/*.h\n"
+                             "id2:src/b.cpp:2");
+        ASSERT_EQUALS("", suppressions.parseFile(s));
+
+        // the first matching suppression is used, also when it is in another index
+        ASSERT_EQUALS(true, suppressions.isSuppressed(errorMessage("id1", "src/a.cpp", 1)));
+        ASSERT_EQUALS(true, suppressions.isSuppressed(errorMessage("id1", "src/c.cpp", 1)));
+        ASSERT_EQUALS(true, suppressions.isSuppressed(errorMessage("id3", "src/c.h", 1)));
+        ASSERT_EQUALS(false, suppressions.isSuppressed(errorMessage("id3", "src/c.cpp", 1)));
+        ASSERT_EQUALS(false, suppressions.isSuppressedLocal(errorMessage("id3", "src/c.h", 1)));
+        ASSERT_EQUALS(false, suppressions.isSuppressed(errorMessage("id2", "src/b.cpp", 1)));
+
+        const std::list<Suppressions::Suppression> unmatchedA = suppressions.getUnmatchedLocalSuppressions("src/a.cpp", true);
+        ASSERT_EQUALS(1U, unmatchedA.size());
+        ASSERT_EQUALS("id1", unmatchedA.front().errorId);
+        ASSERT_EQUALS(1U, suppressions.getUnmatchedLocalSuppressions("src/b.cpp", true).size());
+        ASSERT_EQUALS(0U, suppressions.getUnmatchedGlobalSuppressions(true).size());
+    }
+
     void inlinesuppress() {
         Suppressions::Suppression s;
         std::string msg;
@@ -378,6 +378,12 @@ private:
         TEST_CASE(using1);
         TEST_CASE(using2); // #8331 (segmentation fault)
         TEST_CASE(using3); // #8343 (segmentation fault)
+
+        TEST_CASE(controlFlowGraphIf);
+        TEST_CASE(controlFlowGraphLoops);
+        TEST_CASE(controlFlowGraphSwitch);
+        TEST_CASE(controlFlowGraphGoto);
+        TEST_CASE(controlFlowGraphTry);
     }
 
     void array() {
@@ -6629,6 +6635,123 @@ private:
         ASSERT(db != nullptr);
         ASSERT_EQUALS("", errout.str());
     }
+
+    std::string controlFlowGraph(const char code[]) {
+        GET_SYMBOL_DB(code);
+        if (!db || db->functionScopes.empty())
+            return "";
+        const ControlFlowGraph *cfg = db->getControlFlowGraph(db->functionScopes[0]);
+        ASSERT(cfg == db->getControlFlowGraph(db->functionScopes[0]));
+        return cfg->str() + (cfg->hasUnknownFlow() ? "unknown flow\n" : "");
+    }
+
+    void controlFlowGraphIf() {
+        ASSERT_EQUALS("0: -> 2\n"
+                      "1:\n"
+                      "2: x = 1 ; -> 3\n"
+                      "3: x -> 4 6\n"
+                      "4: x = 2 ; -> 5\n"
+                      "5: return x ; -> 1\n"
+                      "6: x = 3 ; -> 5\n"
+                      "7: -> 1\n",
+                      controlFlowGraph("int f(int x) {\n"
+                                       "    x = 1;\n"
+                                       "    if (x) { x = 2; } else x = 3;\n"
+                                       "    return x;\n"
+                                       "}"));
+    }
+
+    void controlFlowGraphLoops() {
+        ASSERT_EQUALS("0: -> 2\n"
+                      "1:\n"
+                      "2: int i = 0 -> 3\n"
+                      "3: i < 10 -> 5 6\n"
+                      "4: i ++ -> 3\n"
+                      "5: -> 7\n"
+                      "6: return ; -> 1\n"
+                      "7: i == 3 -> 8 10\n"
+                      "8: -> 6\n"
+                      "9: -> 10\n"
+                      "10: g ( i ) ; -> 4\n"
+                      "11: -> 1\n",
+                      controlFlowGraph("void f() {\n"
+                                       "    for (int i = 0; i < 10; i++) {\n"
+                                       "        if (i == 3) break;\n"
+                                       "        g(i);\n"
+                                       "    }\n"
+                                       "    return;\n"
+                                       "}"));
+
+        ASSERT_EQUALS("0: -> 2\n"
+                      "1:\n"
+                      "2: -> 3\n"
+                      "3: x -- ; -> 4\n"
+                      "4: x -> 3 5\n"
+                      "5: -> 1\n",
+                      controlFlowGraph("void f(int x) {\n"
+                                       "    do { x--; } while (x);\n"
+                                       "}"));
+    }
+
+    void controlFlowGraphSwitch() {
+        ASSERT_EQUALS("0: -> 2\n"
+                      "1:\n"
+                      "2: -> 3\n"
+                      "3: x -> 6 8 4\n"
+                      "4: -> 1\n"
+                      "5: -> 6\n"
+                      "6: x = 1 ; -> 4\n"
+                      "7: -> 8\n"
+                      "8: x = 2 ; -> 4\n",
+                      controlFlowGraph("void f(int x) {\n"
+                                       "    switch (x) {\n"
+                                       "    case 1: x = 1; break;\n"
+                                       "    case 2: x = 2;\n"
+                                       "    }\n"
+                                       "}"));
+    }
+
+    void controlFlowGraphGoto() {
+        ASSERT_EQUALS("0: -> 2\n"
+                      "1:\n"
+                      "2: -> 3\n"
+                      "3: x -> 4 6\n"
+                      "4: -> 7\n"
+                      "5: -> 6\n"
+                      "6: -> 7\n"
+                      "7: return 0 ; -> 1\n"
+                      "8: -> 1\n",
+                      controlFlowGraph("int f(int x) {\n"
+                                       "    if (x) goto out;\n"
+                                       "out:\n"
+                                       "    return 0;\n"
+                                       "}"));
+
+        ASSERT_EQUALS("0: -> 2\n"
+                      "1:\n"
+                      "2:\n"
+                      "3: -> 1\n"
+                      "unknown flow\n",
+                      controlFlowGraph("void f() {\n"
+                                       "    goto out;\n"
+                                       "}"));
+    }
+
+    void controlFlowGraphTry() {
+        // the handler is reached with the state before the try block
+        ASSERT_EQUALS("0: -> 2\n"
+                      "1:\n"
+                      "2: int x ; -> 3 5\n"
+                      "3: x = g ( ) ; -> 4 5\n"
+                      "4: -> 1\n"
+                      "5: h ( x ) ; -> 4\n",
+                      controlFlowGraph("void f() {\n"
+                                       "    int x;\n"
+                                       "    try { x = g(); }\n"
+                                       "    catch (...) { h(x); }\n"
+                                       "}"));
+    }
+
 };
 
 REGISTER_TEST(TestSymbolDatabase)
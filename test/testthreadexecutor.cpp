@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "checkunusedfunctions.h"
 #include "settings.h"
 #include "testsuite.h"
 #include "threadexecutor.h"
@@ -71,6 +72,7 @@ private:
         TEST_CASE(no_errors_equal_amount_files);
         TEST_CASE(one_error_less_files);
         TEST_CASE(one_error_several_files);
+        TEST_CASE(unused_function);
     }
 
     void deadlock_with_many_errors() {
@@ -135,6 +137,27 @@ private:
               "  return 0;\n"
               "}");
     }
+
+    void unused_function() {
+        CheckUnusedFunctions::clear();
+        settings.addEnabled("unusedFunction");
+        check(2, 3, 0,
+              "void f() {}\n"
+              "void g() {}\n"
+              "int main()\n"
+              "{\n"
+              "  g();\n"
+              "  return 0;\n"
+              "}");
+        settings.clearEnabled();
+        if (!ThreadExecutor::isEnabled())
+            return;
+
+        // The declarations and calls of the files are merged in the main process
+        CheckUnusedFunctions::instance.check(this, settings);
+        ASSERT_EQUALS("[file_1.cpp:1]: (style) The function 'f' is never used.\n", errout.str());
+        CheckUnusedFunctions::clear();
+    }
 };
 
 REGISTER_TEST(TestThreadExecutor)
@@ -17,11 +17,15 @@
  */
 
 #include "checkuninitvar.h"
+#include "functionsummaries.h"
 #include "library.h"
 #include "settings.h"
+#include "symboldatabase.h"
 #include "testsuite.h"
 #include "tokenize.h"
 
+#include <tinyxml2.h>
+#include <memory>
 #include <sstream>
 #include <string>
 
@@ -49,6 +53,7 @@ private:
         TEST_CASE(uninitvar_if);        // handling if
         TEST_CASE(uninitvar_loops);     // handling for/while
         TEST_CASE(uninitvar_switch);    // handling switch
+        TEST_CASE(uninitvar_dataflow);  // variables assigned before use on every path
         TEST_CASE(uninitvar_references); // references
         TEST_CASE(uninitvar_return);    // return
         TEST_CASE(uninitvar_assign);    // = {..}
@@ -70,6 +75,7 @@ private:
         TEST_CASE(uninitvar9); // ticket #6424
         TEST_CASE(uninitvar_unconditionalTry);
         TEST_CASE(uninitvar_funcptr); // #6404
+        TEST_CASE(uninitvar_functionSummary); // function of another TU
         TEST_CASE(uninitvar_operator); // #6680
         TEST_CASE(uninitvar_ternaryexpression); // #4683
         TEST_CASE(uninitvar_pointertoarray);
@@ -1188,7 +1194,7 @@ private:
                        "        break;\n"
                        "    };\n"
                        "}");
-        TODO_ASSERT_EQUALS("[test.cpp:6]: (error) Uninitialized variable: c\n", "", errout.str());
+        ASSERT_EQUALS("[test.cpp:6]: (error) Uninitialized variable: c\n", errout.str());
 
         checkUninitVar("char * f()\n"
                        "{\n"
@@ -1253,6 +1259,100 @@ private:
         ASSERT_EQUALS("", errout.str());
     }
 
+    // names of the variables that are handled by the assignment dataflow
+    std::string assignmentDataflow(const char code[]) {
+        // Clear the error buffer..
+        errout.str("");
+
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr(code);
+        tokenizer.tokenize(istr, "test.cpp");
+        tokenizer.simplifyTokenList2();
+
+        CheckUninitVar checkuninitvar(&tokenizer, &settings, this);
+        std::string ret;
+        const SymbolDatabase *symbolDatabase = tokenizer.getSymbolDatabase();
+        for (std::size_t varid = 1; varid < symbolDatabase->variableList().size(); ++varid) {
+            const Variable *var = symbolDatabase->getVariableFromVarId(varid);
+            if (var && checkuninitvar.checkAssignmentDataflow(*var))
+                ret += (ret.empty() ? "" : " ") + var->name();
+        }
+        return ret;
+    }
+
+    void uninitvar_dataflow() {
+        ASSERT_EQUALS("a b c", assignmentDataflow("int f(int x) {\n"
+                                                  "    int a, b, c, d;\n"
+                                                  "    a = g();\n"
+                                                  "    if (x) { b = 1; c = 2; }\n"
+                                                  "    else { b = 2; d = 3; }\n"
+                                                  "    if (x) { c = 1; }\n"
+                                                  "    else { c = 2; }\n"
+                                                  "    return a + b + c + d;\n"
+                                                  "}"));
+        ASSERT_EQUALS("", errout.str());
+
+        // assignment takes effect after the statement
+        ASSERT_EQUALS("a", assignmentDataflow("int f() {\n"
+                                              "    int a;\n"
+                                              "    a = a + 1;\n"
+                                              "    return a;\n"
+                                              "}"));
+        ASSERT_EQUALS("[test.cpp:3]: (error) Uninitialized variable: a\n", errout.str());
+
+        // not assigned on any path
+        ASSERT_EQUALS("a b", assignmentDataflow("int f(int x) {\n"
+                                                "    int a, b;\n"
+                                                "    if (x) { a = 1; }\n"
+                                                "    else { a = b; }\n"
+                                                "    while (x--) { a += b; }\n"
+                                                "    return a;\n"
+                                                "}"));
+        ASSERT_EQUALS("[test.cpp:4]: (error) Uninitialized variable: b\n"
+                      "[test.cpp:5]: (error) Uninitialized variable: b\n", errout.str());
+
+        // loops
+        ASSERT_EQUALS("i", assignmentDataflow("void f(int n) {\n"
+                                              "    int i, x;\n"
+                                              "    for (i = 0; i < n; i++)\n"
+                                              "        x = i;\n"
+                                              "    g(x);\n"
+                                              "}"));
+        ASSERT_EQUALS("", errout.str());
+
+        // the address is taken
+        ASSERT_EQUALS("", assignmentDataflow("void f() {\n"
+                                             "    int a;\n"
+                                             "    g(&a);\n"
+                                             "    h(a);\n"
+                                             "}"));
+
+        // an exception can be thrown before the assignment in the try block
+        ASSERT_EQUALS("y", assignmentDataflow("int f() {\n"
+                                              "    int x, y;\n"
+                                              "    y = 0;\n"
+                                              "    try { x = g(); }\n"
+                                              "    catch (...) { return x + y; }\n"
+                                              "    return x;\n"
+                                              "}"));
+        checkUninitVar("int f() {\n"
+                       "    int x;\n"
+                       "    try { x = g(); }\n"
+                       "    catch (...) { return x; }\n"
+                       "    return x;\n"
+                       "}");
+        TODO_ASSERT_EQUALS("[test.cpp:4]: (error) Uninitialized variable: x\n", "", errout.str());
+
+        // diagnostics for the variables that are not handled by the dataflow
+        checkUninitVar("int f(int x) {\n"
+                       "    int a, b;\n"
+                       "    a = 0;\n"
+                       "    if (x) { b = 1; }\n"
+                       "    return a + b;\n"
+                       "}");
+        ASSERT_EQUALS("[test.cpp:5]: (error) Uninitialized variable: b\n", errout.str());
+    }
+
     // arrays..
     void uninitvar_arrays() {
         checkUninitVar("int f()\n"
@@ -2683,6 +2783,38 @@ private:
         ASSERT_EQUALS("[test.cpp:3]: (error) Uninitialized variable: Factory\n", errout.str());
     }
 
+    void uninitvar_functionSummary() {
+        tinyxml2::XMLDocument doc;
+        doc.Parse("<summaries><function name=\"f\" args=\"2\" notuninit=\"1\"/></summaries>");
+        std::shared_ptr<FunctionSummaries> functionSummaries = std::make_shared<FunctionSummaries>();
+        functionSummaries->load(doc.FirstChildElement());
+        settings.functionSummaries = functionSummaries;
+
+        checkUninitVar("void f(int *p, int *q);\n"
+                       "void g() {\n"
+                       "    int x;\n"
+                       "    f(&x, 0);\n"
+                       "}");
+        ASSERT_EQUALS("[test.cpp:4]: (error) Uninitialized variable: x\n", errout.str());
+
+        checkUninitVar("void f(int *p, int *q);\n"
+                       "void g() {\n"
+                       "    int x;\n"
+                       "    f(0, &x);\n"
+                       "    return x;\n"
+                       "}");
+        ASSERT_EQUALS("", errout.str());
+
+        checkUninitVar("void f(int *p, int *q);\n"
+                       "void g() {\n"
+                       "    int a[10];\n"
+                       "    f(a, 0);\n"
+                       "}");
+        ASSERT_EQUALS("[test.cpp:4]: (error) Uninitialized variable: a\n", errout.str());
+
+        settings.functionSummaries.reset();
+    }
+
     void uninitvar_operator() { // Ticket #6463, #6680
         checkUninitVar("struct Source { Source& operator>>(int& i) { i = 0; return *this; } };\n"
                        "struct Sink { int v; };\n"
@@ -24,6 +24,7 @@
 
 #include <ostream>
 #include <string>
+#include <vector>
 
 class TestUnusedFunctions : public TestFixture {
 public:
@@ -57,6 +58,7 @@ private:
         TEST_CASE(boost);
 
         TEST_CASE(multipleFiles);   // same function name in multiple files
+        TEST_CASE(summary);         // the summary of a file gives the same results as its tokens
 
         TEST_CASE(lineNumber); // Ticket 3059
 
@@ -375,6 +377,53 @@ private:
         ASSERT_EQUALS("[test1.cpp:1]: (style) The function 'f' is never used.\n", errout.str());
     }
 
+    // Check the files with parseTokens() and then with their summaries
+    void checkSummary(const char code1[], const char code2[]) {
+        errout.str("");
+        CheckUnusedFunctions::clear();
+        std::vector<std::string> summaries;
+        int i = 0;
+        for (const char *code : { code1, code2 }) {
+            std::ostringstream fname;
+            fname << "test" << ++i << ".cpp";
+
+            Tokenizer tokenizer(&settings, this);
+            std::istringstream istr(code);
+            tokenizer.tokenize(istr, fname.str().c_str());
+
+            CheckUnusedFunctions c;
+            c.parseTokens(tokenizer, fname.str().c_str(), &settings);
+            summaries.push_back(c.summary());
+            CheckUnusedFunctions::instance.parseTokens(tokenizer, fname.str().c_str(), &settings);
+        }
+        CheckUnusedFunctions::instance.check(this, settings);
+        const std::string expected = errout.str();
+
+        errout.str("");
+        CheckUnusedFunctions::clear();
+        for (std::vector<std::string>::const_iterator it = summaries.begin(); it != summaries.end(); ++it)
+            CheckUnusedFunctions::instance.addSummary(*it);
+        CheckUnusedFunctions::instance.check(this, settings);
+        ASSERT_EQUALS(expected, errout.str());
+        CheckUnusedFunctions::clear();
+    }
+
+    void summary() {
+        checkSummary("void f() { }\n"
+                     "static void g() { }\n"
+                     "void h() { g(); }",
+                     "void i() { }\n"
+                     "static void g() { }\n"
+                     "int main() { h(); }");
+        ASSERT_EQUALS("[test1.cpp:1]: (style) The function 'f' is never used.\n"
+                      "[test2.cpp:1]: (style) The function 'i' is never used.\n", errout.str());
+
+        // a function that is called in another file
+        checkSummary("void f() { }",
+                     "void g() { f(); }");
+        ASSERT_EQUALS("[test2.cpp:1]: (style) The function 'g' is never used.\n", errout.str());
+    }
+
     void lineNumber() {
         check("void foo() {}\n"
               "void bar() {}\n"
@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "functionsummaries.h"
 #include "library.h"
 #include "platform.h"
 #include "settings.h"
@@ -25,9 +26,11 @@
 #include "valueflow.h"
 
 #include <simplecpp.h>
+#include <tinyxml2.h>
 #include <cmath>
 #include <list>
 #include <map>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -2621,6 +2624,20 @@ private:
                "};";
         ASSERT_EQUALS(7, valueOfTok(code, "-").intvalue);
         ASSERT_EQUALS(false, valueOfTok(code, "-").isKnown());
+
+        // function that is defined in another TU
+        code = "int one();\n"
+               "void f() { x = 1 * one(); }";
+        ASSERT_EQUALS(false, valueOfTok(code, "*").isKnown());
+
+        tinyxml2::XMLDocument doc;
+        doc.Parse("<summaries><function name=\"one\" args=\"0\" returnValue=\"1\"/></summaries>");
+        std::shared_ptr<FunctionSummaries> functionSummaries = std::make_shared<FunctionSummaries>();
+        functionSummaries->load(doc.FirstChildElement());
+        settings.functionSummaries = functionSummaries;
+        ASSERT_EQUALS(1, valueOfTok(code, "*").intvalue);
+        ASSERT_EQUALS(true, valueOfTok(code, "*").isKnown());
+        settings.functionSummaries.reset();
     }
 
     void valueFlowFunctionDefaultParameter() {
@@ -0,0 +1,47 @@
+#!/usr/bin/env python
+#
+# Generate many files that each give many warnings and measure how long
+# cppcheck needs to check them with -j. Each warning is sent from the
+# child process that checks the file to the main process, so this shows
+# the cost of that.
+#
+# Usage: bench-ipc.py [--files N] [--errors N] [-j N] [--cppcheck path]
+
+import argparse
+import os
+import shutil
+import subprocess
+import tempfile
+import time
+
+
+def generate(errors):
+    out = []
+    for i in range(errors):
+        out.append('void f%d() { char a[10]; a[10] = 0; }' % i)
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--files', type=int, default=64)
+    parser.add_argument('--errors', type=int, default=2000)
+    parser.add_argument('-j', type=int, default=4)
+    parser.add_argument('--cppcheck', default='./cppcheck')
+    args = parser.parse_args()
+
+    path = tempfile.mkdtemp()
+    code = generate(args.errors)
+    for i in range(args.files):
+        with open(os.path.join(path, 'file%d.c' % i), 'w') as f:
+            f.write(code)
+
+    with open(os.devnull, 'w') as devnull:
+        start = time.time()
+        subprocess.call([args.cppcheck, '-q', '-j%d' % args.j, path], stderr=devnull)
+        print('Total time: %.2fs' % (time.time() - start))
+    shutil.rmtree(path)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,59 @@
+#!/usr/bin/env python
+#
+# Generate code with many allocated variables and many (nested) branches
+# and measure how long cppcheck needs to check it. The leakautovar
+# checker copies its state at each branch, so this shows the cost of that.
+#
+# Usage: bench-leakautovar.py [--vars N] [--branches N] [--depth N] [--cppcheck path]
+
+import argparse
+import os
+import subprocess
+import tempfile
+import time
+
+
+def branch(out, depth, index, indent):
+    var = 'p%d' % index
+    out.append('%sif (c[%d]) {' % (indent, index))
+    if depth > 1:
+        branch(out, depth - 1, index + 1, indent + '    ')
+    else:
+        out.append('%s    use(%s);' % (indent, var))
+    out.append('%s} else {' % indent)
+    out.append('%s    x++;' % indent)
+    out.append('%s}' % indent)
+
+
+def generate(numvars, branches, depth):
+    out = ['void use(char *);', 'void f(const int *c) {', '    int x = 0;']
+    for i in range(numvars):
+        out.append('    char *p%d = malloc(10);' % i)
+    for i in range(branches):
+        branch(out, depth, i % numvars, '    ')
+    for i in range(numvars):
+        out.append('    free(p%d);' % i)
+    out.append('}')
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--vars', type=int, default=300)
+    parser.add_argument('--branches', type=int, default=3000)
+    parser.add_argument('--depth', type=int, default=4)
+    parser.add_argument('--cppcheck', default='./cppcheck')
+    args = parser.parse_args()
+
+    fd, filename = tempfile.mkstemp(suffix='.c')
+    with os.fdopen(fd, 'w') as f:
+        f.write(generate(args.vars, args.branches, args.depth))
+
+    start = time.time()
+    subprocess.call([args.cppcheck, '-q', '--showtime=summary', filename])
+    print('Total time: %.2fs' % (time.time() - start))
+    os.remove(filename)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,149 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2018 Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Measure how fast simplecpp reads source files. A large source file is
+// generated (or the given files are used) and it is read from a std::istream,
+// from the file (memory mapped) and from memory.
+//
+// Usage: bench-simplecpp [--size MB] [--runs N] [file ...]
+
+#include "simplecpp.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::string generate(std::size_t size)
+{
+    std::ostringstream code;
+    code << "#include <stdio.h>\n"
+         << "#define MAX(a, b) ((a) > (b) ? (a) : (b))\n\n";
+    for (unsigned int i = 0; code.tellp() < static_cast<std::streamoff>(size); ++i) {
+        code << "/*\n"
+             << " * Function " << i << " computes a value from the given arguments.\n"
+             << " * It is generated to have comments, strings and numbers.\n"
+             << " */\n"
+             << "static int function_" << i << "(const char *name, int count, double factor)\n"
+             << "{\n"
+             << "    int result = 0x" << std::hex << (i * 2654435761U) << std::dec << ";\n"
+             << "    // loop over all items\n"
+             << "    for (int index = 0; index < count; ++index) {\n"
+             << "        result += MAX(index * " << i << ", count) / 3;\n"
+             << "        if (name[index] == '\\n')\n"
+             << "            printf(\"line %d in %s: \\\"%f\\\"\\n\", index, name, factor * 1.5e3);\n"
+             << "    }\n"
+             << "    return result;\n"
+             << "}\n\n";
+    }
+    return code.str();
+}
+
+static std::size_t countTokens(const simplecpp::TokenList &tokens)
+{
+    std::size_t n = 0;
+    for (const simplecpp::Token *tok = tokens.cfront(); tok; tok = tok->next)
+        ++n;
+    return n;
+}
+
+enum Method { FROM_ISTREAM, FROM_FILE, FROM_MEMORY };
+
+static double measure(Method method, const std::vector<std::string> &filenames, const std::vector<std::string> &contents, unsigned int runs, std::size_t *tokens)
+{
+    double best = 0;
+    for (unsigned int run = 0; run < runs; ++run) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        *tokens = 0;
+        for (std::size_t i = 0; i < filenames.size(); ++i) {
+            std::vector<std::string> files;
+            if (method == FROM_ISTREAM) {
+                std::ifstream fin(filenames[i].c_str());
+                const simplecpp::TokenList tokenList(fin, files, filenames[i]);
+                *tokens += countTokens(tokenList);
+            } else if (method == FROM_FILE) {
+                const simplecpp::TokenList tokenList(filenames[i], files);
+                *tokens += countTokens(tokenList);
+            } else {
+                const simplecpp::TokenList tokenList(reinterpret_cast<const unsigned char *>(contents[i].data()), contents[i].size(), files, filenames[i]);
+                *tokens += countTokens(tokenList);
+            }
+        }
+        const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || t < best)
+            best = t;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t size = 32;
+    unsigned int runs = 5;
+    std::vector<std::string> filenames;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            size = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+            runs = std::atoi(argv[++i]);
+        else if (argv[i][0] == '-') {
+            std::cout << "Usage: bench-simplecpp [--size MB] [--runs N] [file ...]" << std::endl;
+            return EXIT_FAILURE;
+        } else
+            filenames.push_back(argv[i]);
+    }
+
+    const bool generated = filenames.empty();
+    if (generated) {
+        filenames.push_back("bench-simplecpp.c");
+        std::ofstream fout(filenames[0].c_str());
+        fout << generate(size * 1024 * 1024);
+    }
+
+    std::vector<std::string> contents;
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < filenames.size(); ++i) {
+        std::ifstream fin(filenames[i].c_str());
+        std::ostringstream ostr;
+        ostr << fin.rdbuf();
+        contents.push_back(ostr.str());
+        bytes += contents.back().size();
+    }
+
+    // warm up the file cache and the heap
+    std::size_t tokens = 0;
+    measure(FROM_FILE, filenames, contents, 1, &tokens);
+
+    const char * const names[] = { "istream", "file", "memory" };
+    for (int method = FROM_ISTREAM; method <= FROM_MEMORY; ++method) {
+        const double t = measure(static_cast<Method>(method), filenames, contents, runs, &tokens);
+        std::cout << names[method] << ": " << t << "s, "
+                  << (bytes / t / (1024 * 1024)) << " MB/s, "
+                  << tokens << " tokens" << std::endl;
+    }
+
+    if (generated)
+        std::remove(filenames[0].c_str());
+
+    return EXIT_SUCCESS;
+}